@@ -0,0 +1,79 @@
+#!/bin/bash
+
+# 事件后端对比：统计每个请求的系统调用次数 (epoll vs io_uring 就绪模式 vs io_uring 完成模式)
+# 用法: ./bench_backends.sh [io_threads] [worker_threads]
+# 需要 strace（或 perf）以及已构建的 reactor_server / test_client
+
+IO_THREADS=${1:-4}
+WORKER_THREADS=${2:-8}
+# "+completion" 表示同一后端加 --completion（多发 accept/recv + 缓冲环）
+BACKENDS="epoll io_uring io_uring+completion"
+
+# 从 test_client 的 JSON 输出中取第一个同名数值字段
+json_field() {
+    echo "$1" | sed -n "s/.*\"$2\": \([0-9.]*\).*/\1/p" | head -1
+}
+
+if [ ! -x ./reactor_server ] || [ ! -x ./test_client ]; then
+    echo "Build first: make all-tests"
+    exit 1
+fi
+
+if command -v strace &> /dev/null; then
+    TRACER=strace
+elif command -v perf &> /dev/null; then
+    TRACER=perf
+else
+    echo "strace or perf is required to count syscalls"
+    exit 1
+fi
+
+echo "=== Event backend syscall comparison (tracer: $TRACER) ==="
+printf "%-20s %10s %12s %14s %10s\n" "backend" "requests" "syscalls" "syscalls/req" "rps"
+
+for backend in $BACKENDS; do
+    extra=""
+    case "$backend" in
+        *+completion) extra="--completion" ;;
+    esac
+    ./reactor_server -i $IO_THREADS -w $WORKER_THREADS -e ${backend%%+*} $extra > server_$backend.log 2>&1 &
+    server_pid=$!
+    sleep 1
+
+    if ! kill -0 $server_pid 2>/dev/null; then
+        echo "$backend: server failed to start (see server_$backend.log)"
+        continue
+    fi
+
+    trace_out=trace_$backend.log
+    if [ "$TRACER" = "strace" ]; then
+        strace -c -f -q -p $server_pid -o $trace_out &
+    else
+        perf stat -e raw_syscalls:sys_enter -p $server_pid -o $trace_out &
+    fi
+    tracer_pid=$!
+    sleep 1
+
+    result=$(./test_client -d 5 2>/dev/null)
+
+    kill -INT $tracer_pid 2>/dev/null
+    wait $tracer_pid 2>/dev/null
+    kill $server_pid 2>/dev/null
+    wait $server_pid 2>/dev/null
+
+    requests=$(json_field "$result" requests)
+    rps=$(json_field "$result" rps)
+    if [ "$TRACER" = "strace" ]; then
+        syscalls=$(awk '$NF == "total" {print $4}' $trace_out)
+    else
+        syscalls=$(awk '/raw_syscalls:sys_enter/ {gsub(",", "", $1); print $1}' $trace_out)
+    fi
+
+    per_req=$(awk -v s="${syscalls:-0}" -v r="${requests:-0}" 'BEGIN { if (r > 0) printf "%.2f", s / r; else print "n/a" }')
+    printf "%-20s %10s %12s %14s %10s\n" "$backend" "${requests:-0}" "${syscalls:-0}" "$per_req" "${rps:-0}"
+
+    sleep 1
+done
+
+echo ""
+echo "Per-syscall breakdown is in trace_<backend>.log"
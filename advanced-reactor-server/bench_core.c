@@ -0,0 +1,637 @@
+// bench_core.c
+// 核心原语微基准：每个用例在不同线程数下运行，结果以 JSON 输出到 stdout（每个结果一行）
+//
+//   task_queue/<kind>     threads 个生产者 + threads 个消费者经同一个队列传递任务
+//   task/create_destroy   task_create + task_destroy（线程局部对象池，带连接引用和数据切片）
+//   conn_ref/shared       所有线程对同一个连接 conn_acquire + conn_release（引用计数争用）
+//   conn_ref/private      每个线程对自己的连接 conn_acquire + conn_release
+//   io_msg/roundtrip      各线程向同一个 IO 线程 io_thread_send_message，等它处理完再发下一条
+//   io_msg/batch          各线程一次发 IO_MSG_BATCH 条再等处理完（邮箱吞吐，唤醒被合并）
+//   event_loop/<backend>/add_del     event_loop_add + event_loop_del
+//   event_loop/<backend>/mod         event_loop_mod（在只读和读写之间切换）
+//   event_loop/<backend>/wait_ready  通知一个描述符 + event_loop_wait 取回事件 + 读空
+//   event_loop/<backend>/wait_idle   没有就绪描述符时 event_loop_wait（零超时）
+//
+// ops 为一轮所有线程合计的操作数；ns_per_op = 墙钟时间 * threads / ops（单个线程平均每次
+// 操作的耗时，线程数超过 CPU 数时包含等待 CPU 的时间），ops_per_sec 为合计吞吐。
+// 事件循环用例每个线程使用自己的事件循环，每 EVENT_FDS 次注册操作调用一次零超时的 wait
+// （io_uring 后端在 wait 时才提交注册请求），这部分开销计入每次操作。
+#include "common.h"
+#include "task_queue.h"
+#include "io_thread.h"
+#include "event_loop.h"
+#include "object_pool.h"
+#include "buffer.h"
+
+#include <getopt.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#define DEFAULT_OPS     1000000
+#define DEFAULT_THREADS "1,2,4,8"
+#define MAX_THREAD_COUNTS 16
+
+#define QUEUE_SIZE   1024
+#define IO_MSG_BATCH 64
+#define EVENT_FDS    32
+
+// 等待 IO 线程处理消息时，自旋多少次后让出 CPU
+#define SPIN_LIMIT 100
+
+// 起跑门：所有线程到齐后同时放行（macOS 没有 pthread_barrier_t）
+typedef struct start_gate {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int ready;                  // 已到达的线程数
+    int count;                  // 到齐的线程数，-1 表示有线程没能创建、本轮取消
+} start_gate_t;
+
+typedef struct bench_thread {
+    pthread_t tid;
+    int index;
+    long ops;                   // 本线程的操作数
+    void *shared;               // 用例的共享状态
+    start_gate_t *gate;
+    long start_ns;
+    long end_ns;
+} bench_thread_t;
+
+typedef struct bench_case {
+    const char *name;
+    int divisor;                // 本用例每轮的操作数为 ops / divisor
+    long (*run)(const struct bench_case *bc, int threads, long ops);
+    void *arg;
+} bench_case_t;
+
+static const char *default_backend;
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// 线程完成准备工作后调用，所有线程同时开始计时
+// 起点由各线程在放行之后自己记录，主线程何时被调度不影响计时。
+// 本轮取消时返回 -1 并把 ops 置 0，按 ops 循环的用例不必另外检查
+static int bench_start(bench_thread_t *t) {
+    start_gate_t *gate = t->gate;
+    
+    pthread_mutex_lock(&gate->lock);
+    if (++gate->ready == gate->count) {
+        pthread_cond_broadcast(&gate->cond);
+    }
+    while (gate->count > 0 && gate->ready < gate->count) {
+        pthread_cond_wait(&gate->cond, &gate->lock);
+    }
+    int canceled = gate->count < 0;
+    pthread_mutex_unlock(&gate->lock);
+    
+    if (canceled) {
+        t->ops = 0;
+        return -1;
+    }
+    t->start_ns = now_ns();
+    return 0;
+}
+
+static void bench_end(bench_thread_t *t) {
+    t->end_ns = now_ns();
+}
+
+// 启动 count 个线程执行 fn，每个线程 ops / count 次操作；
+// 返回从最早开始的线程到最后完成的线程之间的纳秒数，失败返回 -1
+static long run_threads(int count, void *(*fn)(void*), long ops, void *shared) {
+    bench_thread_t *threads = calloc(count, sizeof(bench_thread_t));
+    if (!threads) return -1;
+    
+    start_gate_t gate = { .ready = 0, .count = count };
+    pthread_mutex_init(&gate.lock, NULL);
+    pthread_cond_init(&gate.cond, NULL);
+    
+    int started = 0;
+    for (; started < count; started++) {
+        bench_thread_t *t = &threads[started];
+        t->index = started;
+        t->ops = ops / count;
+        t->shared = shared;
+        t->gate = &gate;
+        if (pthread_create(&t->tid, NULL, fn, t) != 0) {
+            fprintf(stderr, "failed to create thread %d of %d\n", started + 1, count);
+            break;
+        }
+    }
+    
+    // 没能全部创建：放行已启动的线程，让它们跳过计时部分直接退出
+    if (started < count) {
+        pthread_mutex_lock(&gate.lock);
+        gate.count = -1;
+        pthread_cond_broadcast(&gate.cond);
+        pthread_mutex_unlock(&gate.lock);
+    }
+    
+    long start = 0;
+    long end = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i].tid, NULL);
+        if (i == 0 || threads[i].start_ns < start) start = threads[i].start_ns;
+        if (i == 0 || threads[i].end_ns > end) end = threads[i].end_ns;
+    }
+    
+    pthread_cond_destroy(&gate.cond);
+    pthread_mutex_destroy(&gate.lock);
+    free(threads);
+    return started < count ? -1 : end - start;
+}
+
+// 调用线程自己的连接对象（不对应真实的套接字）
+static connection_t* bench_conn_create(object_pool_t **pool) {
+    *pool = object_pool_create("bench_conn", sizeof(connection_t));
+    if (!*pool) return NULL;
+    object_pool_bind(*pool);
+    return conn_create(-1, NULL, NULL, NULL, *pool);
+}
+
+static void bench_conn_destroy(connection_t *conn, object_pool_t *pool) {
+    conn_release(conn);
+    object_pool_destroy(pool);
+}
+
+// ---- task_queue ----
+
+typedef struct queue_shared {
+    task_queue_t *queue;
+    int producers;
+    long per_producer;
+    task_t *tasks;
+    task_t *sentinels;          // 每个生产者一个：互斥队列是侵入式链表，同一节点不能重复入队
+} queue_shared_t;
+
+// 前 producers 个线程入队，其余线程出队；每个生产者最后放一个哨兵，每个消费者取到一个哨兵后退出
+static void* queue_main(void *arg) {
+    bench_thread_t *t = arg;
+    queue_shared_t *s = t->shared;
+    
+    // 本轮取消时部分生产者或消费者不存在，不能入队或等待哨兵
+    if (bench_start(t) != 0) return NULL;
+    
+    if (t->index < s->producers) {
+        task_t *tasks = s->tasks + t->index * s->per_producer;
+        for (long i = 0; i < s->per_producer; i++) {
+            task_queue_push(s->queue, &tasks[i]);
+        }
+        task_queue_push(s->queue, &s->sentinels[t->index]);
+    } else {
+        task_t *task;
+        while (!(task = task_queue_pop(s->queue)) || task < s->sentinels) {
+        }
+    }
+    bench_end(t);
+    return NULL;
+}
+
+static long run_task_queue(const bench_case_t *bc, int threads, long ops) {
+    queue_shared_t s;
+    memset(&s, 0, sizeof(s));
+    s.queue = task_queue_create_kind(QUEUE_SIZE, *(task_queue_kind_t*)bc->arg);
+    s.producers = threads;
+    s.per_producer = ops / threads;
+    s.tasks = calloc(ops + threads, sizeof(task_t));
+    s.sentinels = s.tasks ? s.tasks + ops : NULL;
+    
+    long elapsed = -1;
+    if (s.queue && s.tasks) {
+        elapsed = run_threads(threads * 2, queue_main, ops, &s);
+    }
+    
+    free(s.tasks);
+    task_queue_destroy(s.queue);
+    return elapsed;
+}
+
+// ---- task_create / task_destroy ----
+
+static void* task_main(void *arg) {
+    bench_thread_t *t = arg;
+    object_pool_t *pool;
+    connection_t *conn = bench_conn_create(&pool);
+    buf_t *buf = buf_alloc(4096);
+    buf_slice_t slice = { buf, 0, 128 };
+    
+    // 第一次调用创建线程局部的任务池，不计时
+    task_destroy(task_create(TASK_TYPE_PROCESS, conn, &slice));
+    
+    bench_start(t);
+    for (long i = 0; i < t->ops; i++) {
+        task_t *task = task_create(TASK_TYPE_PROCESS, conn, &slice);
+        task_destroy(task);
+    }
+    bench_end(t);
+    
+    buf_unref(buf);
+    bench_conn_destroy(conn, pool);
+    return NULL;
+}
+
+static long run_task(const bench_case_t *bc, int threads, long ops) {
+    (void)bc;
+    return run_threads(threads, task_main, ops, NULL);
+}
+
+// ---- conn_acquire / conn_release ----
+
+static void* conn_ref_main(void *arg) {
+    bench_thread_t *t = arg;
+    object_pool_t *pool = NULL;
+    connection_t *conn = t->shared;
+    if (!conn) {
+        conn = bench_conn_create(&pool);
+    }
+    
+    bench_start(t);
+    for (long i = 0; i < t->ops; i++) {
+        conn_acquire(conn);
+        conn_release(conn);
+    }
+    bench_end(t);
+    
+    if (pool) {
+        bench_conn_destroy(conn, pool);
+    }
+    return NULL;
+}
+
+static long run_conn_ref(const bench_case_t *bc, int threads, long ops) {
+    object_pool_t *pool = NULL;
+    connection_t *conn = NULL;
+    if (bc->arg) {
+        conn = bench_conn_create(&pool);
+        if (!conn) return -1;
+    }
+    
+    long elapsed = run_threads(threads, conn_ref_main, ops, conn);
+    
+    if (conn) {
+        bench_conn_destroy(conn, pool);
+    }
+    return elapsed;
+}
+
+// ---- io_thread_send_message ----
+
+typedef struct io_msg_shared {
+    io_thread_t *io_thread;
+    int batch;
+} io_msg_shared_t;
+
+// 消息处理完（释放）时归还连接引用：发送方等引用计数回到 1
+static void wait_messages_done(connection_t *conn) {
+    int spins = 0;
+    while (atomic_load_explicit(&conn->ref_count, memory_order_acquire) != 1) {
+        if (++spins >= SPIN_LIMIT) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+static void* io_msg_main(void *arg) {
+    bench_thread_t *t = arg;
+    io_msg_shared_t *s = t->shared;
+    
+    // 已标记关闭的连接：IO 线程收到消息后直接释放，不做其它处理
+    object_pool_t *pool;
+    connection_t *conn = bench_conn_create(&pool);
+    conn_mark_closing(conn);
+    
+    // 预热：创建本线程的消息对象池
+    io_thread_send_message(s->io_thread, IO_MSG_CLOSE_CONN, conn);
+    wait_messages_done(conn);
+    
+    bench_start(t);
+    for (long i = 0; i < t->ops; i += s->batch) {
+        for (long j = 0; j < s->batch && i + j < t->ops; j++) {
+            io_thread_send_message(s->io_thread, IO_MSG_CLOSE_CONN, conn);
+        }
+        wait_messages_done(conn);
+    }
+    bench_end(t);
+    
+    bench_conn_destroy(conn, pool);
+    return NULL;
+}
+
+static long run_io_msg(const bench_case_t *bc, int threads, long ops) {
+    io_thread_config_t config;
+    memset(&config, 0, sizeof(config));
+    io_thread_pool_t *pool = io_thread_pool_create(1, NULL, NULL, &config);
+    if (!pool) return -1;
+    
+    io_msg_shared_t s = { pool->threads[0], *(int*)bc->arg };
+    long elapsed = run_threads(threads, io_msg_main, ops, &s);
+    
+    io_thread_pool_destroy(pool);
+    return elapsed;
+}
+
+// ---- event_loop ----
+
+typedef enum { EV_ADD_DEL, EV_MOD, EV_WAIT_READY, EV_WAIT_IDLE } ev_op_t;
+
+typedef struct ev_case {
+    const char *backend;
+    ev_op_t op;
+} ev_case_t;
+
+// 可通知的描述符：Linux 用 eventfd，其它平台用管道（fds[0] 读端注册到事件循环）
+static int notify_open(int fds[2]) {
+#ifdef __linux__
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd == -1) return -1;
+    fds[0] = fds[1] = fd;
+#else
+    if (pipe(fds) == -1) return -1;
+    set_nonblocking(fds[0]);
+    set_nonblocking(fds[1]);
+#endif
+    return 0;
+}
+
+static void notify_close(int fds[2]) {
+    close(fds[0]);
+    if (fds[1] != fds[0]) {
+        close(fds[1]);
+    }
+}
+
+static void notify_signal(int fds[2]) {
+#ifdef __linux__
+    uint64_t one = 1;
+    write(fds[1], &one, sizeof(one));
+#else
+    char dummy = 1;
+    write(fds[1], &dummy, 1);
+#endif
+}
+
+static void notify_drain(int fds[2]) {
+#ifdef __linux__
+    uint64_t value;
+    read(fds[0], &value, sizeof(value));
+#else
+    char buf[64];
+    while (read(fds[0], buf, sizeof(buf)) > 0) {
+    }
+#endif
+}
+
+static void* event_loop_main(void *arg) {
+    bench_thread_t *t = arg;
+    const ev_case_t *ec = t->shared;
+    event_loop_t *loop = event_loop_create(EVENT_FDS);
+    event_t events[EVENT_FDS];
+    int fds[EVENT_FDS][2];
+    int opened = 0;
+    
+    while (loop && opened < EVENT_FDS && notify_open(fds[opened]) == 0) {
+        opened++;
+    }
+    if (opened < EVENT_FDS) {
+        fprintf(stderr, "event_loop: failed to set up descriptors: %s\n", strerror(errno));
+        bench_start(t);
+        bench_end(t);
+        goto out;
+    }
+    
+    if (ec->op != EV_ADD_DEL) {
+        for (int i = 0; i < EVENT_FDS; i++) {
+            event_loop_add(loop, fds[i][0], EVENT_READ | EVENT_ET, fds[i]);
+        }
+        event_loop_wait_us(loop, events, EVENT_FDS, 0);
+    }
+    
+    bench_start(t);
+    switch (ec->op) {
+        case EV_ADD_DEL:
+            for (long i = 0; i < t->ops; i++) {
+                int *fd = fds[i % EVENT_FDS];
+                event_loop_add(loop, fd[0], EVENT_READ | EVENT_ET, fd);
+                event_loop_del(loop, fd[0]);
+                if (i % EVENT_FDS == EVENT_FDS - 1) {
+                    event_loop_wait_us(loop, events, EVENT_FDS, 0);
+                }
+            }
+            break;
+        case EV_MOD:
+            for (long i = 0; i < t->ops; i++) {
+                int *fd = fds[i % EVENT_FDS];
+                uint32_t mask = (i / EVENT_FDS) & 1 ? EVENT_READ | EVENT_WRITE : EVENT_READ;
+                event_loop_mod(loop, fd[0], mask | EVENT_ET, fd);
+                if (i % EVENT_FDS == EVENT_FDS - 1) {
+                    event_loop_wait_us(loop, events, EVENT_FDS, 0);
+                }
+            }
+            break;
+        case EV_WAIT_READY:
+            for (long i = 0; i < t->ops; i++) {
+                int *fd = fds[i % EVENT_FDS];
+                notify_signal(fd);
+                int n;
+                do {
+                    n = event_loop_wait_us(loop, events, EVENT_FDS, -1);
+                } while (n == 0 || (n < 0 && errno == EINTR));
+                for (int j = 0; j < n; j++) {
+                    notify_drain(events[j].data);
+                }
+            }
+            break;
+        case EV_WAIT_IDLE:
+            for (long i = 0; i < t->ops; i++) {
+                event_loop_wait_us(loop, events, EVENT_FDS, 0);
+            }
+            break;
+    }
+    bench_end(t);
+
+out:
+    for (int i = 0; i < opened; i++) {
+        notify_close(fds[i]);
+    }
+    event_loop_destroy(loop);
+    return NULL;
+}
+
+static long run_event_loop(const bench_case_t *bc, int threads, long ops) {
+    const ev_case_t *ec = bc->arg;
+    if (event_loop_set_backend(ec->backend) != 0) return -1;
+    
+    long elapsed = run_threads(threads, event_loop_main, ops, (void*)ec);
+    
+    event_loop_set_backend(default_backend);
+    return elapsed;
+}
+
+// ---- 用例表 ----
+
+static task_queue_kind_t kind_mutex = TASK_QUEUE_MUTEX;
+static task_queue_kind_t kind_lockfree = TASK_QUEUE_LOCKFREE;
+static int shared_conn = 1;
+static int batch_one = 1;
+static int batch_many = IO_MSG_BATCH;
+
+#define EVENT_LOOP_CASES(backend, id) \
+    static ev_case_t id##_add_del = { backend, EV_ADD_DEL }; \
+    static ev_case_t id##_mod = { backend, EV_MOD }; \
+    static ev_case_t id##_wait_ready = { backend, EV_WAIT_READY }; \
+    static ev_case_t id##_wait_idle = { backend, EV_WAIT_IDLE };
+
+#ifdef __linux__
+EVENT_LOOP_CASES("epoll", epoll)
+EVENT_LOOP_CASES("io_uring", uring)
+#else
+EVENT_LOOP_CASES("kqueue", kqueue)
+#endif
+
+static const bench_case_t cases[] = {
+    { "task_queue/mutex",         1,  run_task_queue, &kind_mutex },
+    { "task_queue/lockfree",      1,  run_task_queue, &kind_lockfree },
+    { "task/create_destroy",      1,  run_task,       NULL },
+    { "conn_ref/shared",          1,  run_conn_ref,   &shared_conn },
+    { "conn_ref/private",         1,  run_conn_ref,   NULL },
+    { "io_msg/roundtrip",         20, run_io_msg,     &batch_one },
+    { "io_msg/batch",             4,  run_io_msg,     &batch_many },
+#ifdef __linux__
+    { "event_loop/epoll/add_del",       4,  run_event_loop, &epoll_add_del },
+    { "event_loop/epoll/mod",           4,  run_event_loop, &epoll_mod },
+    { "event_loop/epoll/wait_ready",    10, run_event_loop, &epoll_wait_ready },
+    { "event_loop/epoll/wait_idle",     4,  run_event_loop, &epoll_wait_idle },
+    { "event_loop/io_uring/add_del",    4,  run_event_loop, &uring_add_del },
+    { "event_loop/io_uring/mod",        4,  run_event_loop, &uring_mod },
+    { "event_loop/io_uring/wait_ready", 10, run_event_loop, &uring_wait_ready },
+    { "event_loop/io_uring/wait_idle",  4,  run_event_loop, &uring_wait_idle },
+#else
+    { "event_loop/kqueue/add_del",      4,  run_event_loop, &kqueue_add_del },
+    { "event_loop/kqueue/mod",          4,  run_event_loop, &kqueue_mod },
+    { "event_loop/kqueue/wait_ready",   10, run_event_loop, &kqueue_wait_ready },
+    { "event_loop/kqueue/wait_idle",    4,  run_event_loop, &kqueue_wait_idle },
+#endif
+};
+
+// 没有给出过滤条件时全部运行，否则运行名字包含任一过滤串的用例
+static int case_selected(const char *name, char **filters, int filter_count) {
+    if (filter_count == 0) return 1;
+    for (int i = 0; i < filter_count; i++) {
+        if (strstr(name, filters[i])) return 1;
+    }
+    return 0;
+}
+
+// 每个线程最多用 2 * EVENT_FDS 个描述符，按需提高软限制
+static void raise_fd_limit(int max_threads) {
+    struct rlimit rl;
+    rlim_t need = (rlim_t)max_threads * EVENT_FDS * 2 + 64;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < need) {
+        rl.rlim_cur = rl.rlim_max < need ? rl.rlim_max : need;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n ops] [-t thread counts] [case filter...]\n", prog);
+    fprintf(stderr, "  -n OPS    Operations per round, summed over threads (default: %d;\n", DEFAULT_OPS);
+    fprintf(stderr, "            io_msg and event_loop cases run a fraction of it)\n");
+    fprintf(stderr, "  -t LIST   Comma-separated thread counts (default: %s)\n", DEFAULT_THREADS);
+    fprintf(stderr, "Cases:\n");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        fprintf(stderr, "  %s\n", cases[i].name);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long ops = DEFAULT_OPS;
+    const char *thread_list = DEFAULT_THREADS;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                ops = atol(optarg);
+                break;
+            case 't':
+                thread_list = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    
+    int thread_counts[MAX_THREAD_COUNTS];
+    int rounds = 0;
+    int max_threads = 1;
+    for (const char *p = thread_list; *p && rounds < MAX_THREAD_COUNTS; ) {
+        int n = atoi(p);
+        if (n <= 0) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        thread_counts[rounds++] = n;
+        if (n > max_threads) max_threads = n;
+        p = strchr(p, ',');
+        if (!p) break;
+        p++;
+    }
+    if (ops <= 0 || rounds == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    // 库函数的 info 日志（IO 线程创建/销毁等）不混进 JSON
+    log_set_level(LOG_LEVEL_WARN);
+    raise_fd_limit(max_threads);
+    default_backend = event_loop_backend_name();
+    
+    printf("{\n");
+    printf("  \"cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("  \"ops\": %ld,\n", ops);
+    printf("  \"results\": [");
+    
+    int first = 1;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const bench_case_t *bc = &cases[i];
+        if (!case_selected(bc->name, argv + optind, argc - optind)) continue;
+        
+        for (int r = 0; r < rounds; r++) {
+            int threads = thread_counts[r];
+            long case_ops = ops / bc->divisor;
+            case_ops -= case_ops % threads;
+            if (case_ops <= 0) continue;
+            
+            long elapsed = bc->run(bc, threads, case_ops);
+            if (elapsed < 0) {
+                fprintf(stderr, "%s: not available, skipped\n", bc->name);
+                break;
+            }
+            // 耗时为 0 说明操作数太少、时钟分辨率不够，结果没有意义
+            if (elapsed == 0) {
+                fprintf(stderr, "%s: elapsed time is 0 with %d threads, result rejected "
+                        "(raise -n)\n", bc->name, threads);
+                continue;
+            }
+            
+            printf("%s\n    {\"name\": \"%s\", \"threads\": %d, \"ops\": %ld, "
+                   "\"ns_per_op\": %.1f, \"ops_per_sec\": %.0f}",
+                   first ? "" : ",", bc->name, threads, case_ops,
+                   (double)elapsed * threads / case_ops, case_ops / (elapsed / 1e9));
+            fflush(stdout);
+            first = 0;
+        }
+    }
+    
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,317 @@
+// bench_dispatch.c
+// 偏斜负载基准：比较新连接分配策略下轻量请求的延迟分布
+//
+// 先建立 heavy 个持续下载大响应（GET /size/N，两个请求流水线）的重连接，每个重连接后面
+// 紧跟 (io_threads - 1) 个空闲连接，轮询分配会把所有重连接放到同一个 IO 线程上；
+// 等重连接的吞吐稳定后，再建立 light 个一问一答的轻连接，统计轻连接请求的延迟。
+// 服务器需运行在单 acceptor 模式（不加 -r）。
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define DEFAULT_PORT       8080
+#define DEFAULT_IO_THREADS 4
+#define DEFAULT_HEAVY      4
+#define DEFAULT_LIGHT      16
+#define DEFAULT_SECONDS    10
+#define DEFAULT_HEAVY_SIZE (1024 * 1024)
+
+// 重连接上同时在途的请求数
+#define HEAVY_PIPELINE 2
+
+// 建立轻连接前等待重连接吞吐稳定的时间
+#define WARMUP_SECONDS 1
+
+#define HEADER_MAX 1024
+
+typedef enum { CONN_HEAVY, CONN_LIGHT, CONN_IDLE } conn_kind_t;
+
+typedef struct bench_conn {
+    int fd;
+    conn_kind_t kind;
+    
+    // 响应解析：先收集响应头，再按 Content-Length 跳过正文
+    char header[HEADER_MAX];
+    int header_len;
+    long body_left;         // -1 表示正在读响应头
+    
+    double sent_at;         // 轻连接：当前请求的发送时间
+} bench_conn_t;
+
+typedef struct latency_set {
+    double *values;         // 微秒
+    long count;
+    long capacity;
+} latency_set_t;
+
+static char heavy_request[128];
+static int heavy_request_len;
+static const char light_request[] = "GET /light HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void latency_add(latency_set_t *set, double us) {
+    if (set->count == set->capacity) {
+        long capacity = set->capacity ? set->capacity * 2 : 65536;
+        double *values = realloc(set->values, capacity * sizeof(double));
+        if (!values) return;
+        set->values = values;
+        set->capacity = capacity;
+    }
+    set->values[set->count++] = us;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile(const latency_set_t *set, double p) {
+    if (set->count == 0) return 0;
+    long index = (long)(p * (set->count - 1));
+    return set->values[index];
+}
+
+static int open_connection(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    
+    // 阻塞 connect，保证服务器按建立顺序 accept
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+static int send_all(int fd, const char *data, int len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n > 0) {
+            data += n;
+            len -= (int)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // 请求很小，发送缓冲区满只会短暂出现
+            usleep(100);
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int send_request(bench_conn_t *c) {
+    if (c->kind == CONN_HEAVY) {
+        return send_all(c->fd, heavy_request, heavy_request_len);
+    }
+    c->sent_at = now_sec();
+    return send_all(c->fd, light_request, (int)sizeof(light_request) - 1);
+}
+
+// 消费读到的数据，每完成一个响应就在同一连接上发出下一个请求；
+// 返回完成的响应数，-1 表示响应格式错误或发送失败
+static int consume(bench_conn_t *c, const char *data, long len, latency_set_t *lat, int record) {
+    int done = 0;
+    
+    while (len > 0) {
+        if (c->body_left < 0) {
+            // 逐字节收集响应头，直到空行
+            while (len > 0 && c->header_len < HEADER_MAX - 1) {
+                c->header[c->header_len++] = *data++;
+                len--;
+                if (c->header_len >= 4 && memcmp(c->header + c->header_len - 4, "\r\n\r\n", 4) == 0) {
+                    break;
+                }
+            }
+            c->header[c->header_len] = '\0';
+            if (c->header_len >= 4 && strcmp(c->header + c->header_len - 4, "\r\n\r\n") == 0) {
+                const char *cl = strstr(c->header, "Content-Length:");
+                if (!cl) return -1;
+                c->body_left = atol(cl + 15);
+                c->header_len = 0;
+            } else if (c->header_len >= HEADER_MAX - 1) {
+                return -1;
+            } else {
+                break;
+            }
+        }
+        
+        long take = len < c->body_left ? len : c->body_left;
+        data += take;
+        len -= take;
+        c->body_left -= take;
+        
+        if (c->body_left == 0) {
+            c->body_left = -1;
+            done++;
+            if (c->kind == CONN_LIGHT && record) {
+                latency_add(lat, (now_sec() - c->sent_at) * 1e6);
+            }
+            if (send_request(c) != 0) return -1;
+        }
+    }
+    
+    return done;
+}
+
+int main(int argc, char *argv[]) {
+    int port = argc > 1 ? atoi(argv[1]) : DEFAULT_PORT;
+    int io_threads = argc > 2 ? atoi(argv[2]) : DEFAULT_IO_THREADS;
+    int heavy = argc > 3 ? atoi(argv[3]) : DEFAULT_HEAVY;
+    int light = argc > 4 ? atoi(argv[4]) : DEFAULT_LIGHT;
+    int seconds = argc > 5 ? atoi(argv[5]) : DEFAULT_SECONDS;
+    long heavy_size = argc > 6 ? atol(argv[6]) : DEFAULT_HEAVY_SIZE;
+    
+    if (port <= 0 || io_threads <= 0 || heavy < 0 || light <= 0 || seconds <= 0 || heavy_size <= 0) {
+        fprintf(stderr, "Usage: %s [port] [io_threads] [heavy] [light] [seconds] [heavy_size]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    heavy_request_len = snprintf(heavy_request, sizeof(heavy_request),
+                                 "GET /size/%ld HTTP/1.1\r\nHost: localhost\r\n\r\n", heavy_size);
+    
+    int total = heavy * io_threads + light;
+    bench_conn_t *conns = calloc(total, sizeof(bench_conn_t));
+    int epfd = epoll_create1(0);
+    if (!conns || epfd < 0) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    
+    latency_set_t lat = { NULL, 0, 0 };
+    int opened = 0;
+    
+    // 重连接 + 空闲连接交替建立
+    for (int h = 0; h < heavy; h++) {
+        for (int k = 0; k < io_threads; k++) {
+            bench_conn_t *c = &conns[opened];
+            c->fd = open_connection(port);
+            if (c->fd < 0) {
+                fprintf(stderr, "connect failed: %s\n", strerror(errno));
+                return EXIT_FAILURE;
+            }
+            c->kind = k == 0 ? CONN_HEAVY : CONN_IDLE;
+            c->body_left = -1;
+            opened++;
+            
+            if (c->kind == CONN_HEAVY) {
+                struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+                epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+                for (int i = 0; i < HEAVY_PIPELINE; i++) {
+                    send_request(c);
+                }
+            }
+        }
+    }
+    
+    char *buf = malloc(256 * 1024);
+    struct epoll_event events[256];
+    long heavy_bytes = 0, light_done = 0;
+    double start = now_sec();
+    double light_start = 0, end = 0;
+    int measuring = 0, failed = 0;
+    
+    while (!failed) {
+        double now = now_sec();
+        
+        // 重连接预热后建立轻连接并开始计时
+        if (!measuring && now - start >= WARMUP_SECONDS) {
+            for (int i = 0; i < light; i++) {
+                bench_conn_t *c = &conns[opened];
+                c->fd = open_connection(port);
+                if (c->fd < 0) {
+                    fprintf(stderr, "connect failed: %s\n", strerror(errno));
+                    return EXIT_FAILURE;
+                }
+                c->kind = CONN_LIGHT;
+                c->body_left = -1;
+                opened++;
+                
+                struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+                epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+                send_request(c);
+            }
+            measuring = 1;
+            light_start = now_sec();
+            heavy_bytes = 0;
+            end = light_start + seconds;
+        }
+        if (measuring && now >= end) break;
+        
+        int n = epoll_wait(epfd, events, 256, 10);
+        for (int i = 0; i < n && !failed; i++) {
+            bench_conn_t *c = events[i].data.ptr;
+            
+            while (1) {
+                ssize_t r = read(c->fd, buf, 256 * 1024);
+                if (r > 0) {
+                    if (c->kind == CONN_HEAVY) {
+                        heavy_bytes += r;
+                    }
+                    int done = consume(c, buf, r, &lat, measuring);
+                    if (done < 0) {
+                        fprintf(stderr, "bad response\n");
+                        failed = 1;
+                        break;
+                    }
+                    if (c->kind == CONN_LIGHT) {
+                        light_done += done;
+                    }
+                } else if (r < 0 && errno == EINTR) {
+                    continue;
+                } else if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                } else {
+                    fprintf(stderr, "connection closed by server\n");
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+    }
+    
+    double elapsed = now_sec() - light_start;
+    qsort(lat.values, lat.count, sizeof(double), compare_double);
+    
+    printf("%8ld req  %9.0f req/s  p50 %8.1f  p90 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f us"
+           "  heavy %7.1f MB/s\n",
+           light_done, light_done / elapsed,
+           percentile(&lat, 0.50), percentile(&lat, 0.90), percentile(&lat, 0.99),
+           percentile(&lat, 0.999), lat.count ? lat.values[lat.count - 1] : 0.0,
+           heavy_bytes / elapsed / (1024 * 1024));
+    
+    for (int i = 0; i < opened; i++) {
+        close(conns[i].fd);
+    }
+    close(epfd);
+    free(conns);
+    free(buf);
+    free(lat.values);
+    return failed ? EXIT_FAILURE : 0;
+}
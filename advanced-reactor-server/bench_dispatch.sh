@@ -0,0 +1,38 @@
+#!/bin/bash
+
+# 偏斜负载下的连接分配策略对比：少量重连接（持续下载大响应）+ 轻连接（一问一答）
+# 用法: ./bench_dispatch.sh [io_threads] [worker_threads] [heavy] [light] [seconds]
+# 每种策略启动一次服务器，输出轻连接请求的延迟分位数（微秒）
+
+IO_THREADS=${1:-4}
+WORKER_THREADS=${2:-8}
+HEAVY=${3:-4}
+LIGHT=${4:-16}
+SECONDS_PER_RUN=${5:-10}
+PORT=18091
+POLICIES="rr least p2c"
+
+if [ ! -x ./reactor_server ] || [ ! -x ./bench_dispatch ]; then
+    echo "Build first: make && make bench_dispatch"
+    exit 1
+fi
+
+echo "=== Dispatch benchmark: $HEAVY heavy + $LIGHT light connections, $IO_THREADS IO threads ==="
+
+for policy in $POLICIES; do
+    ./reactor_server -p $PORT -i $IO_THREADS -w $WORKER_THREADS -d $policy \
+        > server_dispatch_$policy.log 2>&1 &
+    server_pid=$!
+    sleep 1
+
+    if ! kill -0 $server_pid 2>/dev/null; then
+        echo "Server failed to start (see server_dispatch_$policy.log)"
+        exit 1
+    fi
+
+    printf "%-6s " "$policy"
+    ./bench_dispatch $PORT $IO_THREADS $HEAVY $LIGHT $SECONDS_PER_RUN
+
+    kill -INT $server_pid 2>/dev/null
+    wait $server_pid 2>/dev/null
+done
@@ -0,0 +1,218 @@
+// bench_idle_conns.c
+// 空闲连接基准：对服务器保持大量不发请求的长连接，统计服务器在此期间的 CPU 占用，
+// 再等待服务器按空闲超时回收这些连接，统计回收耗时和回收期间的 CPU 占用。
+// 服务器 CPU 从 /proc/<pid>/stat 读取（仅 Linux）。
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define DEFAULT_CONNECTIONS 200000
+#define DEFAULT_SECONDS     10
+#define DEFAULT_PORT        8080
+
+// 每个源地址最多建立的连接数（受本地端口范围限制，换用 127.0.0.x 扩展）
+#define CONNS_PER_SOURCE 25000
+
+// 等待服务器回收连接的最长时间
+#define REAP_WAIT_SECONDS 300
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 读取进程累计 CPU 时间（用户态 + 内核态，秒）
+static double process_cpu_sec(int pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    
+    char buf[1024];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    
+    // 进程名可能含空格，从最后一个 ')' 之后开始数字段：utime、stime 是第 14、15 个字段
+    char *p = strrchr(buf, ')');
+    if (!p) return -1;
+    unsigned long utime = 0, stime = 0;
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) != 2) {
+        return -1;
+    }
+    
+    return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+static long process_rss_kb(int pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    
+    char line[256];
+    long rss = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmRSS: %ld", &rss) == 1) break;
+    }
+    fclose(f);
+    return rss;
+}
+
+// 采样 seconds 秒内服务器的 CPU 占用（百分比，100% = 一个核）
+static double sample_cpu(int pid, int seconds) {
+    double cpu_start = process_cpu_sec(pid);
+    double start = now_sec();
+    sleep(seconds);
+    double cpu_end = process_cpu_sec(pid);
+    double elapsed = now_sec() - start;
+    
+    if (cpu_start < 0 || cpu_end < 0) return -1;
+    return (cpu_end - cpu_start) / elapsed * 100.0;
+}
+
+static int open_connection(int index, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    
+    // 源地址轮换到 127.0.0.2、127.0.0.3 ...，突破单个源地址的端口数限制
+    struct sockaddr_in src;
+    memset(&src, 0, sizeof(src));
+    src.sin_family = AF_INET;
+    src.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + index / CONNS_PER_SOURCE);
+    if (bind(fd, (struct sockaddr*)&src, sizeof(src)) != 0) {
+        close(fd);
+        return -1;
+    }
+    
+    struct sockaddr_in dst;
+    memset(&dst, 0, sizeof(dst));
+    dst.sin_family = AF_INET;
+    dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    dst.sin_port = htons(port);
+    if (connect(fd, (struct sockaddr*)&dst, sizeof(dst)) != 0) {
+        close(fd);
+        return -1;
+    }
+    
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <server_pid> [connections] [seconds] [port]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    int pid = atoi(argv[1]);
+    int count = argc > 2 ? atoi(argv[2]) : DEFAULT_CONNECTIONS;
+    int seconds = argc > 3 ? atoi(argv[3]) : DEFAULT_SECONDS;
+    int port = argc > 4 ? atoi(argv[4]) : DEFAULT_PORT;
+    
+    if (pid <= 0 || count <= 0 || seconds <= 0 || process_cpu_sec(pid) < 0) {
+        fprintf(stderr, "Usage: %s <server_pid> [connections] [seconds] [port]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    // 每个连接一个描述符
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < (rlim_t)count + 64) {
+        rl.rlim_cur = (rlim_t)count + 64 < rl.rlim_max ? (rlim_t)count + 64 : rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    
+    int *fds = calloc(count, sizeof(int));
+    int epfd = epoll_create1(0);
+    if (!fds || epfd < 0) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    
+    printf("Idle connection benchmark: server pid %d, port %d\n\n", pid, port);
+    
+    double idle_cpu = sample_cpu(pid, seconds);
+    long idle_rss = process_rss_kb(pid);
+    printf("%-28s %8.2f%% CPU  rss=%ld KB\n", "baseline (0 connections)", idle_cpu, idle_rss);
+    
+    // 建立连接，之后不再发送任何数据
+    double start = now_sec();
+    int opened = 0;
+    for (int i = 0; i < count; i++) {
+        int fd = open_connection(i, port);
+        if (fd < 0) {
+            fprintf(stderr, "connect #%d failed: %s\n", i, strerror(errno));
+            break;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLRDHUP;
+        ev.data.u32 = (uint32_t)i;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+        fds[opened++] = fd;
+    }
+    printf("%-28s %8d in %.2fs\n", "opened connections", opened, now_sec() - start);
+    
+    // 等服务器把积压的连接全部接收下来再采样
+    sleep(1);
+    double held_cpu = sample_cpu(pid, seconds);
+    long held_rss = process_rss_kb(pid);
+    char label[64];
+    snprintf(label, sizeof(label), "holding %d idle", opened);
+    printf("%-28s %8.2f%% CPU  rss=%ld KB\n", label, held_cpu, held_rss);
+    printf("%-28s %8.2f%% CPU  (%.3f us per connection-second)\n", "cost of idle connections",
+           held_cpu - idle_cpu, opened > 0 ? (held_cpu - idle_cpu) * 1e4 / opened : 0.0);
+    
+    // 等待服务器按空闲超时关闭全部连接
+    printf("\nwaiting up to %ds for the server to reap idle connections...\n", REAP_WAIT_SECONDS);
+    double reap_start = now_sec();
+    double cpu_start = process_cpu_sec(pid);
+    double first_close = 0, last_close = 0;
+    int closed = 0;
+    struct epoll_event events[1024];
+    
+    while (closed < opened && now_sec() - reap_start < REAP_WAIT_SECONDS) {
+        int n = epoll_wait(epfd, events, 1024, 1000);
+        for (int i = 0; i < n; i++) {
+            int fd = fds[events[i].data.u32];
+            epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+            close(fd);
+            fds[events[i].data.u32] = -1;
+            if (closed++ == 0) {
+                first_close = now_sec();
+            }
+            last_close = now_sec();
+        }
+    }
+    double reap_cpu = process_cpu_sec(pid) - cpu_start;
+    double reap_elapsed = now_sec() - reap_start;
+    
+    if (closed == 0) {
+        printf("%-28s none (is the idle timeout enabled?)\n", "reaped");
+    } else {
+        printf("%-28s %8d after %.2fs, spread over %.2fs\n", "reaped", closed,
+               first_close - reap_start, last_close - first_close);
+        // 扣除同一时段的基线占用
+        double reap_extra = reap_cpu - idle_cpu / 100.0 * reap_elapsed;
+        printf("%-28s %8.3fs CPU while waiting, %.3fs above baseline (%.2f us per connection)\n",
+               "reap cost", reap_cpu, reap_extra, reap_extra * 1e6 / closed);
+    }
+    
+    for (int i = 0; i < opened; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    close(epfd);
+    free(fds);
+    return 0;
+}
@@ -0,0 +1,146 @@
+// bench_log.c
+// 日志吞吐基准：threads 个线程各写 lines 条与服务器相同格式的访问日志，
+// 比较异步日志（每线程环形缓冲区 + 后台格式化）与同步 fprintf（stdio 锁 + 调用线程格式化）。
+// 同步模式不限速；异步模式按 rate（所有线程合计的行数/秒，0 表示不限速）匀速写入，
+// 检查该速率下日志线程能否跟上（dropped 为 0）。
+// 按 CPU 时间统计（单核机器上调用线程和日志线程互相抢占，墙钟时间混在一起）：
+// 调用线程每条的 CPU 耗时；异步模式下另外给出日志线程每行的 CPU 耗时（进程 CPU 时间
+// 减去调用线程的 CPU 时间）及对应的每秒行数上限，以及缓冲区满时丢弃的条数。
+#include "common.h"
+
+#define DEFAULT_THREADS 4
+#define DEFAULT_LINES   1000000
+#define DEFAULT_RATE    1000000
+#define DEFAULT_PATH    "/dev/null"
+
+// 限速时每写这么多条检查一次时间（2 的幂）
+#define PACE_EVERY 64
+
+typedef struct bench_thread {
+    pthread_t tid;
+    int index;
+    long lines;
+    FILE *sync_out;         // NULL 时走异步日志
+    double interval;        // 限速时每条的间隔（秒），0 表示不限速
+    double cpu;             // 线程 CPU 时间（秒）
+} bench_thread_t;
+
+static double clock_sec(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* bench_run(void *arg) {
+    bench_thread_t *t = arg;
+    static const char *paths[] = { "/size/1024", "/static/1k.bin", "/sleep/1", "/metrics" };
+    unsigned char ip[4] = { 10, 0, (unsigned char)t->index, 1 };
+    
+    // 第一条不计时（解析格式串、分配并预触碰本线程的缓冲区）
+    double start = 0;
+    double pace_start = clock_sec(CLOCK_MONOTONIC);
+    for (long i = 0; i < t->lines; i++) {
+        if (i == 1) {
+            start = clock_sec(CLOCK_THREAD_CPUTIME_ID);
+        }
+        const char *path = paths[i & 3];
+        int path_len = (int)strlen(path);
+        long ts = 1700000000 + i / 1000;
+        unsigned port = 40000 + (unsigned)(i & 1023);
+        
+        if (t->sync_out) {
+            fprintf(t->sync_out,
+                    "{\"ts\":%ld.%03ld,\"client\":\"%u.%u.%u.%u:%u\",\"method\":\"%.*s\",\"path\":\"%.*s\","
+                    "\"status\":%d,\"bytes\":%zu,\"us\":%lu,\"via\":\"%s\"}\n",
+                    ts, i % 1000, ip[0], ip[1], ip[2], ip[3], port, 3, "GET", path_len, path,
+                    200, (size_t)1024 + (i & 255), (unsigned long)(i & 511), "worker");
+        } else {
+            access_log("{\"ts\":%ld.%03ld,\"client\":\"%u.%u.%u.%u:%u\",\"method\":\"%.*s\",\"path\":\"%.*s\","
+                       "\"status\":%d,\"bytes\":%zu,\"us\":%lu,\"via\":\"%s\"}",
+                       ts, i % 1000, ip[0], ip[1], ip[2], ip[3], port, 3, "GET", path_len, path,
+                       200, (size_t)1024 + (i & 255), (unsigned long)(i & 511), "worker");
+        }
+        
+        // 超前于目标速率时睡到下一条的时间点；被调度延误超过 1ms 时不集中补写，从当前时间重新计
+        if (t->interval > 0 && (i & (PACE_EVERY - 1)) == PACE_EVERY - 1) {
+            double ahead = pace_start + (i + 1) * t->interval - clock_sec(CLOCK_MONOTONIC);
+            if (ahead > 0) {
+                struct timespec ts = { (time_t)ahead, (long)((ahead - (time_t)ahead) * 1e9) };
+                nanosleep(&ts, NULL);
+            } else if (ahead < -0.001) {
+                pace_start -= ahead;
+            }
+        }
+    }
+    t->cpu = t->lines > 1 ? clock_sec(CLOCK_THREAD_CPUTIME_ID) - start : 0;
+    return NULL;
+}
+
+// 运行一轮，返回调用线程的 CPU 时间之和
+static double run_round(bench_thread_t *threads, int count, long lines, FILE *sync_out, double interval) {
+    double cpu = 0;
+    for (int i = 0; i < count; i++) {
+        threads[i].index = i;
+        threads[i].lines = lines;
+        threads[i].sync_out = sync_out;
+        threads[i].interval = interval;
+        pthread_create(&threads[i].tid, NULL, bench_run, &threads[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        pthread_join(threads[i].tid, NULL);
+        cpu += threads[i].cpu;
+    }
+    return cpu;
+}
+
+int main(int argc, char *argv[]) {
+    int thread_count = argc > 1 ? atoi(argv[1]) : DEFAULT_THREADS;
+    long lines = argc > 2 ? atol(argv[2]) : DEFAULT_LINES;
+    long rate = argc > 3 ? atol(argv[3]) : DEFAULT_RATE;
+    const char *path = argc > 4 ? argv[4] : DEFAULT_PATH;
+    
+    if (thread_count <= 0 || lines <= 1 || rate < 0) {
+        fprintf(stderr, "Usage: %s [threads] [lines per thread] [lines/s, 0 = unlimited] [output file]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    bench_thread_t *threads = calloc(thread_count, sizeof(bench_thread_t));
+    if (!threads) return EXIT_FAILURE;
+    long total = (long)thread_count * lines;
+    long timed = total - thread_count;     // 每个线程的第一条不计入调用耗时
+    
+    // 同步：每次调用在调用线程格式化并持有 stdio 锁
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    double wall = clock_sec(CLOCK_MONOTONIC);
+    double cpu = run_round(threads, thread_count, lines, out, 0);
+    fclose(out);
+    wall = clock_sec(CLOCK_MONOTONIC) - wall;
+    printf("sync fprintf : %d threads  caller %7.1f ns/line  %10.0f lines/s wall\n",
+           thread_count, cpu / timed * 1e9, total / wall);
+    
+    // 异步：调用线程只复制参数，格式化和 write 在日志线程
+    if (log_open_access(path) != 0 || log_init() != 0) return EXIT_FAILURE;
+    double process = clock_sec(CLOCK_PROCESS_CPUTIME_ID);
+    wall = clock_sec(CLOCK_MONOTONIC);
+    cpu = run_round(threads, thread_count, lines, NULL, rate > 0 ? (double)thread_count / rate : 0);
+    
+    long records, dropped;
+    log_get_stats(&records, &dropped);
+    log_shutdown();
+    
+    wall = clock_sec(CLOCK_MONOTONIC) - wall;
+    process = clock_sec(CLOCK_PROCESS_CPUTIME_ID) - process;
+    double written = (double)(total - dropped);
+    double consumer_ns = written > 0 ? (process - cpu) / written * 1e9 : 0;
+    printf("async ring   : %d threads  caller %7.1f ns/line  %10.0f lines/s wall  "
+           "log thread %7.1f ns/line (max %.0f lines/s)  dropped %ld\n",
+           thread_count, cpu / timed * 1e9, written / wall, consumer_ns,
+           consumer_ns > 0 ? 1e9 / consumer_ns : 0.0, dropped);
+    
+    free(threads);
+    return 0;
+}
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+# 响应大小对比：GET /size/N 从 100 B 到 10 MB 的吞吐量
+# 用法: ./bench_response_size.sh [clients] [io_threads] [worker_threads]
+# 每个客户端是一个 keep-alive 的 curl 进程，按大小调整请求数使每轮传输量相近
+
+CLIENTS=${1:-4}
+IO_THREADS=${2:-4}
+WORKER_THREADS=${3:-8}
+PORT=18090
+SIZES="100 1024 10240 65536 102400 1048576 10485760"
+BYTES_PER_ROUND=$((256 * 1024 * 1024))
+
+if [ ! -x ./reactor_server ]; then
+    echo "Build first: make"
+    exit 1
+fi
+
+if ! command -v curl &> /dev/null; then
+    echo "curl is required"
+    exit 1
+fi
+
+./reactor_server -p $PORT -i $IO_THREADS -w $WORKER_THREADS > server_response_size.log 2>&1 &
+server_pid=$!
+sleep 1
+
+if ! kill -0 $server_pid 2>/dev/null; then
+    echo "Server failed to start (see server_response_size.log)"
+    exit 1
+fi
+
+echo "=== Response size benchmark ($CLIENTS keep-alive clients) ==="
+printf "%10s %10s %10s %12s %10s\n" "size" "requests" "seconds" "MB/s" "req/s"
+
+for size in $SIZES; do
+    per_client=$((BYTES_PER_ROUND / size / CLIENTS))
+    [ $per_client -gt 20000 ] && per_client=20000
+    [ $per_client -lt 5 ] && per_client=5
+
+    start=$(date +%s.%N)
+    pids=""
+    for c in $(seq 1 $CLIENTS); do
+        curl -s -o /dev/null "http://127.0.0.1:$PORT/size/$size?[1-$per_client]" &
+        pids="$pids $!"
+    done
+    wait $pids
+    end=$(date +%s.%N)
+
+    requests=$((per_client * CLIENTS))
+    awk -v s="$size" -v r="$requests" -v t0="$start" -v t1="$end" 'BEGIN {
+        t = t1 - t0
+        printf "%10d %10d %10.2f %12.1f %10.0f\n", s, r, t, s * r / t / 1048576, r / t
+    }'
+done
+
+kill -INT $server_pid 2>/dev/null
+wait $server_pid 2>/dev/null
@@ -0,0 +1,57 @@
+#!/bin/bash
+
+# 静态文件发送方式对比：sendfile（小文件走内存缓存）与 --static-copy（pread + writev）
+# 用法: ./bench_static.sh [io_threads] [worker_threads] [connections] [seconds]
+# 在临时目录生成 1KB / 64KB / 8MB 文件，每种方式启动一次服务器，依次压测三个文件
+
+IO_THREADS=${1:-4}
+WORKER_THREADS=${2:-8}
+CONNECTIONS=${3:-16}
+SECONDS_PER_RUN=${4:-5}
+PORT=18092
+FILES="1k.bin 64k.bin 8m.bin"
+
+# 从 test_client 的 JSON 输出中取第一个同名数值字段
+json_field() {
+    echo "$1" | sed -n "s/.*\"$2\": \([0-9.]*\).*/\1/p" | head -1
+}
+
+if [ ! -x ./reactor_server ] || [ ! -x ./test_client ]; then
+    echo "Build first: make && make test_client"
+    exit 1
+fi
+
+ROOT=$(mktemp -d)
+trap 'rm -rf "$ROOT"' EXIT
+head -c 1024 /dev/urandom > "$ROOT/1k.bin"
+head -c 65536 /dev/urandom > "$ROOT/64k.bin"
+head -c 8388608 /dev/urandom > "$ROOT/8m.bin"
+
+echo "=== Static file benchmark: $CONNECTIONS connections, $IO_THREADS IO threads, $WORKER_THREADS workers ==="
+
+for mode in sendfile copy; do
+    extra=""
+    [ "$mode" = "copy" ] && extra="--static-copy"
+
+    ./reactor_server -p $PORT -i $IO_THREADS -w $WORKER_THREADS -s "$ROOT" $extra \
+        > server_static_$mode.log 2>&1 &
+    server_pid=$!
+    sleep 1
+
+    if ! kill -0 $server_pid 2>/dev/null; then
+        echo "Server failed to start (see server_static_$mode.log)"
+        exit 1
+    fi
+
+    for file in $FILES; do
+        result=$(./test_client -p $PORT -c $CONNECTIONS -d $SECONDS_PER_RUN \
+            -u /static/$file 2>/dev/null)
+        printf "%-9s %-8s %8s req  %9s req/s  %8s MB/s  p50 %8s  p99 %8s  max %8s us\n" \
+            "$mode" "$file" "$(json_field "$result" requests)" "$(json_field "$result" rps)" \
+            "$(json_field "$result" mb_per_s)" "$(json_field "$result" p50)" \
+            "$(json_field "$result" p99)" "$(json_field "$result" max)"
+    done
+
+    kill -INT $server_pid 2>/dev/null
+    wait $server_pid 2>/dev/null
+done
@@ -0,0 +1,154 @@
+// bench_task_queue.c
+// 任务队列微基准：互斥队列 vs 无锁环形队列
+// 每轮 N 个生产者 + N 个消费者，统计吞吐量和入队延迟分位数
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "task_queue.h"
+
+#define DEFAULT_TOTAL_OPS  1000000
+#define DEFAULT_QUEUE_SIZE 1024
+
+typedef struct {
+    task_queue_t *queue;
+    task_t *tasks;          // 本线程负责入队的任务
+    int count;
+    long *latencies;        // 每次入队耗时 (ns)
+} producer_arg_t;
+
+typedef struct {
+    task_queue_t *queue;
+    task_t *sentinel;
+    long popped;
+} consumer_arg_t;
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static void* producer_main(void *arg) {
+    producer_arg_t *p = (producer_arg_t*)arg;
+    
+    for (int i = 0; i < p->count; i++) {
+        long start = now_ns();
+        task_queue_push(p->queue, &p->tasks[i]);
+        p->latencies[i] = now_ns() - start;
+    }
+    return NULL;
+}
+
+static void* consumer_main(void *arg) {
+    consumer_arg_t *c = (consumer_arg_t*)arg;
+    
+    while (1) {
+        task_t *task = task_queue_pop(c->queue);
+        if (!task || task == c->sentinel) break;
+        c->popped++;
+    }
+    return NULL;
+}
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_round(task_queue_kind_t kind, int threads, int total_ops, int queue_size) {
+    task_queue_t *queue = task_queue_create_kind(queue_size, kind);
+    if (!queue) {
+        fprintf(stderr, "Failed to create queue\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    int per_thread = total_ops / threads;
+    int ops = per_thread * threads;
+    
+    task_t *tasks = calloc(ops, sizeof(task_t));
+    long *latencies = calloc(ops, sizeof(long));
+    task_t sentinel;
+    pthread_t *producers = calloc(threads, sizeof(pthread_t));
+    pthread_t *consumers = calloc(threads, sizeof(pthread_t));
+    producer_arg_t *pargs = calloc(threads, sizeof(producer_arg_t));
+    consumer_arg_t *cargs = calloc(threads, sizeof(consumer_arg_t));
+    if (!tasks || !latencies || !producers || !consumers || !pargs || !cargs) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    long start = now_ns();
+    
+    for (int i = 0; i < threads; i++) {
+        cargs[i].queue = queue;
+        cargs[i].sentinel = &sentinel;
+        pthread_create(&consumers[i], NULL, consumer_main, &cargs[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        pargs[i].queue = queue;
+        pargs[i].tasks = tasks + (long)i * per_thread;
+        pargs[i].count = per_thread;
+        pargs[i].latencies = latencies + (long)i * per_thread;
+        pthread_create(&producers[i], NULL, producer_main, &pargs[i]);
+    }
+    
+    for (int i = 0; i < threads; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    // 每个消费者收到一个哨兵后退出
+    for (int i = 0; i < threads; i++) {
+        task_queue_push(queue, &sentinel);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+    
+    long elapsed = now_ns() - start;
+    
+    long popped = 0;
+    for (int i = 0; i < threads; i++) {
+        popped += cargs[i].popped;
+    }
+    
+    qsort(latencies, ops, sizeof(long), cmp_long);
+    long p50 = latencies[(long)ops * 50 / 100];
+    long p99 = latencies[(long)ops * 99 / 100];
+    double ops_per_sec = popped / (elapsed / 1e9);
+    
+    printf("%-9s %7d %14.0f %10ld %10ld%s\n",
+           task_queue_kind_name(kind), threads, ops_per_sec, p50, p99,
+           popped == ops ? "" : "  (LOST TASKS)");
+    
+    free(tasks);
+    free(latencies);
+    free(producers);
+    free(consumers);
+    free(pargs);
+    free(cargs);
+    task_queue_destroy(queue);
+}
+
+int main(int argc, char *argv[]) {
+    int total_ops = argc > 1 ? atoi(argv[1]) : DEFAULT_TOTAL_OPS;
+    int queue_size = argc > 2 ? atoi(argv[2]) : DEFAULT_QUEUE_SIZE;
+    int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+    int rounds = sizeof(thread_counts) / sizeof(thread_counts[0]);
+    
+    if (total_ops <= 0 || queue_size <= 0) {
+        fprintf(stderr, "Usage: %s [total_ops] [queue_size]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    printf("Task queue benchmark: %d ops per round, queue size %d\n", total_ops, queue_size);
+    printf("threads = producers = consumers, latency = task_queue_push() in ns\n\n");
+    printf("%-9s %7s %14s %10s %10s\n", "queue", "threads", "ops/sec", "p50", "p99");
+    
+    for (int i = 0; i < rounds; i++) {
+        run_round(TASK_QUEUE_MUTEX, thread_counts[i], total_ops, queue_size);
+        run_round(TASK_QUEUE_LOCKFREE, thread_counts[i], total_ops, queue_size);
+    }
+    
+    return 0;
+}
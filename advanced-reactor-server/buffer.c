@@ -0,0 +1,256 @@
+// buffer.c
+#include "common.h"
+#include "object_pool.h"
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+// 每个线程的缓冲区 / 链表节点对象池预分配数
+#define BUF_POOL_PREFILL 16
+#define SEG_POOL_PREFILL 64
+
+// 单个文件片段的上限（slice.len 为 int）
+#define FILE_SEG_MAX (1 << 30)
+
+// 没有 sendfile 的平台上每次 pread + write 的字节数
+#define FILE_COPY_SIZE (64 * 1024)
+
+static __thread object_pool_t *tls_buf_pool;
+static __thread object_pool_t *tls_seg_pool;
+
+buf_t* buf_alloc(int size) {
+    buf_t *buf;
+    
+    if (size <= BUF_CHUNK_SIZE) {
+        object_pool_t *pool = object_pool_thread_local(&tls_buf_pool, "buf",
+                                                       sizeof(buf_t) + BUF_CHUNK_SIZE,
+                                                       BUF_POOL_PREFILL);
+        buf = (buf_t*)object_pool_alloc(pool);
+        if (!buf) return NULL;
+        buf->size = BUF_CHUNK_SIZE;
+        buf->pooled = 1;
+    } else {
+        buf = (buf_t*)malloc(sizeof(buf_t) + size);
+        if (!buf) return NULL;
+        object_pool_count_heap_alloc();
+        buf->size = size;
+        buf->pooled = 0;
+    }
+    
+    atomic_init(&buf->refs, 1);
+    return buf;
+}
+
+buf_t* buf_alloc_exact(int size) {
+    buf_t *buf = (buf_t*)malloc(sizeof(buf_t) + size);
+    if (!buf) return NULL;
+    
+    buf->size = size;
+    buf->pooled = 0;
+    atomic_init(&buf->refs, 1);
+    return buf;
+}
+
+void buf_unref(buf_t *buf) {
+    if (!buf) return;
+    
+    if (atomic_fetch_sub_explicit(&buf->refs, 1, memory_order_acq_rel) == 1) {
+        if (buf->pooled) {
+            object_pool_free(buf);
+        } else {
+            free(buf);
+        }
+    }
+}
+
+void buf_file_unref(buf_file_t *file) {
+    if (!file) return;
+    
+    if (atomic_fetch_sub_explicit(&file->refs, 1, memory_order_acq_rel) == 1) {
+        file->release(file);
+    }
+}
+
+static buf_seg_t* seg_alloc(void) {
+    object_pool_t *pool = object_pool_thread_local(&tls_seg_pool, "buf_seg",
+                                                   sizeof(buf_seg_t), SEG_POOL_PREFILL);
+    buf_seg_t *seg = (buf_seg_t*)object_pool_alloc(pool);
+    if (!seg) return NULL;
+    
+    seg->next = NULL;
+    seg->file = NULL;
+    seg->file_off = 0;
+    return seg;
+}
+
+static void chain_link(buf_chain_t *chain, buf_seg_t *seg) {
+    if (chain->tail) {
+        chain->tail->next = seg;
+    } else {
+        chain->head = seg;
+    }
+    chain->tail = seg;
+    chain->count++;
+    chain->bytes += seg->slice.len;
+}
+
+int buf_chain_append(buf_chain_t *chain, buf_t *buf, int off, int len) {
+    if (len <= 0) return 0;
+    
+    buf_seg_t *seg = seg_alloc();
+    if (!seg) return -1;
+    
+    seg->slice.buf = buf_ref(buf);
+    seg->slice.off = off;
+    seg->slice.len = len;
+    chain_link(chain, seg);
+    
+    return 0;
+}
+
+int buf_chain_append_file(buf_chain_t *chain, buf_file_t *file, off_t off, size_t len) {
+    while (len > 0) {
+        buf_seg_t *seg = seg_alloc();
+        if (!seg) return -1;
+        
+        int seg_len = len > FILE_SEG_MAX ? FILE_SEG_MAX : (int)len;
+        seg->slice.buf = NULL;
+        seg->slice.off = 0;
+        seg->slice.len = seg_len;
+        seg->file = buf_file_ref(file);
+        seg->file_off = off;
+        chain_link(chain, seg);
+        
+        off += seg_len;
+        len -= seg_len;
+    }
+    
+    return 0;
+}
+
+void buf_chain_move(buf_chain_t *dst, buf_chain_t *src) {
+    if (!src->head) return;
+    
+    if (dst->tail) {
+        dst->tail->next = src->head;
+    } else {
+        dst->head = src->head;
+    }
+    dst->tail = src->tail;
+    dst->count += src->count;
+    dst->bytes += src->bytes;
+    
+    buf_chain_init(src);
+}
+
+int buf_chain_to_iov(const buf_chain_t *chain, struct iovec *iov, int max) {
+    int n = 0;
+    
+    for (buf_seg_t *seg = chain->head; seg && n < max && !seg->file; seg = seg->next) {
+        iov[n].iov_base = buf_slice_data(&seg->slice);
+        iov[n].iov_len = seg->slice.len;
+        n++;
+    }
+    
+    return n;
+}
+
+// 从文件片段写出：Linux 上 sendfile，其它平台 pread 到栈上缓冲区再 write
+static ssize_t file_send(int fd, const buf_seg_t *seg) {
+#ifdef __linux__
+    off_t off = seg->file_off;
+    ssize_t n = sendfile(fd, seg->file->fd, &off, seg->slice.len);
+#else
+    char data[FILE_COPY_SIZE];
+    size_t want = seg->slice.len < FILE_COPY_SIZE ? (size_t)seg->slice.len : FILE_COPY_SIZE;
+    ssize_t n = pread(seg->file->fd, data, want, seg->file_off);
+    if (n > 0) {
+        n = write(fd, data, n);
+    }
+#endif
+    // 文件在发送途中被截断：再写也不会有进展
+    if (n == 0) {
+        errno = EIO;
+        return -1;
+    }
+    return n;
+}
+
+ssize_t buf_chain_write(int fd, const buf_chain_t *chain, struct iovec *iov, int max,
+                        size_t *batch_bytes) {
+    const buf_seg_t *head = chain->head;
+    
+    if (head->file) {
+        *batch_bytes = head->slice.len;
+        return file_send(fd, head);
+    }
+    
+    int iovcnt = buf_chain_to_iov(chain, iov, max);
+    size_t bytes = 0;
+    const buf_seg_t *seg = head;
+    for (int i = 0; i < iovcnt; i++) {
+        bytes += iov[i].iov_len;
+        seg = seg->next;
+    }
+    *batch_bytes = bytes;
+    
+#ifdef MSG_MORE
+    // 后面紧跟文件片段（如响应头 + sendfile 正文）：先不发出这一小段，和正文一起组包
+    if (seg && seg->file) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        ssize_t n = sendmsg(fd, &msg, MSG_MORE);
+        if (n >= 0 || errno != ENOTSOCK) return n;
+    }
+#endif
+    
+    return writev(fd, iov, iovcnt);
+}
+
+static void buf_seg_free(buf_seg_t *seg) {
+    if (seg->file) {
+        buf_file_unref(seg->file);
+    } else {
+        buf_unref(seg->slice.buf);
+    }
+    object_pool_free(seg);
+}
+
+void buf_chain_consume(buf_chain_t *chain, size_t n) {
+    chain->bytes -= n;
+    
+    while (n > 0 && chain->head) {
+        buf_seg_t *seg = chain->head;
+        
+        if (n < (size_t)seg->slice.len) {
+            if (seg->file) {
+                seg->file_off += n;
+            } else {
+                seg->slice.off += n;
+            }
+            seg->slice.len -= n;
+            return;
+        }
+        
+        n -= seg->slice.len;
+        chain->head = seg->next;
+        chain->count--;
+        buf_seg_free(seg);
+    }
+    
+    if (!chain->head) {
+        chain->tail = NULL;
+    }
+}
+
+void buf_chain_clear(buf_chain_t *chain) {
+    buf_seg_t *seg = chain->head;
+    while (seg) {
+        buf_seg_t *next = seg->next;
+        buf_seg_free(seg);
+        seg = next;
+    }
+    buf_chain_init(chain);
+}
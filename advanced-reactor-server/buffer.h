@@ -0,0 +1,119 @@
+// buffer.h
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// 引用计数缓冲区
+//
+// IO 线程直接 read() 进 buf_t，再把其中一段 (slice) 连同一个引用交给工作线程，
+// 不复制数据；工作线程把响应组织成 slice 链 (buf_chain_t) 交还给 IO 线程 writev。
+// 缓冲区的内容在发布后只读，最后一个引用释放时归还对象池。
+//
+// 不超过 BUF_CHUNK_SIZE 的缓冲区来自线程局部对象池，更大的单独 malloc。
+//
+// 链上也可以挂文件片段（buf_file_t 的一段），写出时用 sendfile 直接从页缓存发送，
+// 正文不经过用户态缓冲区。
+
+#define BUF_CHUNK_SIZE 16384
+
+typedef struct buf {
+    atomic_int refs;
+    int size;               // data 容量
+    int pooled;             // 来自对象池（否则为单独 malloc）
+    char data[];
+} buf_t;
+
+// 缓冲区中的一段
+typedef struct buf_slice {
+    buf_t *buf;
+    int off;
+    int len;
+} buf_slice_t;
+
+// 引用计数的只读文件描述符，最后一个引用释放时调用 release（负责关闭 fd）
+typedef struct buf_file {
+    atomic_int refs;
+    int fd;
+    void (*release)(struct buf_file *file);
+} buf_file_t;
+
+// slice 链表节点：内存片段，或 file 非空时为文件中从 file_off 开始的 slice.len 字节
+typedef struct buf_seg {
+    struct buf_seg *next;
+    buf_slice_t slice;
+    buf_file_t *file;
+    off_t file_off;
+} buf_seg_t;
+
+// slice 链：响应数据（头 + 若干正文片段）
+typedef struct buf_chain {
+    buf_seg_t *head;
+    buf_seg_t *tail;
+    int count;
+    size_t bytes;
+} buf_chain_t;
+
+// 分配至少 size 字节的缓冲区（引用计数为 1）
+buf_t* buf_alloc(int size);
+
+// 分配恰好 size 字节的独立缓冲区，不占用线程对象池（用于长期持有的数据，如响应缓存）
+buf_t* buf_alloc_exact(int size);
+
+static inline buf_t* buf_ref(buf_t *buf) {
+    atomic_fetch_add_explicit(&buf->refs, 1, memory_order_relaxed);
+    return buf;
+}
+
+// 释放一个引用，归零时回收
+void buf_unref(buf_t *buf);
+
+static inline buf_file_t* buf_file_ref(buf_file_t *file) {
+    atomic_fetch_add_explicit(&file->refs, 1, memory_order_relaxed);
+    return file;
+}
+
+void buf_file_unref(buf_file_t *file);
+
+static inline char* buf_slice_data(const buf_slice_t *slice) {
+    return slice->buf->data + slice->off;
+}
+
+static inline void buf_chain_init(buf_chain_t *chain) {
+    chain->head = NULL;
+    chain->tail = NULL;
+    chain->count = 0;
+    chain->bytes = 0;
+}
+
+static inline int buf_chain_empty(const buf_chain_t *chain) {
+    return chain->head == NULL;
+}
+
+// 追加 buf[off, off+len)，链持有一个新引用
+int buf_chain_append(buf_chain_t *chain, buf_t *buf, int off, int len);
+
+// 追加文件 [off, off+len)，链持有一个新引用（超长时拆成多个片段）
+int buf_chain_append_file(buf_chain_t *chain, buf_file_t *file, off_t off, size_t len);
+
+// 将 src 的全部片段移动到 dst 末尾（src 变为空）
+void buf_chain_move(buf_chain_t *dst, buf_chain_t *src);
+
+// 从链头开始填充最多 max 个 iovec（遇到文件片段停止），返回个数
+int buf_chain_to_iov(const buf_chain_t *chain, struct iovec *iov, int max);
+
+// 向 fd 写出链头的一批数据：连续的内存片段一次 writev，文件片段一次 sendfile
+// 返回值同 writev（不消费链），*batch_bytes 为本批尝试写出的字节数，短写说明发送缓冲区已满
+ssize_t buf_chain_write(int fd, const buf_chain_t *chain, struct iovec *iov, int max,
+                        size_t *batch_bytes);
+
+// 丢弃已写出的前 n 字节（部分写后从断点继续）
+void buf_chain_consume(buf_chain_t *chain, size_t n);
+
+// 释放链上所有片段
+void buf_chain_clear(buf_chain_t *chain);
+
+#endif // BUFFER_H
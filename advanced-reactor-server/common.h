@@ -34,6 +34,43 @@
 #define BACKLOG 1024
 #define MAX_THREADS 16
 
+// 完成模式下 accept 出错（如 fd 耗尽）后，隔多久重新开始 accept（毫秒）
+#define ACCEPT_RETRY_MS 100
+
+#include "cpu_relax.h"
+#include "mpsc_queue.h"
+#include "buffer.h"
+#include "http.h"
+#include "timer_wheel.h"
+#include "log.h"
+
+// 独占缓存行，避免不同线程写入的字段伪共享
+#define CACHE_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
+
+// 按缓存行对齐分配并清零（含 CACHE_ALIGNED 成员的结构体不能用 malloc 分配），用 free 释放
+static inline void* cache_aligned_calloc(size_t count, size_t size) {
+    void *ptr = NULL;
+    size_t total = count * size;
+    if (posix_memalign(&ptr, CACHE_LINE_SIZE, total) != 0) return NULL;
+    memset(ptr, 0, total);
+    return ptr;
+}
+
+// 单写者统计计数器：只由所属线程递增（普通的读-加-写，没有锁也没有原子 RMW），
+// 任意线程可以随时读取，读到的值可能略有滞后
+typedef struct stat_counter {
+    atomic_long value;
+} stat_counter_t;
+
+static inline void stat_add(stat_counter_t *counter, long n) {
+    long value = atomic_load_explicit(&counter->value, memory_order_relaxed);
+    atomic_store_explicit(&counter->value, value + n, memory_order_relaxed);
+}
+
+static inline long stat_read(const stat_counter_t *counter) {
+    return atomic_load_explicit(&((stat_counter_t*)counter)->value, memory_order_relaxed);
+}
+
 // 连接状态
 typedef enum {
     CONN_STATE_CONNECTED,
@@ -43,56 +80,97 @@ typedef enum {
     CONN_STATE_CLOSED
 } conn_state_t;
 
-// 连接结构体
-typedef struct connection {
-    int fd;
-    void *event_loop;       // 所属的 event loop 实例 (was epoll_fd)
-    conn_state_t state;
-    char read_buf[BUFFER_SIZE];
-    char write_buf[BUFFER_SIZE];
-    int read_pos;
-    int write_pos;
-    int write_size;
-    struct sockaddr_in addr;
-    time_t last_active;
-    void *io_thread;        // 所属的 IO 线程
-    
-    // 线程安全相关
-    pthread_mutex_t conn_mutex;  // 连接互斥锁
-    int ref_count;               // 引用计数
-    int closing;                 // 正在关闭标志
-} connection_t;
+typedef struct connection connection_t;
 
 // 任务类型
 typedef enum {
     TASK_TYPE_READ,
     TASK_TYPE_WRITE,
     TASK_TYPE_PROCESS,
-    TASK_TYPE_CLOSE
+    TASK_TYPE_CLOSE,
+    TASK_TYPE_SERIAL        // 连接的串行执行器：依次执行该连接邮箱中的任务
 } task_type_t;
 
+// 任务结构体
+typedef struct task {
+    task_type_t type;
+    connection_t *conn;
+    buf_slice_t data;       // 请求数据（持有缓冲区引用，零拷贝）
+    unsigned long seq;      // 请求在连接上的序号，响应按序号顺序发送
+    uint64_t start_ns;      // 请求成帧（提交）时间，用于统计排队和端到端延迟
+    mpsc_node_t node;       // 连接任务邮箱中的侵入式节点
+    struct task *next;
+} task_t;
+
+// 连接结构体
+struct connection {
+    int fd;
+    void *event_loop;       // 所属的 event loop 实例 (was epoll_fd)
+    conn_state_t state;
+    buf_t *read_buf;        // 当前读缓冲区（IO 线程独占写入，已成帧的请求以 slice 交给工作线程）
+    int read_start;         // 尚未成帧的请求起点
+    int read_pos;           // 已读入数据的末尾
+    http_parser_t parser;   // read_start 处请求的分帧状态
+    buf_chain_t out;        // 待发送的响应数据（输出所有者独占）
+    int write_armed;        // 已注册可写事件（输出未写完，读事件暂停，IO 线程独占）
+    int flush_queued;       // 已在 IO 线程的待发送列表中
+    struct connection *flush_next;
+    
+    // 输出所有权：out、reorder、resp_seq 和 out_*_ns 同一时刻只属于一个线程（见 CONN_OUTPUT_*）
+    atomic_int output_owner;
+    
+    // 流水线请求的响应顺序（req_seq 由 IO 线程独占，其余归输出所有者）
+    unsigned long req_seq;          // 下一个请求的序号
+    atomic_ulong resp_seq;          // 下一个应发送的响应序号（IO 线程计算超时时无锁读取）
+    struct io_message *reorder;     // 提前完成的响应，按序号升序
+    uint64_t out_ready_ns;          // 输出链从空变为非空的时间（0 表示无待统计的响应）
+    uint64_t out_req_ns;            // 该批第一个响应对应请求的成帧时间
+    struct sockaddr_in addr;
+    
+    // 超时（IO 线程独占，时间取自 IO 线程每轮缓存的时钟，单位毫秒）
+    uint64_t last_active;        // 最近一次读写有进展的时间
+    uint64_t request_start;      // 当前未完成请求的开始时间
+    tw_timer_t timer;            // 在所属 IO 线程时间轮上的超时定时器
+    void *io_thread;        // 所属的 IO 线程
+    
+    // 串行执行：同一连接的任务按提交顺序执行，同一时刻最多一个 worker
+    mpsc_queue_t tasks;          // 待执行的任务（任意线程投递，执行器独占消费）
+    atomic_int task_pending;     // 已投递未执行完的任务数，0 -> 1 时调度执行器
+    task_t runner;               // 内嵌的执行器任务，不从对象池分配
+    
+    // 生命周期（无锁）：引用计数归零时释放；closing 只会从 0 变为 1，
+    // 把它置 1 的线程负责关闭 fd，此后其它线程不得再使用 fd
+    atomic_int ref_count;
+    atomic_int closing;
+    struct connection *release_next;  // IO 线程本轮事件处理结束后再释放的连接
+};
+
+// 连接输出所有者
+// 没有待发送的输出时为 FREE，工作线程可以抢到 WORKER 后直接 writev，写完放回 FREE；
+// IO 线程要动输出状态时先取得 IO（工作线程正在写时短暂等待），输出全部写完后放回 FREE。
+// 连接关闭时所有权永久留在 IO，此后工作线程不会再直接写这个 fd
+#define CONN_OUTPUT_FREE   0
+#define CONN_OUTPUT_IO     1
+#define CONN_OUTPUT_WORKER 2
+
 // IO线程消息类型
 typedef enum {
     IO_MSG_RESPONSE_READY,  // 响应准备就绪，需要切换到EPOLLOUT
-    IO_MSG_CLOSE_CONN       // 关闭连接
+    IO_MSG_CLOSE_CONN,      // 关闭连接
+    IO_MSG_FLUSH            // 工作线程直接写没写完，剩余输出连同所有权交给 IO 线程
 } io_msg_type_t;
 
 // IO线程消息结构
 typedef struct io_message {
+    mpsc_node_t node;       // IO 线程邮箱中的侵入式节点
     io_msg_type_t type;
     connection_t *conn;
-    struct io_message *next;
+    unsigned long seq;      // 响应对应的请求序号
+    uint64_t req_ns;        // 请求成帧时间
+    buf_chain_t chain;      // IO_MSG_RESPONSE_READY 携带的响应数据
+    struct io_message *next;  // 连接的乱序响应链表
 } io_message_t;
 
-// 任务结构体
-typedef struct task {
-    task_type_t type;
-    connection_t *conn;
-    void *data;
-    int data_len;
-    struct task *next;
-} task_t;
-
 // 设置非阻塞
 static inline int set_nonblocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
@@ -104,17 +182,18 @@ static inline int set_nonblocking(int fd) {
 #define handle_error(msg) \
     do { perror(msg); exit(EXIT_FAILURE); } while (0)
 
-#define log_info(fmt, ...) \
-    printf("[INFO] " fmt "\n", ##__VA_ARGS__)
-
-#define log_error(fmt, ...) \
-    fprintf(stderr, "[ERROR] " fmt "\n", ##__VA_ARGS__)
-
-// 连接管理函数
-connection_t* conn_create(int fd, void *event_loop, struct sockaddr_in *addr, void *io_thread);
+// 连接管理函数（连接对象从所属 IO 线程的对象池分配）
+struct object_pool;
+connection_t* conn_create(int fd, void *event_loop, struct sockaddr_in *addr, void *io_thread,
+                          struct object_pool *pool);
 void conn_acquire(connection_t *conn);
 void conn_release(connection_t *conn);
 int conn_is_valid(connection_t *conn);
 void conn_mark_closing(connection_t *conn);
 
+// 输出所有权（见 CONN_OUTPUT_*）
+int conn_output_try_acquire(connection_t *conn);   // 工作线程：FREE -> WORKER，失败返回 0
+void conn_output_acquire(connection_t *conn);      // IO 线程：取得 IO，工作线程正在写时等待
+void conn_output_release(connection_t *conn);      // 放回 FREE
+
 #endif // COMMON_H
\ No newline at end of file
@@ -1,90 +1,130 @@
 // connection.c
 #include "common.h"
+#include "object_pool.h"
+#include <sched.h>
 
-// 创建连接对象
-connection_t* conn_create(int fd, void *event_loop, struct sockaddr_in *addr, void *io_thread) {
-    connection_t *conn = (connection_t*)malloc(sizeof(connection_t));
+// 等待工作线程交还输出所有权时，自旋多少次后让出 CPU
+#define OUTPUT_SPIN_LIMIT 64
+
+// 创建连接对象（必须在 pool 的所有者线程调用）
+connection_t* conn_create(int fd, void *event_loop, struct sockaddr_in *addr, void *io_thread,
+                          struct object_pool *pool) {
+    connection_t *conn = (connection_t*)object_pool_alloc(pool);
     if (!conn) return NULL;
     
     conn->fd = fd;
     conn->event_loop = event_loop;
     conn->state = CONN_STATE_CONNECTED;
+    conn->read_buf = NULL;
+    conn->read_start = 0;
     conn->read_pos = 0;
-    conn->write_pos = 0;
-    conn->write_size = 0;
+    http_parser_reset(&conn->parser);
+    buf_chain_init(&conn->out);
+    conn->write_armed = 0;
+    conn->flush_queued = 0;
+    conn->flush_next = NULL;
+    atomic_init(&conn->output_owner, CONN_OUTPUT_FREE);
+    conn->req_seq = 0;
+    atomic_init(&conn->resp_seq, 0);
+    conn->reorder = NULL;
+    conn->out_ready_ns = 0;
+    conn->out_req_ns = 0;
     if (addr) {
         conn->addr = *addr;
     } else {
         memset(&conn->addr, 0, sizeof(conn->addr));
     }
-    conn->last_active = time(NULL);
+    conn->last_active = 0;
+    conn->request_start = 0;
+    tw_timer_init(&conn->timer, NULL, conn);
     conn->io_thread = io_thread;
-    conn->ref_count = 1;  // 初始引用计数为1
-    conn->closing = 0;
-    
-    // 初始化互斥锁
-    if (pthread_mutex_init(&conn->conn_mutex, NULL) != 0) {
-        free(conn);
-        return NULL;
-    }
+    mpsc_queue_init(&conn->tasks);
+    atomic_init(&conn->task_pending, 0);
+    memset(&conn->runner, 0, sizeof(conn->runner));
+    conn->runner.type = TASK_TYPE_SERIAL;
+    conn->runner.conn = conn;
+    atomic_init(&conn->ref_count, 1);  // 初始引用计数为1
+    atomic_init(&conn->closing, 0);
+    conn->release_next = NULL;
     
     return conn;
 }
 
-// 增加连接引用计数
+// 增加连接引用计数（调用方已持有引用，只需保证原子性）
 void conn_acquire(connection_t *conn) {
     if (!conn) return;
     
-    pthread_mutex_lock(&conn->conn_mutex);
-    conn->ref_count++;
-    pthread_mutex_unlock(&conn->conn_mutex);
+    atomic_fetch_add_explicit(&conn->ref_count, 1, memory_order_relaxed);
 }
 
 // 减少连接引用计数，当计数为0时释放连接
+// release 保证本线程此前对连接的写入在释放前可见，归零的线程再以 acquire 与之同步
 void conn_release(connection_t *conn) {
     if (!conn) return;
     
-    pthread_mutex_lock(&conn->conn_mutex);
-    conn->ref_count--;
-    int should_free = (conn->ref_count <= 0);
-    pthread_mutex_unlock(&conn->conn_mutex);
+    if (atomic_fetch_sub_explicit(&conn->ref_count, 1, memory_order_release) != 1) {
+        return;
+    }
+    atomic_thread_fence(memory_order_acquire);
     
-    if (should_free) {
-        // 确保文件描述符已关闭 (可能已在 conn_mark_closing 中关闭)
-        if (conn->fd >= 0) {
-            close(conn->fd);
-            conn->fd = -1;
-        }
-        
-        pthread_mutex_destroy(&conn->conn_mutex);
-        free(conn);
+    // 确保文件描述符已关闭 (可能已在 conn_mark_closing 中关闭)
+    if (conn->fd >= 0) {
+        close(conn->fd);
+        conn->fd = -1;
     }
+    
+    buf_unref(conn->read_buf);
+    buf_chain_clear(&conn->out);
+    
+    // 归还到分配它的 IO 线程的对象池（可能在工作线程上释放）
+    object_pool_free(conn);
 }
 
 // 检查连接是否有效（未被标记为关闭）
 int conn_is_valid(connection_t *conn) {
     if (!conn) return 0;
     
-    pthread_mutex_lock(&conn->conn_mutex);
-    int valid = !conn->closing && conn->state != CONN_STATE_CLOSED;
-    pthread_mutex_unlock(&conn->conn_mutex);
-    
-    return valid;
+    return !atomic_load_explicit(&conn->closing, memory_order_acquire);
 }
 
-// 标记连接为正在关闭
+// 标记连接为正在关闭：只有第一次调用生效并关闭 fd
+// 关闭前取得输出所有权，等正在直接写的工作线程写完，fd 不会在 writev 途中被关闭或复用
 void conn_mark_closing(connection_t *conn) {
     if (!conn) return;
     
-    pthread_mutex_lock(&conn->conn_mutex);
-    if (!conn->closing) {  // Only mark once
-        conn->closing = 1;
-        conn->state = CONN_STATE_CLOSING;
-        // Close the fd here to prevent further events
+    if (atomic_exchange_explicit(&conn->closing, 1, memory_order_acq_rel) == 0) {
+        conn_output_acquire(conn);
         if (conn->fd >= 0) {
             close(conn->fd);
             conn->fd = -1;
         }
     }
-    pthread_mutex_unlock(&conn->conn_mutex);
-}
\ No newline at end of file
+}
+
+int conn_output_try_acquire(connection_t *conn) {
+    int expected = CONN_OUTPUT_FREE;
+    return atomic_compare_exchange_strong_explicit(&conn->output_owner, &expected, CONN_OUTPUT_WORKER,
+                                                   memory_order_acquire, memory_order_relaxed);
+}
+
+void conn_output_acquire(connection_t *conn) {
+    int spins = 0;
+    while (1) {
+        int expected = CONN_OUTPUT_FREE;
+        if (atomic_compare_exchange_weak_explicit(&conn->output_owner, &expected, CONN_OUTPUT_IO,
+                                                  memory_order_acquire, memory_order_acquire) ||
+            expected == CONN_OUTPUT_IO) {
+            break;
+        }
+        
+        // 工作线程只持有一次非阻塞 writev 的时间；它被调度走时让出 CPU
+        if (++spins >= OUTPUT_SPIN_LIMIT) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+void conn_output_release(connection_t *conn) {
+    atomic_store_explicit(&conn->output_owner, CONN_OUTPUT_FREE, memory_order_release);
+}
@@ -0,0 +1,314 @@
+// cpu_affinity.c
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "cpu_affinity.h"
+
+#define SYSFS_CPU  "/sys/devices/system/cpu"
+#define SYSFS_NODE "/sys/devices/system/node"
+
+// 扫描的 NUMA 节点号和缓存层级目录上限
+#define MAX_NODES        256
+#define MAX_CACHE_INDEX  16
+
+// 调用线程的分组，worker 选择和 IO 线程配对时使用
+static __thread int tls_cpu_group = -1;
+
+int cpu_mask_count(const cpu_mask_t *mask) {
+    int count = 0;
+    for (int i = 0; i < CPU_MASK_WORDS; i++) {
+        count += __builtin_popcountll(mask->bits[i]);
+    }
+    return count;
+}
+
+int cpu_list_parse(const char *list, cpu_mask_t *mask) {
+    memset(mask, 0, sizeof(*mask));
+    if (!list) return -1;
+    
+    const char *p = list;
+    while (*p && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0 || first >= CPU_MAX_CPUS) return -1;
+        
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first || last >= CPU_MAX_CPUS) return -1;
+            p = end;
+        }
+        
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpu_mask_set(mask, (int)cpu);
+        }
+        
+        if (*p == ',') {
+            p++;
+        } else if (*p && *p != '\n') {
+            return -1;
+        }
+    }
+    
+    return cpu_mask_count(mask) > 0 ? 0 : -1;
+}
+
+void cpu_mask_format(const cpu_mask_t *mask, char *buf, int size) {
+    int len = 0;
+    buf[0] = '\0';
+    
+    for (int cpu = 0; cpu < CPU_MAX_CPUS && len < size; cpu++) {
+        if (!cpu_mask_isset(mask, cpu)) continue;
+        
+        int last = cpu;
+        while (last + 1 < CPU_MAX_CPUS && cpu_mask_isset(mask, last + 1)) {
+            last++;
+        }
+        
+        if (last == cpu) {
+            len += snprintf(buf + len, size - len, "%s%d", len ? "," : "", cpu);
+        } else {
+            len += snprintf(buf + len, size - len, "%s%d-%d", len ? "," : "", cpu, last);
+        }
+        cpu = last;
+    }
+}
+
+#ifdef __linux__
+
+static int read_line(const char *path, char *buf, int size) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    
+    int ok = fgets(buf, size, f) != NULL;
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+static int mask_first(const cpu_mask_t *mask) {
+    for (int cpu = 0; cpu < CPU_MAX_CPUS; cpu++) {
+        if (cpu_mask_isset(mask, cpu)) return cpu;
+    }
+    return -1;
+}
+
+// 末级缓存标识：共享最高层缓存的第一个 CPU；没有缓存信息时退回物理封装编号
+static int read_llc(int cpu) {
+    char path[128], line[4096];
+    int best_level = 0, llc = -1;
+    
+    for (int index = 0; index < MAX_CACHE_INDEX; index++) {
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/level", cpu, index);
+        if (read_line(path, line, sizeof(line)) != 0) break;
+        
+        int level = atoi(line);
+        if (level <= best_level) continue;
+        
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+        cpu_mask_t shared;
+        if (read_line(path, line, sizeof(line)) == 0 && cpu_list_parse(line, &shared) == 0) {
+            best_level = level;
+            llc = mask_first(&shared);
+        }
+    }
+    if (llc >= 0) return llc;
+    
+    snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+    if (read_line(path, line, sizeof(line)) == 0) {
+        return CPU_MAX_CPUS + atoi(line);
+    }
+    return 0;
+}
+
+typedef struct cpu_entry {
+    int cpu;
+    int node;
+    int llc;
+} cpu_entry_t;
+
+static int compare_entry(const void *a, const void *b) {
+    const cpu_entry_t *x = (const cpu_entry_t*)a, *y = (const cpu_entry_t*)b;
+    if (x->node != y->node) return x->node - y->node;
+    if (x->llc != y->llc) return x->llc - y->llc;
+    return x->cpu - y->cpu;
+}
+
+int cpu_topology_detect(cpu_topology_t *topo) {
+    memset(topo, 0, sizeof(*topo));
+    
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return -1;
+    
+    // CPU -> NUMA 节点（没有 node 目录的系统视为单节点）
+    static int node_of[CPU_MAX_CPUS];
+    memset(node_of, 0, sizeof(node_of));
+    for (int node = 0; node < MAX_NODES; node++) {
+        char path[128], line[4096];
+        cpu_mask_t cpus;
+        snprintf(path, sizeof(path), SYSFS_NODE "/node%d/cpulist", node);
+        if (read_line(path, line, sizeof(line)) != 0 || cpu_list_parse(line, &cpus) != 0) continue;
+        
+        for (int cpu = 0; cpu < CPU_MAX_CPUS; cpu++) {
+            if (cpu_mask_isset(&cpus, cpu)) {
+                node_of[cpu] = node;
+            }
+        }
+    }
+    
+    static cpu_entry_t entries[CPU_MAX_CPUS];
+    int count = 0;
+    for (int cpu = 0; cpu < CPU_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        
+        entries[count].cpu = cpu;
+        entries[count].node = node_of[cpu];
+        entries[count].llc = read_llc(cpu);
+        count++;
+    }
+    if (count == 0) return -1;
+    
+    qsort(entries, count, sizeof(cpu_entry_t), compare_entry);
+    
+    int group = -1;
+    for (int i = 0; i < count; i++) {
+        if (i == 0 || entries[i].node != entries[i - 1].node || entries[i].llc != entries[i - 1].llc) {
+            group++;
+        }
+        topo->cpus[i].cpu = entries[i].cpu;
+        topo->cpus[i].node = entries[i].node;
+        topo->cpus[i].group = group;
+    }
+    topo->count = count;
+    topo->group_count = group + 1;
+    return 0;
+}
+
+int thread_placement_apply(const thread_placement_t *placement) {
+    if (!placement || cpu_mask_count(&placement->cpus) == 0) return 0;
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < CPU_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+        if (cpu_mask_isset(&placement->cpus, cpu)) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) return -1;
+    
+    tls_cpu_group = placement->group;
+    return 0;
+}
+
+#else
+
+int cpu_topology_detect(cpu_topology_t *topo) {
+    memset(topo, 0, sizeof(*topo));
+    return -1;
+}
+
+int thread_placement_apply(const thread_placement_t *placement) {
+    (void)placement;
+    return 0;
+}
+
+#endif
+
+int cpu_current_group(void) {
+    return tls_cpu_group;
+}
+
+static const cpu_info_t* topology_find(const cpu_topology_t *topo, int cpu) {
+    if (!topo) return NULL;
+    
+    for (int i = 0; i < topo->count; i++) {
+        if (topo->cpus[i].cpu == cpu) return &topo->cpus[i];
+    }
+    return NULL;
+}
+
+// 绑定到单个 CPU
+static void place_on_cpu(thread_placement_t *placement, const cpu_topology_t *topo, int cpu) {
+    memset(placement, 0, sizeof(*placement));
+    cpu_mask_set(&placement->cpus, cpu);
+    
+    const cpu_info_t *info = topology_find(topo, cpu);
+    placement->node = info ? info->node : -1;
+    placement->group = info ? info->group : -1;
+}
+
+// 列表中的第 index 个 CPU（循环使用）
+static int mask_nth(const cpu_mask_t *mask, int index) {
+    int count = cpu_mask_count(mask);
+    index %= count;
+    
+    for (int cpu = 0; cpu < CPU_MAX_CPUS; cpu++) {
+        if (cpu_mask_isset(mask, cpu) && index-- == 0) return cpu;
+    }
+    return -1;
+}
+
+// 拓扑中第 group 组的第 index 个 CPU（循环使用）
+static int group_nth(const cpu_topology_t *topo, int group, int index) {
+    int first = -1, size = 0;
+    for (int i = 0; i < topo->count; i++) {
+        if (topo->cpus[i].group == group) {
+            if (first < 0) first = i;
+            size++;
+        }
+    }
+    return topo->cpus[first + index % size].cpu;
+}
+
+int affinity_plan(const affinity_config_t *config, const cpu_topology_t *topo,
+                  int io_threads, thread_placement_t *io,
+                  int worker_threads, thread_placement_t *workers) {
+    int manual_io = cpu_mask_count(&config->io_cpus) > 0;
+    int manual_workers = cpu_mask_count(&config->worker_cpus) > 0;
+    
+    // 自动放置需要拓扑
+    if ((!manual_io || !manual_workers) && (!topo || topo->count == 0)) return -1;
+    
+    // IO 线程：轮流落在各组上，每个线程一个 CPU
+    cpu_mask_t io_used;
+    memset(&io_used, 0, sizeof(io_used));
+    for (int i = 0; i < io_threads; i++) {
+        int cpu = manual_io ? mask_nth(&config->io_cpus, i)
+                            : group_nth(topo, i % topo->group_count, i / topo->group_count);
+        place_on_cpu(&io[i], topo, cpu);
+        cpu_mask_set(&io_used, cpu);
+    }
+    
+    // worker：按编号与 IO 线程配对，放到配对 IO 线程所在组里 IO 线程没占用的 CPU 上
+    for (int j = 0; j < worker_threads; j++) {
+        if (manual_workers) {
+            place_on_cpu(&workers[j], topo, mask_nth(&config->worker_cpus, j));
+            continue;
+        }
+        
+        thread_placement_t *w = &workers[j];
+        const thread_placement_t *pair = &io[j % io_threads];
+        memset(w, 0, sizeof(*w));
+        w->node = pair->node;
+        w->group = pair->group;
+        if (pair->group < 0) continue;
+        
+        for (int pass = 0; pass < 2 && cpu_mask_count(&w->cpus) == 0; pass++) {
+            for (int i = 0; i < topo->count; i++) {
+                const cpu_info_t *info = &topo->cpus[i];
+                // 第一遍避开 IO 线程的 CPU；组内全被 IO 线程占用时第二遍共用整组
+                if (info->group == pair->group && (pass == 1 || !cpu_mask_isset(&io_used, info->cpu))) {
+                    cpu_mask_set(&w->cpus, info->cpu);
+                }
+            }
+        }
+    }
+    
+    return 0;
+}
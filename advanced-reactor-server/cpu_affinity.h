@@ -0,0 +1,80 @@
+// cpu_affinity.h
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <stdint.h>
+
+// CPU 拓扑与线程放置（仅 Linux 生效，其它平台不绑定）
+//
+// 从 /sys 读取每个可用 CPU 所属的 NUMA 节点和末级缓存（LLC），按 (节点, LLC) 把 CPU 分组。
+// 自动放置时 IO 线程轮流落在各组上，每个 IO 线程绑定一个 CPU；worker 按编号与 IO 线程配对，
+// 绑定到配对 IO 线程所在组的其余 CPU 上。也可以手动给出 IO 线程和 worker 的 CPU 列表。
+//
+// 内存不显式按节点分配，而是依赖 Linux 的首次写入（first-touch）策略：线程先绑定再预分配
+// 连接对象池、任务/消息/缓冲区对象池，这些内存都由所属线程首次写入，落在本节点上。
+
+#define CPU_MAX_CPUS   1024
+#define CPU_MASK_WORDS (CPU_MAX_CPUS / 64)
+
+typedef struct cpu_mask {
+    uint64_t bits[CPU_MASK_WORDS];
+} cpu_mask_t;
+
+static inline void cpu_mask_set(cpu_mask_t *mask, int cpu) {
+    mask->bits[cpu / 64] |= 1ULL << (cpu % 64);
+}
+
+static inline int cpu_mask_isset(const cpu_mask_t *mask, int cpu) {
+    return (mask->bits[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+int cpu_mask_count(const cpu_mask_t *mask);
+
+// 解析 CPU 列表（如 "0-3,8,10-11"），成功返回 0
+int cpu_list_parse(const char *list, cpu_mask_t *mask);
+
+// 一个可用 CPU 的位置
+typedef struct cpu_info {
+    int cpu;
+    int node;       // NUMA 节点
+    int group;      // (节点, LLC) 分组下标，从 0 开始
+} cpu_info_t;
+
+typedef struct cpu_topology {
+    int count;
+    int group_count;
+    cpu_info_t cpus[CPU_MAX_CPUS];  // 本进程允许运行的 CPU，按分组排序
+} cpu_topology_t;
+
+// 读取本进程可用 CPU 的拓扑，失败（或非 Linux）返回 -1
+int cpu_topology_detect(cpu_topology_t *topo);
+
+// 线程放置（cpus 为空表示不绑定）
+typedef struct thread_placement {
+    cpu_mask_t cpus;
+    int node;       // -1 表示未知
+    int group;      // -1 表示未知
+} thread_placement_t;
+
+// 放置配置：enabled 时按拓扑自动放置，CPU 列表非空时改用列表中的 CPU
+typedef struct affinity_config {
+    int enabled;
+    cpu_mask_t io_cpus;
+    cpu_mask_t worker_cpus;
+} affinity_config_t;
+
+// 为 IO 线程和 worker 计算放置，成功返回 0
+int affinity_plan(const affinity_config_t *config, const cpu_topology_t *topo,
+                  int io_threads, thread_placement_t *io,
+                  int worker_threads, thread_placement_t *workers);
+
+// 绑定调用线程并记录它的分组；placement 为 NULL 或不绑定时什么也不做
+int thread_placement_apply(const thread_placement_t *placement);
+
+// 调用线程的分组（未绑定为 -1）
+int cpu_current_group(void);
+
+// 格式化为 CPU 列表字符串
+void cpu_mask_format(const cpu_mask_t *mask, char *buf, int size);
+
+#endif // CPU_AFFINITY_H
@@ -0,0 +1,17 @@
+// cpu_relax.h
+#ifndef CPU_RELAX_H
+#define CPU_RELAX_H
+
+// 缓存行大小，用于填充和对齐
+#define CACHE_LINE_SIZE 64
+
+// 自旋等待时让出流水线
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#endif // CPU_RELAX_H
@@ -1,24 +1,83 @@
 #include <stdlib.h>
+#include <string.h>
 #include "event_loop.h"
 
 // Platform-specific backend selection
 #ifdef __linux__
 extern const event_loop_ops_t epoll_ops;
+extern const event_loop_ops_t io_uring_ops;
 #elif defined(__APPLE__)
 extern const event_loop_ops_t kqueue_ops;
 #else
 #error "Unsupported platform"
 #endif
 
+// Backends available on this platform, the first one is the default
+static const event_loop_ops_t *const available_backends[] = {
+#ifdef __linux__
+    &epoll_ops,
+    &io_uring_ops,
+#elif defined(__APPLE__)
+    &kqueue_ops,
+#endif
+};
+
+static const event_loop_ops_t *selected_ops = NULL;
+static int completions_enabled = 0;
+
+static const event_loop_ops_t* default_ops(void) {
+    return selected_ops ? selected_ops : available_backends[0];
+}
+
+int event_loop_set_backend(const char *name) {
+    if (!name) return -1;
+    
+    size_t count = sizeof(available_backends) / sizeof(available_backends[0]);
+    for (size_t i = 0; i < count; i++) {
+        const event_loop_ops_t *ops = available_backends[i];
+        if (strcmp(ops->name, name) != 0) continue;
+        
+        // Probe once so an unsupported kernel fails at startup, not per thread
+        event_loop_t probe = { .impl = NULL, .ops = ops, .max_events = 0 };
+        if (ops->create(&probe, 1) < 0) return -1;
+        ops->destroy(&probe);
+        
+        selected_ops = ops;
+        return 0;
+    }
+    
+    return -1;
+}
+
+const char* event_loop_backend_name(void) {
+    return default_ops()->name;
+}
+
+int event_loop_set_completions(int enable) {
+    const event_loop_ops_t *ops = default_ops();
+    if (enable && (!ops->recv_start || !ops->accept_start)) return -1;
+    
+    // Probe with the completion resources (e.g. buffer rings) the loops will set up
+    if (enable) {
+        event_loop_t probe = { .impl = NULL, .ops = ops, .max_events = 0, .completions = 1 };
+        if (ops->create(&probe, 1) < 0) return -1;
+        ops->destroy(&probe);
+    }
+    
+    completions_enabled = enable;
+    return 0;
+}
+
+int event_loop_completions(void) {
+    return completions_enabled;
+}
+
 event_loop_t* event_loop_create(int max_events) {
     event_loop_t *loop = calloc(1, sizeof(event_loop_t));
     if (!loop) return NULL;
     
-#ifdef __linux__
-    loop->ops = &epoll_ops;
-#elif defined(__APPLE__)
-    loop->ops = &kqueue_ops;
-#endif
+    loop->ops = default_ops();
+    loop->completions = completions_enabled;
     
     if (loop->ops->create(loop, max_events) < 0) {
         free(loop);
@@ -53,7 +112,26 @@ int event_loop_del(event_loop_t *loop, int fd) {
     return loop->ops->del(loop, fd);
 }
 
+int event_loop_recv_start(event_loop_t *loop, int fd, void *data) {
+    if (!loop || !loop->completions || !loop->ops->recv_start) return -1;
+    return loop->ops->recv_start(loop, fd, data);
+}
+
+int event_loop_recv_stop(event_loop_t *loop, int fd) {
+    if (!loop || !loop->completions || !loop->ops->recv_stop) return -1;
+    return loop->ops->recv_stop(loop, fd);
+}
+
+int event_loop_accept_start(event_loop_t *loop, int fd, void *data) {
+    if (!loop || !loop->completions || !loop->ops->accept_start) return -1;
+    return loop->ops->accept_start(loop, fd, data);
+}
+
 int event_loop_wait(event_loop_t *loop, event_t *events, int max_events, int timeout) {
+    return event_loop_wait_us(loop, events, max_events, timeout < 0 ? -1 : (long)timeout * 1000);
+}
+
+int event_loop_wait_us(event_loop_t *loop, event_t *events, int max_events, long timeout_us) {
     if (!loop || !loop->ops || !loop->ops->wait) return -1;
-    return loop->ops->wait(loop, events, max_events, timeout);
+    return loop->ops->wait(loop, events, max_events, timeout_us < 0 ? -1 : timeout_us);
 }
\ No newline at end of file
@@ -11,6 +11,8 @@
 #define EVENT_HUP     0x08
 #define EVENT_RDHUP   0x10
 #define EVENT_ET      0x20  // Edge-triggered mode
+#define EVENT_RECV    0x40  // Completion: bytes already received into buf (result: length, 0 = EOF, <0 = -errno)
+#define EVENT_ACCEPT  0x80  // Completion: result is the accepted fd (<0 = -errno)
 
 // Forward declaration
 typedef struct event_loop event_loop_t;
@@ -20,16 +22,25 @@ typedef struct {
     void *data;      // User data pointer
     uint32_t events; // Event mask
     int fd;          // File descriptor
+    int result;      // EVENT_RECV / EVENT_ACCEPT only
+    const char *buf; // EVENT_RECV only, valid until the next wait on the same loop
 } event_t;
 
 // Event loop operations
 typedef struct event_loop_ops {
+    const char *name;
     int (*create)(event_loop_t *loop, int max_events);
     void (*destroy)(event_loop_t *loop);
     int (*add)(event_loop_t *loop, int fd, uint32_t events, void *data);
     int (*mod)(event_loop_t *loop, int fd, uint32_t events, void *data);
     int (*del)(event_loop_t *loop, int fd);
-    int (*wait)(event_loop_t *loop, event_t *events, int max_events, int timeout);
+    // timeout_us: microseconds, -1 blocks until an event arrives, 0 polls
+    int (*wait)(event_loop_t *loop, event_t *events, int max_events, long timeout_us);
+    // Optional completion-based I/O (NULL when the backend only reports readiness).
+    // Both stay armed until stopped or del(); results arrive as EVENT_RECV / EVENT_ACCEPT.
+    int (*recv_start)(event_loop_t *loop, int fd, void *data);
+    int (*recv_stop)(event_loop_t *loop, int fd);
+    int (*accept_start)(event_loop_t *loop, int fd, void *data);
 } event_loop_ops_t;
 
 // Event loop structure
@@ -37,6 +48,7 @@ struct event_loop {
     void *impl;                  // Platform-specific implementation
     const event_loop_ops_t *ops; // Operation table
     int max_events;              // Maximum events to handle
+    int completions;             // Created with completion-based I/O enabled
 };
 
 // Public API
@@ -46,9 +58,27 @@ int event_loop_add(event_loop_t *loop, int fd, uint32_t events, void *data);
 int event_loop_mod(event_loop_t *loop, int fd, uint32_t events, void *data);
 int event_loop_del(event_loop_t *loop, int fd);
 int event_loop_wait(event_loop_t *loop, event_t *events, int max_events, int timeout);
+// Same as event_loop_wait() with a microsecond timeout (-1 blocks indefinitely)
+int event_loop_wait_us(event_loop_t *loop, event_t *events, int max_events, long timeout_us);
 
-// Platform-specific implementations (defined in event_loop_epoll.c or event_loop_kqueue.c)
+// Completion-based I/O, only when event_loop_completions() is on:
+// recv_start keeps receiving into backend-owned buffers (recv_stop pauses it),
+// accept_start keeps accepting on a listen socket; an accept error (EVENT_ACCEPT
+// with result < 0) also stops it until accept_start is called again
+int event_loop_recv_start(event_loop_t *loop, int fd, void *data);
+int event_loop_recv_stop(event_loop_t *loop, int fd);
+int event_loop_accept_start(event_loop_t *loop, int fd, void *data);
+
+// Backend selection (applies to loops created afterwards)
+int event_loop_set_backend(const char *name);
+const char* event_loop_backend_name(void);
+// Enable completion-based I/O for loops created afterwards; fails if the backend lacks it
+int event_loop_set_completions(int enable);
+int event_loop_completions(void);
+
+// Platform-specific implementations (defined in event_loop_epoll.c, event_loop_uring.c or event_loop_kqueue.c)
 extern const event_loop_ops_t epoll_ops;
+extern const event_loop_ops_t io_uring_ops;
 extern const event_loop_ops_t kqueue_ops;
 
 #endif // EVENT_LOOP_H
\ No newline at end of file
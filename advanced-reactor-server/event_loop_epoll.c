@@ -1,6 +1,8 @@
 #ifdef __linux__
 
 #include <stdlib.h>
+#include <limits.h>
+#include <time.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
@@ -100,11 +102,38 @@ static int epoll_del_impl(event_loop_t *loop, int fd) {
     return epoll_ctl(impl->epfd, EPOLL_CTL_DEL, fd, NULL);
 }
 
-static int epoll_wait_impl(event_loop_t *loop, event_t *events, int max_events, int timeout) {
+// epoll_pwait2() (glibc 2.35+, kernel 5.11+) takes a timespec, so sub-millisecond
+// timeouts are not rounded up to a whole millisecond
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35))
+#define HAVE_EPOLL_PWAIT2 1
+static int pwait2_unsupported = 0;
+#endif
+
+static int epoll_wait_timed(epoll_impl_t *impl, int max_events, long timeout_us) {
+    if (timeout_us < 0) {
+        return epoll_wait(impl->epfd, impl->events, max_events, -1);
+    }
+    
+#ifdef HAVE_EPOLL_PWAIT2
+    if (timeout_us % 1000 != 0 && !__atomic_load_n(&pwait2_unsupported, __ATOMIC_RELAXED)) {
+        struct timespec ts = { timeout_us / 1000000, (timeout_us % 1000000) * 1000 };
+        int n = epoll_pwait2(impl->epfd, impl->events, max_events, &ts, NULL);
+        if (n >= 0 || errno != ENOSYS) return n;
+        __atomic_store_n(&pwait2_unsupported, 1, __ATOMIC_RELAXED);
+    }
+#endif
+    
+    // Millisecond resolution: round up so a short timeout doesn't become a busy poll
+    long timeout_ms = (timeout_us + 999) / 1000;
+    return epoll_wait(impl->epfd, impl->events, max_events,
+                      timeout_ms > INT_MAX ? INT_MAX : (int)timeout_ms);
+}
+
+static int epoll_wait_impl(event_loop_t *loop, event_t *events, int max_events, long timeout_us) {
     if (!loop || !loop->impl || !events) return -1;
     
     epoll_impl_t *impl = (epoll_impl_t *)loop->impl;
-    int n = epoll_wait(impl->epfd, impl->events, max_events, timeout);
+    int n = epoll_wait_timed(impl, max_events, timeout_us);
     
     if (n > 0) {
         for (int i = 0; i < n; i++) {
@@ -119,6 +148,7 @@ static int epoll_wait_impl(event_loop_t *loop, event_t *events, int max_events,
 }
 
 const event_loop_ops_t epoll_ops = {
+    .name = "epoll",
     .create = epoll_create_impl,
     .destroy = epoll_destroy_impl,
     .add = epoll_add_impl,
@@ -121,15 +121,15 @@ static int kqueue_del_impl(event_loop_t *loop, int fd) {
     return ret < 0 ? -1 : 0;
 }
 
-static int kqueue_wait_impl(event_loop_t *loop, event_t *events, int max_events, int timeout) {
+static int kqueue_wait_impl(event_loop_t *loop, event_t *events, int max_events, long timeout_us) {
     if (!loop || !loop->impl || !events) return -1;
     
     kqueue_impl_t *impl = (kqueue_impl_t *)loop->impl;
     struct timespec ts, *pts = NULL;
     
-    if (timeout >= 0) {
-        ts.tv_sec = timeout / 1000;
-        ts.tv_nsec = (timeout % 1000) * 1000000;
+    if (timeout_us >= 0) {
+        ts.tv_sec = timeout_us / 1000000;
+        ts.tv_nsec = (timeout_us % 1000000) * 1000;
         pts = &ts;
     }
     
@@ -160,6 +160,7 @@ static int kqueue_wait_impl(event_loop_t *loop, event_t *events, int max_events,
 }
 
 const event_loop_ops_t kqueue_ops = {
+    .name = "kqueue",
     .create = kqueue_create_impl,
     .destroy = kqueue_destroy_impl,
     .add = kqueue_add_impl,
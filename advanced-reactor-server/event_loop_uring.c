@@ -0,0 +1,666 @@
+#ifdef __linux__
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "event_loop.h"
+
+// io_uring backend.
+//
+// Readiness is tracked with multishot IORING_OP_POLL_ADD requests, one per
+// registered fd. add/mod/del only queue SQEs; they are handed to the kernel
+// together with the wait in a single io_uring_enter() per loop iteration, so
+// registration changes no longer cost one epoll_ctl() each.
+//
+// Multishot poll fires on wakeups, so the backend always behaves as
+// edge-triggered; callers must drain fds until EAGAIN (they already do).
+//
+// Loops created with completions enabled also register a provided buffer
+// ring. recv_start() arms a multishot IORING_OP_RECV that picks buffers from
+// it, and accept_start() arms a multishot IORING_OP_ACCEPT, so steady-state
+// reads and accepts need no syscall of their own: their results are reaped
+// from the CQ ring as EVENT_RECV / EVENT_ACCEPT. Buffers handed out by one
+// wait() go back to the ring at the start of the next one.
+
+#define URING_SQ_ENTRIES   256
+#define URING_MIN_CQ       1024
+
+// Provided buffer ring for multishot recv (entries must be a power of two)
+#define URING_RECV_BGID      0
+#define URING_RECV_BUFS      256
+#define URING_RECV_BUF_SIZE  8192
+
+// user_data layout: bit 63 = ignore, bits 61-62 = request kind,
+// bits 32-60 = slot generation, low 32 bits = fd.
+// Completions of cancel requests are tagged and dropped.
+#define URING_UD_IGNORE    (1ULL << 63)
+#define URING_GEN_MASK     0x1fffffffu
+#define URING_KIND_SHIFT   61
+#define URING_UD(fd, gen)  (((uint64_t)((gen) & URING_GEN_MASK) << 32) | (uint32_t)(fd))
+
+// Request kinds; poll requests are kind 0
+#define URING_KIND_POLL    0
+#define URING_KIND_RECV    1
+#define URING_KIND_ACCEPT  2
+
+// Per-fd registration slot, indexed by fd
+typedef struct {
+    void *data;
+    uint32_t events;     // Registered generic events (0 = not registered)
+    uint32_t gen;        // Bumped on every (re)registration to detect stale CQEs
+    uint32_t batch;      // wait() call that last reported this fd
+    int batch_idx;       // Index in the events array for that call
+    
+    // Multishot recv / accept, independent of the poll registration
+    void *io_data;
+    uint32_t io_gen;     // Bumped on del() so completions still in flight go stale
+    uint8_t io_kind;     // URING_KIND_RECV / URING_KIND_ACCEPT, 0 = none
+    uint8_t io_armed;    // A multishot request is in flight
+    uint8_t io_canceling;// Its cancel has been queued
+    uint8_t io_want;     // Caller wants it running (re-armed when it ends)
+} uring_slot_t;
+
+typedef struct {
+    int ring_fd;
+    
+    // Submission queue
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned sq_local_tail;
+    struct io_uring_sqe *sqes;
+    
+    // Completion queue
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    
+    // Mappings
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    
+    uring_slot_t *slots;
+    int nslots;
+    uint32_t batch;
+    
+    // Provided buffer ring (completions only)
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_size;
+    char *recv_bufs;
+    unsigned short buf_tail;
+    unsigned short returns[URING_RECV_BUFS];   // Buffers to give back on the next wait
+    int nreturns;
+} uring_impl_t;
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                              unsigned flags, void *arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static uint32_t to_poll_events(uint32_t events) {
+    uint32_t poll_events = 0;
+    if (events & EVENT_READ) poll_events |= EPOLLIN;
+    if (events & EVENT_WRITE) poll_events |= EPOLLOUT;
+    if (events & EVENT_ERROR) poll_events |= EPOLLERR;
+    if (events & EVENT_HUP) poll_events |= EPOLLHUP;
+    if (events & EVENT_RDHUP) poll_events |= EPOLLRDHUP;
+    return poll_events;
+}
+
+static uint32_t from_poll_events(uint32_t poll_events) {
+    uint32_t events = 0;
+    if (poll_events & EPOLLIN) events |= EVENT_READ;
+    if (poll_events & EPOLLOUT) events |= EVENT_WRITE;
+    if (poll_events & EPOLLERR) events |= EVENT_ERROR;
+    if (poll_events & EPOLLHUP) events |= EVENT_HUP;
+    if (poll_events & EPOLLRDHUP) events |= EVENT_RDHUP;
+    return events;
+}
+
+static unsigned uring_sq_pending(uring_impl_t *impl) {
+    return impl->sq_local_tail - __atomic_load_n(impl->sq_head, __ATOMIC_ACQUIRE);
+}
+
+// Publish queued SQEs and enter the kernel
+static int uring_enter(uring_impl_t *impl, unsigned min_complete, unsigned flags,
+                       void *arg, size_t argsz) {
+    __atomic_store_n(impl->sq_tail, impl->sq_local_tail, __ATOMIC_RELEASE);
+    unsigned to_submit = uring_sq_pending(impl);
+    int ret = sys_io_uring_enter(impl->ring_fd, to_submit, min_complete, flags, arg, argsz);
+    if (ret < 0) return -errno;
+    return ret;
+}
+
+static struct io_uring_sqe* uring_get_sqe(uring_impl_t *impl) {
+    if (uring_sq_pending(impl) >= impl->sq_entries) {
+        // SQ full: flush what we have without waiting
+        int ret;
+        do {
+            ret = uring_enter(impl, 0, 0, NULL, 0);
+        } while (ret == -EINTR);
+        if (ret < 0 && ret != -EBUSY) return NULL;
+        if (uring_sq_pending(impl) >= impl->sq_entries) return NULL;
+    }
+    
+    unsigned idx = impl->sq_local_tail & *impl->sq_mask;
+    struct io_uring_sqe *sqe = &impl->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    impl->sq_array[idx] = idx;
+    impl->sq_local_tail++;
+    return sqe;
+}
+
+static int uring_queue_poll_add(uring_impl_t *impl, int fd, uring_slot_t *slot) {
+    struct io_uring_sqe *sqe = uring_get_sqe(impl);
+    if (!sqe) return -1;
+    
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = to_poll_events(slot->events) | EPOLLET;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = URING_UD(fd, slot->gen);
+    return 0;
+}
+
+static int uring_queue_poll_remove(uring_impl_t *impl, int fd, uring_slot_t *slot) {
+    struct io_uring_sqe *sqe = uring_get_sqe(impl);
+    if (!sqe) return -1;
+    
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = URING_UD(fd, slot->gen);
+    sqe->user_data = URING_UD_IGNORE;
+    return 0;
+}
+
+static int uring_queue_io(uring_impl_t *impl, int fd, uring_slot_t *slot) {
+    struct io_uring_sqe *sqe = uring_get_sqe(impl);
+    if (!sqe) return -1;
+    
+    sqe->fd = fd;
+    sqe->user_data = URING_UD(fd, slot->io_gen) | ((uint64_t)slot->io_kind << URING_KIND_SHIFT);
+    if (slot->io_kind == URING_KIND_RECV) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = URING_RECV_BGID;
+    } else {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    }
+    slot->io_armed = 1;
+    return 0;
+}
+
+static int uring_queue_io_cancel(uring_impl_t *impl, int fd, uring_slot_t *slot) {
+    struct io_uring_sqe *sqe = uring_get_sqe(impl);
+    if (!sqe) return -1;
+    
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = URING_UD(fd, slot->io_gen) | ((uint64_t)slot->io_kind << URING_KIND_SHIFT);
+    sqe->user_data = URING_UD_IGNORE;
+    slot->io_canceling = 1;
+    return 0;
+}
+
+// Drop the multishot recv / accept of a slot; its remaining completions go stale
+static void uring_io_forget(uring_impl_t *impl, int fd, uring_slot_t *slot) {
+    if (!slot->io_kind) return;
+    if (slot->io_armed && !slot->io_canceling) {
+        uring_queue_io_cancel(impl, fd, slot);
+    }
+    slot->io_gen++;
+    slot->io_kind = 0;
+    slot->io_armed = 0;
+    slot->io_canceling = 0;
+    slot->io_want = 0;
+    slot->io_data = NULL;
+}
+
+// Hand buffers consumed by the previous wait() back to the kernel
+static void uring_return_bufs(uring_impl_t *impl) {
+    if (impl->nreturns == 0) return;
+    
+    unsigned short tail = impl->buf_tail;
+    for (int i = 0; i < impl->nreturns; i++) {
+        unsigned short bid = impl->returns[i];
+        struct io_uring_buf *buf = &impl->buf_ring->bufs[tail & (URING_RECV_BUFS - 1)];
+        buf->addr = (uint64_t)(uintptr_t)(impl->recv_bufs + (size_t)bid * URING_RECV_BUF_SIZE);
+        buf->len = URING_RECV_BUF_SIZE;
+        buf->bid = bid;
+        tail++;
+    }
+    impl->buf_tail = tail;
+    impl->nreturns = 0;
+    __atomic_store_n(&impl->buf_ring->tail, tail, __ATOMIC_RELEASE);
+}
+
+static uring_slot_t* uring_slot(uring_impl_t *impl, int fd, int grow) {
+    if (fd < impl->nslots) return &impl->slots[fd];
+    if (!grow) return NULL;
+    
+    int nslots = impl->nslots ? impl->nslots : 1024;
+    while (nslots <= fd) nslots *= 2;
+    
+    uring_slot_t *slots = realloc(impl->slots, nslots * sizeof(uring_slot_t));
+    if (!slots) return NULL;
+    memset(slots + impl->nslots, 0, (nslots - impl->nslots) * sizeof(uring_slot_t));
+    
+    impl->slots = slots;
+    impl->nslots = nslots;
+    return &impl->slots[fd];
+}
+
+static void uring_unmap(uring_impl_t *impl) {
+    if (impl->buf_ring && impl->buf_ring != MAP_FAILED) {
+        munmap(impl->buf_ring, impl->buf_ring_size);
+    }
+    if (impl->recv_bufs && impl->recv_bufs != MAP_FAILED) {
+        munmap(impl->recv_bufs, (size_t)URING_RECV_BUFS * URING_RECV_BUF_SIZE);
+    }
+    if (impl->sqes && impl->sqes != MAP_FAILED) {
+        munmap(impl->sqes, impl->sqes_size);
+    }
+    if (impl->cq_ring && impl->cq_ring != MAP_FAILED && impl->cq_ring != impl->sq_ring) {
+        munmap(impl->cq_ring, impl->cq_ring_size);
+    }
+    if (impl->sq_ring && impl->sq_ring != MAP_FAILED) {
+        munmap(impl->sq_ring, impl->sq_ring_size);
+    }
+}
+
+static int uring_create_impl(event_loop_t *loop, int max_events) {
+    uring_impl_t *impl = calloc(1, sizeof(uring_impl_t));
+    if (!impl) return -1;
+    
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = max_events * 2 > URING_MIN_CQ ? max_events * 2 : URING_MIN_CQ;
+    
+    impl->ring_fd = sys_io_uring_setup(URING_SQ_ENTRIES, &params);
+    if (impl->ring_fd < 0) {
+        free(impl);
+        return -1;
+    }
+    
+    // Timed waits need IORING_ENTER_EXT_ARG (5.11+)
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        close(impl->ring_fd);
+        free(impl);
+        errno = ENOSYS;
+        return -1;
+    }
+    
+    impl->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    impl->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (impl->cq_ring_size > impl->sq_ring_size) {
+            impl->sq_ring_size = impl->cq_ring_size;
+        }
+        impl->cq_ring_size = impl->sq_ring_size;
+    }
+    
+    impl->sq_ring = mmap(NULL, impl->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, impl->ring_fd, IORING_OFF_SQ_RING);
+    if (impl->sq_ring == MAP_FAILED) goto fail;
+    
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        impl->cq_ring = impl->sq_ring;
+    } else {
+        impl->cq_ring = mmap(NULL, impl->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, impl->ring_fd, IORING_OFF_CQ_RING);
+        if (impl->cq_ring == MAP_FAILED) goto fail;
+    }
+    
+    impl->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    impl->sqes = mmap(NULL, impl->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, impl->ring_fd, IORING_OFF_SQES);
+    if (impl->sqes == MAP_FAILED) goto fail;
+    
+    char *sq = impl->sq_ring;
+    impl->sq_head = (unsigned *)(sq + params.sq_off.head);
+    impl->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    impl->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    impl->sq_array = (unsigned *)(sq + params.sq_off.array);
+    impl->sq_entries = params.sq_entries;
+    impl->sq_local_tail = *impl->sq_tail;
+    
+    char *cq = impl->cq_ring;
+    impl->cq_head = (unsigned *)(cq + params.cq_off.head);
+    impl->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    impl->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    impl->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    
+    // Provided buffer ring for multishot recv (5.19+; multishot recv itself needs 6.0+).
+    // Buffer pages are only touched once the kernel receives into them.
+    if (loop->completions) {
+        impl->buf_ring_size = URING_RECV_BUFS * sizeof(struct io_uring_buf);
+        impl->buf_ring = mmap(NULL, impl->buf_ring_size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (impl->buf_ring == MAP_FAILED) goto fail;
+        impl->recv_bufs = mmap(NULL, (size_t)URING_RECV_BUFS * URING_RECV_BUF_SIZE,
+                               PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (impl->recv_bufs == MAP_FAILED) goto fail;
+        
+        struct io_uring_buf_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = (uint64_t)(uintptr_t)impl->buf_ring;
+        reg.ring_entries = URING_RECV_BUFS;
+        reg.bgid = URING_RECV_BGID;
+        if (sys_io_uring_register(impl->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) goto fail;
+        
+        for (int i = 0; i < URING_RECV_BUFS; i++) {
+            impl->returns[impl->nreturns++] = (unsigned short)i;
+        }
+        uring_return_bufs(impl);
+    }
+    
+    loop->impl = impl;
+    loop->max_events = max_events;
+    return 0;
+
+fail:
+    uring_unmap(impl);
+    close(impl->ring_fd);
+    free(impl);
+    return -1;
+}
+
+static void uring_destroy_impl(event_loop_t *loop) {
+    if (!loop || !loop->impl) return;
+    
+    uring_impl_t *impl = (uring_impl_t *)loop->impl;
+    // Close first so no request is left to receive into the buffers being unmapped
+    if (impl->ring_fd >= 0) {
+        close(impl->ring_fd);
+    }
+    uring_unmap(impl);
+    free(impl->slots);
+    free(impl);
+    loop->impl = NULL;
+}
+
+static int uring_add_impl(event_loop_t *loop, int fd, uint32_t events, void *data) {
+    if (!loop || !loop->impl || fd < 0) return -1;
+    
+    uring_impl_t *impl = (uring_impl_t *)loop->impl;
+    uring_slot_t *slot = uring_slot(impl, fd, 1);
+    if (!slot) return -1;
+    
+    // A live slot here means the previous file was closed without del();
+    // epoll drops closed files implicitly, so mirror that.
+    if (slot->events) {
+        uring_queue_poll_remove(impl, fd, slot);
+    }
+    // add() starts a fresh registration (recv_start/accept_start come after it)
+    uring_io_forget(impl, fd, slot);
+    
+    slot->gen++;
+    slot->events = events | EVENT_ET;
+    slot->data = data;
+    slot->batch = 0;
+    return uring_queue_poll_add(impl, fd, slot);
+}
+
+static int uring_mod_impl(event_loop_t *loop, int fd, uint32_t events, void *data) {
+    if (!loop || !loop->impl || fd < 0) return -1;
+    
+    uring_impl_t *impl = (uring_impl_t *)loop->impl;
+    uring_slot_t *slot = uring_slot(impl, fd, 0);
+    if (!slot || !slot->events) {
+        errno = ENOENT;
+        return -1;
+    }
+    
+    slot->data = data;
+    events |= EVENT_ET;
+    if (slot->events == events) {
+        return 0;  // Same interest set, nothing to tell the kernel
+    }
+    
+    if (uring_queue_poll_remove(impl, fd, slot) < 0) return -1;
+    slot->gen++;
+    slot->events = events;
+    slot->batch = 0;
+    return uring_queue_poll_add(impl, fd, slot);
+}
+
+static int uring_del_impl(event_loop_t *loop, int fd) {
+    if (!loop || !loop->impl || fd < 0) return -1;
+    
+    uring_impl_t *impl = (uring_impl_t *)loop->impl;
+    uring_slot_t *slot = uring_slot(impl, fd, 0);
+    if (!slot || (!slot->events && !slot->io_kind)) {
+        errno = ENOENT;
+        return -1;
+    }
+    
+    int ret = 0;
+    if (slot->events) {
+        ret = uring_queue_poll_remove(impl, fd, slot);
+        slot->gen++;
+        slot->events = 0;
+        slot->data = NULL;
+    }
+    uring_io_forget(impl, fd, slot);
+    return ret;
+}
+
+static int uring_io_start(event_loop_t *loop, int fd, void *data, uint8_t kind) {
+    if (!loop || !loop->impl || fd < 0) return -1;
+    
+    uring_impl_t *impl = (uring_impl_t *)loop->impl;
+    uring_slot_t *slot = uring_slot(impl, fd, 1);
+    if (!slot) return -1;
+    
+    if (slot->io_kind != kind) {
+        uring_io_forget(impl, fd, slot);
+        slot->io_kind = kind;
+    }
+    slot->io_data = data;
+    slot->io_want = 1;
+    
+    // Still winding down after recv_stop(): re-armed when its final CQE arrives
+    if (slot->io_armed) return 0;
+    return uring_queue_io(impl, fd, slot);
+}
+
+static int uring_recv_start_impl(event_loop_t *loop, int fd, void *data) {
+    return uring_io_start(loop, fd, data, URING_KIND_RECV);
+}
+
+static int uring_accept_start_impl(event_loop_t *loop, int fd, void *data) {
+    return uring_io_start(loop, fd, data, URING_KIND_ACCEPT);
+}
+
+static int uring_recv_stop_impl(event_loop_t *loop, int fd) {
+    if (!loop || !loop->impl || fd < 0) return -1;
+    
+    uring_impl_t *impl = (uring_impl_t *)loop->impl;
+    uring_slot_t *slot = uring_slot(impl, fd, 0);
+    if (!slot || slot->io_kind != URING_KIND_RECV) {
+        errno = ENOENT;
+        return -1;
+    }
+    
+    // Data the request already took from the socket is still reported
+    slot->io_want = 0;
+    if (slot->io_armed && !slot->io_canceling) {
+        return uring_queue_io_cancel(impl, fd, slot);
+    }
+    return 0;
+}
+
+// Turn a recv / accept completion into an event; returns 0 if nothing to report
+static int uring_reap_io(uring_impl_t *impl, struct io_uring_cqe *cqe, event_t *ev) {
+    int fd = (int)(cqe->user_data & 0xffffffffu);
+    uint32_t gen = (uint32_t)(cqe->user_data >> 32) & URING_GEN_MASK;
+    uint8_t kind = (uint8_t)((cqe->user_data >> URING_KIND_SHIFT) & 3);
+    const char *buf = NULL;
+    
+    // The buffer is the caller's until the next wait(), stale or not
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        unsigned short bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        buf = impl->recv_bufs + (size_t)bid * URING_RECV_BUF_SIZE;
+        impl->returns[impl->nreturns++] = bid;
+    }
+    
+    uring_slot_t *slot = uring_slot(impl, fd, 0);
+    if (!slot || slot->io_kind != kind || (slot->io_gen & URING_GEN_MASK) != gen) return 0;
+    
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        // Multishot ended: cancelled, out of buffers, or the kernel just stopped it.
+        // Keep it going unless the fd hit EOF or an error the caller must see.
+        slot->io_armed = 0;
+        slot->io_canceling = 0;
+        int resumable = cqe->res == -ECANCELED || cqe->res == -ENOBUFS ||
+                        cqe->res > 0 || (kind == URING_KIND_ACCEPT && cqe->res == 0);
+        if (slot->io_want && resumable) {
+            uring_queue_io(impl, fd, slot);
+        } else if (kind == URING_KIND_ACCEPT) {
+            // e.g. EMFILE: re-arming at once would spin, the caller retries later
+            slot->io_want = 0;
+        }
+    }
+    
+    if (cqe->res == -ECANCELED || cqe->res == -ENOBUFS) return 0;
+    
+    ev->data = slot->io_data;
+    ev->events = kind == URING_KIND_RECV ? EVENT_RECV : EVENT_ACCEPT;
+    ev->fd = fd;
+    ev->result = cqe->res;
+    ev->buf = buf;
+    return 1;
+}
+
+// Drain completions into events[], merging repeat wakeups of the same fd
+static int uring_reap(uring_impl_t *impl, event_t *events, int max_events) {
+    unsigned head = *impl->cq_head;
+    unsigned tail = __atomic_load_n(impl->cq_tail, __ATOMIC_ACQUIRE);
+    int n = 0;
+    
+    impl->batch++;
+    if (impl->batch == 0) impl->batch = 1;
+    
+    while (head != tail && n < max_events) {
+        struct io_uring_cqe *cqe = &impl->cqes[head & *impl->cq_mask];
+        head++;
+        
+        if (cqe->user_data & URING_UD_IGNORE) continue;
+        
+        if ((cqe->user_data >> URING_KIND_SHIFT) & 3) {
+            // recv / accept results are reported one by one, never merged
+            n += uring_reap_io(impl, cqe, &events[n]);
+            continue;
+        }
+        
+        int fd = (int)(cqe->user_data & 0xffffffffu);
+        uint32_t gen = (uint32_t)(cqe->user_data >> 32) & URING_GEN_MASK;
+        uring_slot_t *slot = uring_slot(impl, fd, 0);
+        if (!slot || !slot->events || (slot->gen & URING_GEN_MASK) != gen) continue;  // Stale
+        
+        uint32_t ev;
+        if (cqe->res >= 0) {
+            ev = from_poll_events((uint32_t)cqe->res);
+            // Multishot poll ended (e.g. CQ overflow): re-arm it
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                uring_queue_poll_add(impl, fd, slot);
+            }
+        } else {
+            ev = EVENT_ERROR;
+        }
+        
+        if (slot->batch == impl->batch) {
+            events[slot->batch_idx].events |= ev;
+            continue;
+        }
+        
+        slot->batch = impl->batch;
+        slot->batch_idx = n;
+        events[n].data = slot->data;
+        events[n].events = ev;
+        events[n].fd = fd;
+        n++;
+    }
+    
+    __atomic_store_n(impl->cq_head, head, __ATOMIC_RELEASE);
+    return n;
+}
+
+static int uring_wait_impl(event_loop_t *loop, event_t *events, int max_events, long timeout_us) {
+    if (!loop || !loop->impl || !events) return -1;
+    
+    uring_impl_t *impl = (uring_impl_t *)loop->impl;
+    uring_return_bufs(impl);
+    int n = uring_reap(impl, events, max_events);
+    
+    if (n > 0 || timeout_us == 0) {
+        // Flush queued registrations without blocking
+        if (uring_sq_pending(impl) > 0) {
+            int ret = uring_enter(impl, 0, 0, NULL, 0);
+            if (ret < 0 && ret != -EINTR && ret != -EBUSY) {
+                errno = -ret;
+                return n > 0 ? n : -1;
+            }
+        }
+        return n > 0 ? n : uring_reap(impl, events, max_events);
+    }
+    
+    // Submit and wait in one syscall
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if (timeout_us > 0) {
+        ts.tv_sec = timeout_us / 1000000;
+        ts.tv_nsec = (long long)(timeout_us % 1000000) * 1000;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+    }
+    
+    int ret = uring_enter(impl, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                          &arg, sizeof(arg));
+    if (ret < 0 && ret != -ETIME && ret != -EBUSY) {
+        errno = -ret;
+        return -1;
+    }
+    
+    return uring_reap(impl, events, max_events);
+}
+
+const event_loop_ops_t io_uring_ops = {
+    .name = "io_uring",
+    .create = uring_create_impl,
+    .destroy = uring_destroy_impl,
+    .add = uring_add_impl,
+    .mod = uring_mod_impl,
+    .del = uring_del_impl,
+    .wait = uring_wait_impl,
+    .recv_start = uring_recv_start_impl,
+    .recv_stop = uring_recv_stop_impl,
+    .accept_start = uring_accept_start_impl
+};
+
+#endif // __linux__
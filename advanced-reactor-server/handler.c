@@ -0,0 +1,261 @@
+// handler.c
+#include "handler.h"
+#include "metrics.h"
+
+// /size/N 端点的正文上限和填充缓冲区大小
+#define SIZED_RESPONSE_MAX (64L * 1024 * 1024)
+#define FILL_BUF_SIZE      (64 * 1024)
+
+// /sleep/MS 的上限
+#define SLEEP_MAX_MS 10000
+
+static handler_t handlers[MAX_HANDLERS];
+static int handler_count;
+static int builtins_registered;
+
+// 正文填充数据：只读、进程生命周期内常驻，响应按片段引用，不复制
+static buf_t *fill_buf;
+static pthread_once_t fill_buf_once = PTHREAD_ONCE_INIT;
+
+static void fill_buf_init(void) {
+    fill_buf = buf_alloc(FILL_BUF_SIZE);
+    if (fill_buf) {
+        memset(fill_buf->data, 'x', FILL_BUF_SIZE);
+    }
+}
+
+int handler_register(const char *prefix, request_handler_fn fn, int flags) {
+    if (!prefix || !fn || handler_count >= MAX_HANDLERS) return -1;
+    
+    handlers[handler_count].prefix = prefix;
+    handlers[handler_count].prefix_len = (int)strlen(prefix);
+    handlers[handler_count].fn = fn;
+    handlers[handler_count].flags = flags;
+    handler_count++;
+    
+    return 0;
+}
+
+const handler_t* handler_find(const buf_slice_t *data, request_t *req) {
+    const char *p = buf_slice_data(data);
+    const char *end = p + data->len;
+    
+    req->data = data;
+    req->path = NULL;
+    req->path_len = 0;
+    
+    // 请求行：METHOD SP PATH SP VERSION
+    const char *sp = memchr(p, ' ', end - p);
+    if (sp) {
+        const char *path = sp + 1;
+        const char *path_end = path;
+        while (path_end < end && *path_end != ' ' && *path_end != '\r') {
+            path_end++;
+        }
+        req->path = path;
+        req->path_len = (int)(path_end - path);
+    }
+    
+    // 最长前缀匹配
+    const handler_t *best = NULL;
+    for (int i = 0; i < handler_count; i++) {
+        const handler_t *h = &handlers[i];
+        if (h->prefix_len <= req->path_len &&
+            memcmp(req->path, h->prefix, h->prefix_len) == 0 &&
+            (!best || h->prefix_len > best->prefix_len)) {
+            best = h;
+        }
+    }
+    
+    return best;
+}
+
+int handler_invoke(const handler_t *handler, const request_t *req, buf_chain_t *resp) {
+    if (!handler) return -1;
+    return handler->fn(req, resp);
+}
+
+void handler_log_access(const connection_t *conn, const request_t *req, const buf_chain_t *resp,
+                        uint64_t req_ns, const char *via) {
+    const char *data = buf_slice_data(req->data);
+    int method_len = 0;
+    while (method_len < req->data->len && data[method_len] != ' ') {
+        method_len++;
+    }
+    
+    // 状态码取自响应的第一个片段："HTTP/1.1 NNN ..."
+    int status = 0;
+    const buf_seg_t *first = resp->head;
+    if (first && !first->file && first->slice.len >= 12) {
+        const char *line = buf_slice_data(&first->slice);
+        for (int i = 9; i < 12 && line[i] >= '0' && line[i] <= '9'; i++) {
+            status = status * 10 + (line[i] - '0');
+        }
+    }
+    
+    struct timespec ts;
+#ifdef CLOCK_REALTIME_COARSE
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_REALTIME, &ts);
+#endif
+    const unsigned char *ip = (const unsigned char*)&conn->addr.sin_addr.s_addr;
+    unsigned long us = req_ns ? (unsigned long)((metrics_now_ns() - req_ns) / 1000) : 0;
+    
+    access_log("{\"ts\":%ld.%03ld,\"client\":\"%u.%u.%u.%u:%u\",\"method\":\"%.*s\",\"path\":\"%.*s\","
+               "\"status\":%d,\"bytes\":%zu,\"us\":%lu,\"via\":\"%s\"}",
+               (long)ts.tv_sec, ts.tv_nsec / 1000000, ip[0], ip[1], ip[2], ip[3], ntohs(conn->addr.sin_port),
+               method_len, data, req->path_len, req->path, status, resp->bytes, us, via);
+}
+
+static const char* status_reason(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 416: return "Range Not Satisfiable";
+        default:  return "Internal Server Error";
+    }
+}
+
+int handler_append_status(buf_chain_t *resp, int status, const char *content_type,
+                          long content_length, const char *extra) {
+    buf_t *head = buf_alloc(BUFFER_SIZE);
+    if (!head) return -1;
+    
+    int head_len = snprintf(head->data, head->size, "HTTP/1.1 %d %s\r\n", status, status_reason(status));
+    if (content_type) {
+        head_len += snprintf(head->data + head_len, head->size - head_len,
+                             "Content-Type: %s\r\n", content_type);
+    }
+    if (content_length >= 0) {
+        head_len += snprintf(head->data + head_len, head->size - head_len,
+                             "Content-Length: %ld\r\n", content_length);
+    }
+    head_len += snprintf(head->data + head_len, head->size - head_len,
+                         "Connection: keep-alive\r\n%s\r\n", extra ? extra : "");
+    if (head_len >= head->size) {
+        buf_unref(head);
+        return -1;
+    }
+    
+    int ret = buf_chain_append(resp, head, 0, head_len);
+    buf_unref(head);  // 由 chain 持有
+    return ret;
+}
+
+// 200 响应头：extra 为附加的头部行，body_prefix 为紧跟在头部后面的正文前缀
+static int append_head(buf_chain_t *resp, long content_length, const char *extra,
+                       const char *body_prefix) {
+    // 简单的 HTTP 响应
+    const char *http_response_template =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: %ld\r\n"
+        "Connection: keep-alive\r\n"
+        "%s"
+        "\r\n"
+        "%s";
+    
+    buf_t *head = buf_alloc(BUFFER_SIZE);
+    if (!head) return -1;
+    
+    int head_len = snprintf(head->data, head->size,
+                           http_response_template,
+                           content_length, extra, body_prefix ? body_prefix : "");
+    
+    int ret = buf_chain_append(resp, head, 0, head_len);
+    buf_unref(head);  // 由 chain 持有
+    return ret;
+}
+
+int handler_append_head(buf_chain_t *resp, long content_length, const char *body_prefix) {
+    return append_head(resp, content_length, "", body_prefix);
+}
+
+// 解析路径中 prefix 之后的十进制数，超出 max 时取 max；没有数字时返回 -1
+static long parse_path_number(const request_t *req, int prefix_len, long max) {
+    long value = 0;
+    int i = prefix_len;
+    
+    while (i < req->path_len && req->path[i] >= '0' && req->path[i] <= '9') {
+        value = value * 10 + (req->path[i] - '0');
+        if (value > max) {
+            value = max;
+        }
+        i++;
+    }
+    
+    return i > prefix_len ? value : -1;
+}
+
+// 默认处理函数：echo 整个请求
+// 正文直接引用请求数据所在的缓冲区，不复制；响应随请求头变化，标记为不可缓存
+static int echo_handler(const request_t *req, buf_chain_t *resp) {
+    static const char echo_prefix[] = "Echo: ";
+    long body_len = (long)(sizeof(echo_prefix) - 1) + req->data->len;
+    
+    if (append_head(resp, body_len, "Cache-Control: no-store\r\n", echo_prefix) != 0) return -1;
+    return buf_chain_append(resp, req->data->buf, req->data->off, req->data->len);
+}
+
+// GET /size/N：返回 N 字节正文，每个片段引用同一块填充缓冲区
+static int size_handler(const request_t *req, buf_chain_t *resp) {
+    long size = parse_path_number(req, 6, SIZED_RESPONSE_MAX);
+    if (size < 0) {
+        return echo_handler(req, resp);
+    }
+    
+    pthread_once(&fill_buf_once, fill_buf_init);
+    if (!fill_buf) return -1;
+    
+    if (handler_append_head(resp, size, NULL) != 0) return -1;
+    
+    while (size > 0) {
+        int len = size > FILL_BUF_SIZE ? FILL_BUF_SIZE : (int)size;
+        if (buf_chain_append(resp, fill_buf, 0, len) != 0) return -1;
+        size -= len;
+    }
+    return 0;
+}
+
+// GET /sleep/MS：模拟阻塞的业务处理（如数据库查询），只能在工作线程执行
+static int sleep_handler(const request_t *req, buf_chain_t *resp) {
+    static const char body[] = "OK";
+    long ms = parse_path_number(req, 7, SLEEP_MAX_MS);
+    
+    if (ms > 0) {
+        usleep(ms * 1000);
+    }
+    
+    return handler_append_head(resp, sizeof(body) - 1, body);
+}
+
+// GET /metrics：Prometheus 文本格式的延迟直方图和各线程计数器
+static int metrics_handler(const request_t *req, buf_chain_t *resp) {
+    (void)req;
+    
+    buf_chain_t body;
+    buf_chain_init(&body);
+    if (metrics_render(&body) != 0) return -1;
+    
+    if (handler_append_head(resp, (long)body.bytes, NULL) != 0) {
+        buf_chain_clear(&body);
+        return -1;
+    }
+    buf_chain_move(resp, &body);
+    return 0;
+}
+
+void handler_register_builtins(void) {
+    if (builtins_registered) return;
+    builtins_registered = 1;
+    
+    handler_register("/metrics", metrics_handler, 0);
+    handler_register("/size/", size_handler, HANDLER_CACHEABLE);
+    handler_register("/sleep/", sleep_handler, HANDLER_BLOCKING);
+    handler_register("", echo_handler, 0);
+}
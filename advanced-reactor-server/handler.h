@@ -0,0 +1,63 @@
+// handler.h
+#ifndef HANDLER_H
+#define HANDLER_H
+
+#include "common.h"
+
+// 请求处理函数注册表
+//
+// 按请求路径的最长前缀选择处理函数。处理函数只把响应组织成 buf_chain_t，
+// 由调用方决定在 IO 线程内联执行（run-to-completion）还是交给工作线程池。
+// 会阻塞或耗 CPU 的处理函数必须带 HANDLER_BLOCKING，这类请求始终由工作线程执行。
+// 响应只取决于请求目标（和响应缓存的 vary 头）的处理函数可以带 HANDLER_CACHEABLE，
+// 启用响应缓存时它们的 200 响应会被缓存，命中的请求不再执行处理函数。
+
+#define MAX_HANDLERS 32
+
+// 处理函数标志
+#define HANDLER_BLOCKING  0x1
+#define HANDLER_CACHEABLE 0x2
+
+// 一个完整的请求
+typedef struct request {
+    const buf_slice_t *data;    // 请求行 + 头部 + 正文
+    const char *path;           // 请求路径（指向 data 内部）
+    int path_len;
+} request_t;
+
+// 处理函数：成功时把完整 HTTP 响应追加到 resp 并返回 0
+typedef int (*request_handler_fn)(const request_t *req, buf_chain_t *resp);
+
+typedef struct handler {
+    const char *prefix;
+    int prefix_len;
+    request_handler_fn fn;
+    int flags;
+} handler_t;
+
+// 注册处理函数（在服务器启动前调用）
+int handler_register(const char *prefix, request_handler_fn fn, int flags);
+
+// 注册内置处理函数：/size/N、/sleep/MS（可缓存）以及默认的 echo
+void handler_register_builtins(void);
+
+// 查找请求对应的处理函数，并填充 req
+const handler_t* handler_find(const buf_slice_t *data, request_t *req);
+
+// 执行处理函数
+int handler_invoke(const handler_t *handler, const request_t *req, buf_chain_t *resp);
+
+// 写一条访问日志（调用方先检查 log_access_enabled()）：resp 为即将发送的完整响应，
+// req_ns 为请求成帧的时间，via 为响应来源（worker、inline、cache）
+void handler_log_access(const connection_t *conn, const request_t *req, const buf_chain_t *resp,
+                        uint64_t req_ns, const char *via);
+
+// 追加 HTTP 响应头（以及可选的正文前缀 body_prefix）
+int handler_append_head(buf_chain_t *resp, long content_length, const char *body_prefix);
+
+// 追加任意状态码的响应头：content_length < 0 时不输出 Content-Length（如 304），
+// extra 为附加的头部行（每行以 \r\n 结尾，可为 NULL）
+int handler_append_status(buf_chain_t *resp, int status, const char *content_type,
+                          long content_length, const char *extra);
+
+#endif // HANDLER_H
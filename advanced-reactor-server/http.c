@@ -0,0 +1,258 @@
+// http.c
+#include <string.h>
+#include <strings.h>
+#include "http.h"
+
+// chunked 块大小行的最大长度（含扩展）
+#define HTTP_MAX_CHUNK_LINE 1024
+
+void http_parser_reset(http_parser_t *parser) {
+    parser->state = HTTP_PARSE_HEADERS;
+    parser->pos = 0;
+    parser->header_len = 0;
+    parser->content_length = 0;
+    parser->chunk_remaining = 0;
+}
+
+// 在 data[from, len) 中查找 CRLF，返回 '\r' 的位置，未找到返回 -1
+static long find_crlf(const char *data, long from, long len) {
+    for (long i = from; i + 1 < len; i++) {
+        if (data[i] == '\r' && data[i + 1] == '\n') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 逗号分隔的头部值中，最后一项是否为 token（不区分大小写）
+static int value_last_token_is(const char *value, long len, const char *token) {
+    while (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\t')) {
+        len--;
+    }
+    long start = len;
+    while (start > 0 && value[start - 1] != ',') {
+        start--;
+    }
+    while (start < len && (value[start] == ' ' || value[start] == '\t')) {
+        start++;
+    }
+    
+    long token_len = (long)strlen(token);
+    return len - start == token_len && strncasecmp(value + start, token, token_len) == 0;
+}
+
+// 解析头部中的 Content-Length / Transfer-Encoding
+// 返回 1 表示 chunked，0 表示按 Content-Length，-1 表示非法
+static int parse_headers(http_parser_t *parser, const char *data) {
+    long line = find_crlf(data, 0, parser->header_len);
+    int chunked = 0;
+    int has_length = 0;
+    int has_encoding = 0;
+    
+    // 请求行不能为空
+    if (line <= 0) return -1;
+    
+    long pos = line + 2;
+    while (pos < parser->header_len - 2) {
+        long end = find_crlf(data, pos, parser->header_len);
+        if (end < 0) return -1;
+        
+        const char *colon = memchr(data + pos, ':', end - pos);
+        if (!colon) return -1;
+        
+        long name_len = colon - (data + pos);
+        const char *value = colon + 1;
+        long value_len = (data + end) - value;
+        while (value_len > 0 && (*value == ' ' || *value == '\t')) {
+            value++;
+            value_len--;
+        }
+        
+        if (name_len == 14 && strncasecmp(data + pos, "Content-Length", 14) == 0) {
+            long length = 0;
+            long i = 0;
+            for (; i < value_len && value[i] >= '0' && value[i] <= '9'; i++) {
+                length = length * 10 + (value[i] - '0');
+                if (length > HTTP_MAX_REQUEST_SIZE) return -1;
+            }
+            if (i == 0) return -1;
+            // 数字之后只允许空白，"12abc" 之类的值直接拒绝
+            for (; i < value_len; i++) {
+                if (value[i] != ' ' && value[i] != '\t') return -1;
+            }
+            // 重复的 Content-Length 必须取值一致，否则无法确定正文边界
+            if (has_length && length != parser->content_length) return -1;
+            has_length = 1;
+            parser->content_length = length;
+        } else if (name_len == 17 && strncasecmp(data + pos, "Transfer-Encoding", 17) == 0) {
+            // 多个 Transfer-Encoding 头按顺序拼接，最后一个头的最后一项即最终编码
+            has_encoding = 1;
+            chunked = value_last_token_is(value, value_len, "chunked");
+        }
+        
+        pos = end + 2;
+    }
+    
+    // Transfer-Encoding 与 Content-Length 同时出现是请求走私的典型手法，直接拒绝
+    if (has_encoding && has_length) return -1;
+    
+    // 最终编码不是 chunked 时无法确定正文长度（RFC 9112 6.3），按零长度处理会把正文当作下一个请求
+    if (has_encoding && !chunked) return -1;
+    
+    return chunked;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+long http_parser_execute(http_parser_t *parser, const char *data, long len) {
+    for (;;) {
+        if (parser->pos > HTTP_MAX_REQUEST_SIZE) return -1;
+        
+        switch (parser->state) {
+            case HTTP_PARSE_HEADERS: {
+                // 结束符可能跨越上次扫描的边界，回退 3 字节
+                long from = parser->pos > 3 ? parser->pos - 3 : 0;
+                long end = -1;
+                for (long i = from; i + 3 < len; i++) {
+                    if (data[i] == '\r' && data[i + 1] == '\n' &&
+                        data[i + 2] == '\r' && data[i + 3] == '\n') {
+                        end = i;
+                        break;
+                    }
+                }
+                
+                if (end < 0) {
+                    parser->pos = len;
+                    return len > HTTP_MAX_HEADER_SIZE ? -1 : 0;
+                }
+                
+                parser->header_len = end + 4;
+                if (parser->header_len > HTTP_MAX_HEADER_SIZE) return -1;
+                
+                int chunked = parse_headers(parser, data);
+                if (chunked < 0) return -1;
+                
+                parser->pos = parser->header_len;
+                if (chunked) {
+                    parser->state = HTTP_PARSE_CHUNK_SIZE;
+                } else if (parser->content_length > 0) {
+                    parser->state = HTTP_PARSE_BODY;
+                } else {
+                    return parser->header_len;
+                }
+                break;
+            }
+            
+            case HTTP_PARSE_BODY: {
+                long total = parser->header_len + parser->content_length;
+                if (len >= total) {
+                    return total;
+                }
+                parser->pos = len;
+                return 0;
+            }
+            
+            case HTTP_PARSE_CHUNK_SIZE: {
+                long end = find_crlf(data, parser->pos, len);
+                if (end < 0) {
+                    return len - parser->pos > HTTP_MAX_CHUNK_LINE ? -1 : 0;
+                }
+                
+                long size = 0;
+                long i = parser->pos;
+                for (; i < end; i++) {
+                    int v = hex_value(data[i]);
+                    if (v < 0) break;
+                    size = size * 16 + v;
+                    if (size > HTTP_MAX_REQUEST_SIZE) return -1;
+                }
+                if (i == parser->pos) return -1;
+                // 块扩展（";name=value"）直接跳过
+                if (i < end && data[i] != ';' && data[i] != ' ' && data[i] != '\t') return -1;
+                
+                parser->pos = end + 2;
+                if (size == 0) {
+                    parser->state = HTTP_PARSE_TRAILERS;
+                } else {
+                    parser->chunk_remaining = size + 2;
+                    parser->state = HTTP_PARSE_CHUNK_DATA;
+                }
+                break;
+            }
+            
+            case HTTP_PARSE_CHUNK_DATA: {
+                long avail = len - parser->pos;
+                if (avail < parser->chunk_remaining) {
+                    parser->chunk_remaining -= avail;
+                    parser->pos = len;
+                    return 0;
+                }
+                
+                parser->pos += parser->chunk_remaining;
+                parser->chunk_remaining = 0;
+                if (data[parser->pos - 2] != '\r' || data[parser->pos - 1] != '\n') return -1;
+                parser->state = HTTP_PARSE_CHUNK_SIZE;
+                break;
+            }
+            
+            case HTTP_PARSE_TRAILERS: {
+                long end = find_crlf(data, parser->pos, len);
+                if (end < 0) {
+                    return len - parser->pos > HTTP_MAX_HEADER_SIZE ? -1 : 0;
+                }
+                // 空行结束整个请求
+                int empty_line = (end == parser->pos);
+                parser->pos = end + 2;
+                if (empty_line) {
+                    return parser->pos;
+                }
+                break;
+            }
+        }
+    }
+}
+
+long http_parser_expected_size(const http_parser_t *parser) {
+    switch (parser->state) {
+        case HTTP_PARSE_BODY:
+            return parser->header_len + parser->content_length;
+        case HTTP_PARSE_CHUNK_DATA:
+            return parser->pos + parser->chunk_remaining;
+        default:
+            return parser->pos;
+    }
+}
+
+const char* http_find_header(const char *data, long len, const char *name, int *value_len) {
+    const char *end = data + len;
+    int name_len = (int)strlen(name);
+    
+    // 跳过起始行
+    const char *line = memchr(data, '\n', len);
+    while (line && ++line < end && *line != '\r' && *line != '\n') {
+        const char *eol = memchr(line, '\n', end - line);
+        if (!eol) eol = end;
+        
+        if (eol - line > name_len && line[name_len] == ':' &&
+            strncasecmp(line, name, name_len) == 0) {
+            const char *value = line + name_len + 1;
+            while (value < eol && (*value == ' ' || *value == '\t')) {
+                value++;
+            }
+            const char *value_end = eol;
+            while (value_end > value && (value_end[-1] == '\r' || value_end[-1] == ' ')) {
+                value_end--;
+            }
+            *value_len = (int)(value_end - value);
+            return value;
+        }
+        line = eol < end ? eol : NULL;
+    }
+    
+    return NULL;
+}
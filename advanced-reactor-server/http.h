@@ -0,0 +1,44 @@
+// http.h
+#ifndef HTTP_H
+#define HTTP_H
+
+// 增量 HTTP/1.1 请求分帧
+//
+// IO 线程每次读到新数据后，对连接读缓冲区中尚未成帧的字节调用 http_parser_execute。
+// 解析状态记录的都是相对请求起点的偏移，缓冲区搬移或扩容后可以继续解析，
+// 已扫描过的字节不会重复扫描。只做分帧（请求行 + 头部 + Content-Length 或 chunked 正文），
+// 不解析业务语义。
+
+#define HTTP_MAX_HEADER_SIZE  (8 * 1024)
+#define HTTP_MAX_REQUEST_SIZE (64L * 1024 * 1024)
+
+typedef enum {
+    HTTP_PARSE_HEADERS,     // 查找头部结束的空行
+    HTTP_PARSE_BODY,        // Content-Length 正文
+    HTTP_PARSE_CHUNK_SIZE,  // chunked：块大小行
+    HTTP_PARSE_CHUNK_DATA,  // chunked：块数据及其后的 CRLF
+    HTTP_PARSE_TRAILERS     // chunked：最后一块之后的 trailer，直到空行
+} http_parse_state_t;
+
+typedef struct http_parser {
+    http_parse_state_t state;
+    long pos;               // 已处理到的偏移（相对请求起点）
+    long header_len;        // 头部长度（含结尾空行）
+    long content_length;
+    long chunk_remaining;   // 当前块剩余字节（含结尾 CRLF）
+} http_parser_t;
+
+void http_parser_reset(http_parser_t *parser);
+
+// 在 data[0, len) 中继续解析一个请求
+// 返回完整请求的长度；0 表示还需要更多数据；-1 表示请求非法或超出大小限制
+long http_parser_execute(http_parser_t *parser, const char *data, long len);
+
+// 当前请求至少还需要多少字节（用于一次分配足够大的读缓冲区）
+long http_parser_expected_size(const http_parser_t *parser);
+
+// 在请求或响应的头部中查找 name（不区分大小写，跳过起始行，到空行为止）
+// 返回去掉首尾空白的值并设置 *value_len，未找到返回 NULL
+const char* http_find_header(const char *data, long len, const char *name, int *value_len);
+
+#endif // HTTP_H
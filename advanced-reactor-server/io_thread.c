@@ -1,102 +1,844 @@
 // io_thread.c
 #include "io_thread.h"
 #include "event_loop.h"
+#include "handler.h"
+#include "response_cache.h"
 
-// 处理读事件
-static void handle_read(io_thread_t *io_thread, connection_t *conn) {
-    char buffer[BUFFER_SIZE];
+#include <limits.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// 主线程经管道转交给 IO 线程的新连接（小于 PIPE_BUF，写入是原子的）
+typedef struct conn_handoff {
+    int fd;
+    struct sockaddr_in addr;
+} conn_handoff_t;
+
+// 读缓冲区剩余空间低于该值时整理或换新缓冲区
+#define READ_MIN_SPACE 1024
+
+// 每个线程的消息对象池预分配数
+#define MSG_POOL_PREFILL 64
+
+// 时间轮精度；连接暂时不满足任何超时条件（如请求仍在工作线程处理）时的复查间隔
+#define TIMER_TICK_MS    100
+#define CONN_RECHECK_MS  1000
+
+// 不超时
+#define DEADLINE_NONE UINT64_MAX
+
+// 吞吐采样间隔；p2c 比较负载时每 LOAD_BYTES_PER_CONN 字节/秒的吞吐折算为一个连接
+#define LOAD_SAMPLE_MS      100
+#define LOAD_BYTES_PER_CONN (1L << 20)
+
+// 自旋预算从 0 恢复时的起点（微秒）
+#define SPIN_MIN_US 10
+
+// 发送消息的线程（通常是工作线程）的消息对象池，IO 线程处理完后远程归还
+static __thread object_pool_t *tls_msg_pool;
+
+// p2c 分配的随机数状态（每个分配线程一份）
+static __thread unsigned int tls_dispatch_rand;
+
+// 创建消息唤醒描述符：Linux 用单个 eventfd，其它平台退回管道
+static int wakeup_open(int fds[2]) {
+#ifdef __linux__
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd == -1) return -1;
+    fds[0] = fds[1] = fd;
+#else
+    if (pipe(fds) == -1) return -1;
+    set_nonblocking(fds[0]);
+    set_nonblocking(fds[1]);
+#endif
+    return 0;
+}
+
+static void wakeup_close(int fds[2]) {
+    close(fds[0]);
+    if (fds[1] != fds[0]) {
+        close(fds[1]);
+    }
+}
+
+static void wakeup_signal(int fds[2]) {
+#ifdef __linux__
+    uint64_t one = 1;
+    write(fds[1], &one, sizeof(one));
+#else
+    char dummy = 1;
+    write(fds[1], &dummy, 1);
+#endif
+}
+
+static void wakeup_drain(int fds[2]) {
+#ifdef __linux__
+    uint64_t value;
+    read(fds[0], &value, sizeof(value));
+#else
+    char buf[64];
+    while (read(fds[0], buf, sizeof(buf)) > 0) {
+    }
+#endif
+}
+
+static io_message_t* message_create(io_msg_type_t type, connection_t *conn);
+
+// 释放消息及其持有的响应片段和连接引用
+static void free_message(io_message_t *msg) {
+    buf_chain_clear(&msg->chain);
+    conn_release(msg->conn);
+    object_pool_free(msg);
+}
+
+// 连接在不等待可写时关注的事件：完成模式下数据由多发 recv 送达，轮询只用来发现错误和挂断
+static uint32_t conn_read_events(io_thread_t *io_thread) {
+    return io_thread->completions ? EVENT_ET : EVENT_READ | EVENT_ET;
+}
+
+// 关闭连接：注销事件和定时器、丢弃尚未发送的乱序响应
+// IO 线程持有的引用推迟到本轮事件处理结束再释放，本轮后续指向该连接的事件
+// 仍可安全地检查 conn_is_valid，连接对象也不会在本轮内被新连接复用
+static void close_connection(io_thread_t *io_thread, connection_t *conn) {
+    if (conn->fd >= 0) {
+        event_loop_del(io_thread->event_loop, conn->fd);
+    }
+    timer_wheel_del(&io_thread->timers, &conn->timer);
+    conn->state = CONN_STATE_CLOSING;
+    conn_mark_closing(conn);
+    stat_add(&io_thread->load.active_conns, -1);
+    
+    io_message_t *msg = conn->reorder;
+    conn->reorder = NULL;
+    while (msg) {
+        io_message_t *next = msg->next;
+        free_message(msg);
+        msg = next;
+    }
+    
+    conn->release_next = io_thread->release_list;
+    io_thread->release_list = conn;
+}
+
+// 释放本轮关闭的连接
+static void release_closed(io_thread_t *io_thread) {
+    while (io_thread->release_list) {
+        connection_t *conn = io_thread->release_list;
+        io_thread->release_list = conn->release_next;
+        conn_release(conn);
+    }
+}
+
+// 按连接当前状态计算超时时间
+static uint64_t conn_deadline(io_thread_t *io_thread, connection_t *conn, const char **reason) {
+    // 输出积压：对端长时间不读
+    if (conn->write_armed) {
+        *reason = "write";
+        return io_thread->write_timeout_ms > 0 ?
+               conn->last_active + io_thread->write_timeout_ms : DEADLINE_NONE;
+    }
+    
+    // 还有请求在工作线程处理，不算空闲（resp_seq 可能正被直接写的工作线程推进）
+    if (atomic_load_explicit(&conn->resp_seq, memory_order_relaxed) != conn->req_seq) {
+        return DEADLINE_NONE;
+    }
+    
+    uint64_t deadline = DEADLINE_NONE;
+    *reason = "idle";
+    if (io_thread->idle_timeout_ms > 0) {
+        deadline = conn->last_active + io_thread->idle_timeout_ms;
+    }
+    
+    // 请求头迟迟收不全（包括每次只发几个字节的慢速客户端）
+    if (conn->read_start < conn->read_pos && conn->parser.state == HTTP_PARSE_HEADERS &&
+        io_thread->header_timeout_ms > 0 &&
+        conn->request_start + io_thread->header_timeout_ms < deadline) {
+        deadline = conn->request_start + io_thread->header_timeout_ms;
+        *reason = "header";
+    }
+    
+    return deadline;
+}
+
+static int timeouts_enabled(io_thread_t *io_thread) {
+    return io_thread->idle_timeout_ms > 0 || io_thread->header_timeout_ms > 0 ||
+           io_thread->write_timeout_ms > 0;
+}
+
+// 连接状态变化后超时可能提前（开始接收请求头、输出积压），只在提前时重新挂定时器。
+// 读写进展只更新 last_active，定时器到期时再按最新状态顺延，平时不操作时间轮
+static void conn_timer_update(io_thread_t *io_thread, connection_t *conn) {
+    const char *reason;
+    uint64_t deadline = conn_deadline(io_thread, conn, &reason);
+    
+    if (deadline == DEADLINE_NONE) {
+        if (tw_timer_pending(&conn->timer) || !timeouts_enabled(io_thread)) return;
+        deadline = io_thread->now_ms + CONN_RECHECK_MS;
+    }
+    
+    if (!tw_timer_pending(&conn->timer) || deadline < conn->timer.deadline) {
+        timer_wheel_add(&io_thread->timers, &conn->timer, deadline);
+    }
+}
+
+// 连接定时器到期：确实超时则关闭，否则按最新状态顺延
+static void conn_timer_expired(tw_timer_t *timer, void *arg) {
+    connection_t *conn = (connection_t*)arg;
+    io_thread_t *io_thread = (io_thread_t*)conn->io_thread;
+    (void)timer;
+    
+    const char *reason = "idle";
+    uint64_t deadline = conn_deadline(io_thread, conn, &reason);
+    
+    if (deadline <= io_thread->now_ms) {
+        log_info("Connection %s timeout: fd=%d", reason, conn->fd);
+        stat_add(&io_thread->stats.timeouts, 1);
+        close_connection(io_thread, conn);
+        return;
+    }
+    
+    if (deadline == DEADLINE_NONE) {
+        deadline = io_thread->now_ms + CONN_RECHECK_MS;
+    }
+    timer_wheel_add(&io_thread->timers, &conn->timer, deadline);
+}
+
+// 保证读缓冲区在 read_pos 之后至少有 READ_MIN_SPACE 字节空闲
+// 未成帧的部分请求搬到缓冲区头部或更大的新缓冲区；已交出的 slice 所在缓冲区不会被改写
+static int ensure_read_space(connection_t *conn) {
+    buf_t *buf = conn->read_buf;
+    int pending = conn->read_pos - conn->read_start;
+    
+    // 没有其它引用时可以原地搬移
+    if (buf && conn->read_start > 0 &&
+        atomic_load_explicit(&buf->refs, memory_order_acquire) == 1) {
+        memmove(buf->data, buf->data + conn->read_start, pending);
+        conn->read_start = 0;
+        conn->read_pos = pending;
+    }
+    
+    if (buf && buf->size - conn->read_pos >= READ_MIN_SPACE) {
+        return 0;
+    }
+    
+    // 已知请求总长度时一次分配足够大的缓冲区
+    long size = (long)pending + READ_MIN_SPACE;
+    long expected = http_parser_expected_size(&conn->parser);
+    if (expected > size) {
+        size = expected;
+    }
+    if (size < BUF_CHUNK_SIZE) {
+        size = BUF_CHUNK_SIZE;
+    }
+    if (size > HTTP_MAX_REQUEST_SIZE + READ_MIN_SPACE) {
+        return -1;
+    }
+    
+    buf_t *new_buf = buf_alloc((int)size);
+    if (!new_buf) return -1;
+    
+    if (pending > 0) {
+        memcpy(new_buf->data, buf->data + conn->read_start, pending);
+    }
+    buf_unref(buf);
+    conn->read_buf = new_buf;
+    conn->read_start = 0;
+    conn->read_pos = pending;
+    return 0;
+}
+
+// 登记需要写出的连接，本轮事件处理结束后统一 flush（同一连接的多个响应合并为一次 writev）
+static void schedule_flush(io_thread_t *io_thread, connection_t *conn) {
+    if (conn->flush_queued) return;
+    
+    conn->flush_queued = 1;
+    conn_acquire(conn);
+    conn->flush_next = io_thread->flush_list;
+    io_thread->flush_list = conn;
+}
+
+// 把序号为 resp_seq 的响应移入输出链，并接上 reorder 中紧随其后的响应
+// 输出链原本为空时记下就绪时间，第一次写出时统计写等待和端到端延迟
+static void append_response(io_thread_t *io_thread, connection_t *conn, buf_chain_t *chain,
+                            uint64_t req_ns) {
+    if (buf_chain_empty(&conn->out) && !conn->out_ready_ns) {
+        conn->out_ready_ns = metrics_now_ns();
+        conn->out_req_ns = req_ns;
+    }
+    
+    unsigned long seq = atomic_load_explicit(&conn->resp_seq, memory_order_relaxed);
+    buf_chain_move(&conn->out, chain);
+    seq++;
+    
+    while (conn->reorder && conn->reorder->seq == seq) {
+        io_message_t *next = conn->reorder;
+        conn->reorder = next->next;
+        buf_chain_move(&conn->out, &next->chain);
+        seq++;
+        free_message(next);
+    }
+    atomic_store_explicit(&conn->resp_seq, seq, memory_order_relaxed);
+    
+    conn->state = CONN_STATE_WRITING;
+    schedule_flush(io_thread, conn);
+}
+
+// 提前完成的响应按序号插入 reorder，等前面的响应都到达后再发送
+static void park_response(connection_t *conn, io_message_t *msg) {
+    io_message_t **pos = &conn->reorder;
+    while (*pos && (*pos)->seq < msg->seq) {
+        pos = &(*pos)->next;
+    }
+    msg->next = *pos;
+    *pos = msg;
+}
+
+// 处理工作线程送回的响应，保证流水线请求的响应顺序
+static void deliver_response(io_thread_t *io_thread, io_message_t *msg) {
+    connection_t *conn = msg->conn;
+    
+    conn_output_acquire(conn);
+    if (msg->seq != atomic_load_explicit(&conn->resp_seq, memory_order_relaxed)) {
+        park_response(conn, msg);
+        return;
+    }
+    
+    append_response(io_thread, conn, &msg->chain, msg->req_ns);
+    free_message(msg);
+}
+
+// 在 IO 线程上生成的响应：轮到它时直接移入输出链，否则按序号挂到 reorder
+static int queue_response(io_thread_t *io_thread, connection_t *conn, buf_chain_t *chain,
+                          unsigned long seq, uint64_t req_ns) {
+    conn_output_acquire(conn);
+    if (seq == atomic_load_explicit(&conn->resp_seq, memory_order_relaxed)) {
+        append_response(io_thread, conn, chain, req_ns);
+        return 0;
+    }
+    
+    // 前面还有请求在工作线程执行
+    io_message_t *msg = message_create(IO_MSG_RESPONSE_READY, conn);
+    if (!msg) {
+        buf_chain_clear(chain);
+        return -1;
+    }
+    msg->seq = seq;
+    msg->req_ns = req_ns;
+    buf_chain_move(&msg->chain, chain);
+    park_response(conn, msg);
+    return 0;
+}
+
+// run-to-completion：在 IO 线程直接执行处理函数
+static int run_inline(io_thread_t *io_thread, connection_t *conn, const handler_t *handler,
+                      const request_t *req, unsigned long seq, uint64_t req_ns) {
+    buf_chain_t chain;
+    buf_chain_init(&chain);
+    
+    uint64_t start = metrics_now_ns();
+    int ret = handler_invoke(handler, req, &chain);
+    metrics_record(METRIC_HANDLER, metrics_now_ns() - start);
+    
+    if (ret != 0) {
+        buf_chain_clear(&chain);
+        return -1;
+    }
+    
+    response_cache_store(handler, req, &chain);
+    if (log_access_enabled()) {
+        handler_log_access(conn, req, &chain, req_ns, "inline");
+    }
+    return queue_response(io_thread, conn, &chain, seq, req_ns);
+}
+
+// 响应缓存命中时直接发送缓存的响应：返回 1 表示命中，0 表示未命中，-1 表示出错
+static int serve_cached(io_thread_t *io_thread, connection_t *conn, const handler_t *handler,
+                        const request_t *req, unsigned long seq, uint64_t req_ns) {
+    buf_chain_t chain;
+    buf_chain_init(&chain);
+    
+    if (response_cache_lookup(handler, req, &chain) != 0) {
+        buf_chain_clear(&chain);
+        return 0;
+    }
+    if (log_access_enabled()) {
+        handler_log_access(conn, req, &chain, req_ns, "cache");
+    }
+    return queue_response(io_thread, conn, &chain, seq, req_ns) == 0 ? 1 : -1;
+}
+
+// 从读缓冲区切出所有完整请求：响应缓存命中的请求直接发送缓存的响应，
+// run-to-completion 模式下非阻塞请求就地处理，其余每个请求一个任务交给工作线程；返回 -1 表示请求非法或处理失败
+static int dispatch_requests(io_thread_t *io_thread, connection_t *conn) {
+    buf_t *buf = conn->read_buf;
+    uint64_t now_ns = 0;    // 同一次读入的请求共用一个成帧时间
+    
+    while (conn->read_start < conn->read_pos) {
+        long len = http_parser_execute(&conn->parser, buf->data + conn->read_start,
+                                       conn->read_pos - conn->read_start);
+        if (len == 0) break;
+        if (len < 0) return -1;
+        
+        buf_slice_t slice = { buf, conn->read_start, (int)len };
+        conn->read_start += (int)len;
+        http_parser_reset(&conn->parser);
+        conn->request_start = io_thread->now_ms;
+        if (!now_ns) {
+            now_ns = metrics_now_ns();
+        }
+        
+        if (io_thread->run_to_completion || response_cache_enabled()) {
+            request_t req;
+            const handler_t *handler = handler_find(&slice, &req);
+            
+            // 先查响应缓存，命中的请求不执行处理函数，也不进入工作线程池
+            int hit = serve_cached(io_thread, conn, handler, &req, conn->req_seq, now_ns);
+            if (hit < 0) return -1;
+            if (hit) {
+                conn->req_seq++;
+                continue;
+            }
+            
+            if (io_thread->run_to_completion && handler && !(handler->flags & HANDLER_BLOCKING)) {
+                if (run_inline(io_thread, conn, handler, &req, conn->req_seq++, now_ns) != 0) {
+                    return -1;
+                }
+                continue;
+            }
+        }
+        
+        // 创建处理任务并提交到工作线程池
+        task_t *task = task_create(TASK_TYPE_PROCESS, conn, &slice);
+        if (!task) {
+            log_error("Failed to create task for fd=%d", conn->fd);
+            return -1;
+        }
+        task->seq = conn->req_seq++;
+        task->start_ns = now_ns;
+        if (thread_pool_submit(io_thread->worker_pool, task) != 0) {
+            // 线程池已关闭，任务未被接管
+            task_destroy(task);
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+// 读缓冲区 read_pos 处新到了 n 字节：更新连接状态并分发其中完整的请求
+// 返回 -1 表示连接已关闭
+static int consume_input(io_thread_t *io_thread, connection_t *conn, int n) {
+    stat_add(&io_thread->stats.bytes_read, n);
+    
+    // 更新连接状态（缓冲区中没有未完成的请求时，这次读到的是新请求的开头）
+    conn->state = CONN_STATE_READING;
+    if (conn->read_start == conn->read_pos) {
+        conn->request_start = io_thread->now_ms;
+    }
+    conn->read_pos += n;
+    conn->last_active = io_thread->now_ms;
+    
+    if (dispatch_requests(io_thread, conn) != 0) {
+        log_error("Bad request on fd=%d, closing", conn->fd);
+        close_connection(io_thread, conn);
+        return -1;
+    }
+    return 0;
+}
+
+// 处理读事件：直接读入连接的引用计数缓冲区，按 HTTP 请求边界切分后分发
+// 返回 -1 表示连接已关闭
+static int handle_read(io_thread_t *io_thread, connection_t *conn) {
     int n;
     
     while (1) {
-        n = read(conn->fd, buffer, sizeof(buffer));
+        if (ensure_read_space(conn) != 0) {
+            log_error("Failed to allocate read buffer for fd=%d", conn->fd);
+            close_connection(io_thread, conn);
+            return -1;
+        }
+        
+        buf_t *buf = conn->read_buf;
+        n = read(conn->fd, buf->data + conn->read_pos, buf->size - conn->read_pos);
         
         if (n > 0) {
-            // 更新统计
-            pthread_mutex_lock(&io_thread->stats_mutex);
-            io_thread->bytes_read += n;
-            pthread_mutex_unlock(&io_thread->stats_mutex);
-            
-            // 更新连接状态
-            conn->state = CONN_STATE_READING;
-            
-            // 创建处理任务并提交到工作线程池
-            task_t *task = task_create(TASK_TYPE_PROCESS, conn, buffer, n);
-            if (task) {
-                thread_pool_submit(io_thread->worker_pool, task);
-            } else {
-                log_error("Failed to create task for fd=%d", conn->fd);
+            if (consume_input(io_thread, conn, n) != 0) {
+                return -1;
             }
-            
-            conn->last_active = time(NULL);
         } else if (n == 0) {
             // 连接关闭
-            int conn_fd = conn->fd;
-            log_info("Connection closed by client: fd=%d", conn_fd);
-            conn_mark_closing(conn);
-            event_loop_del(io_thread->event_loop, conn_fd);
-            conn_release(conn);
-            return;
+            log_debug("Connection closed by client: fd=%d", conn->fd);
+            close_connection(io_thread, conn);
+            return -1;
         } else {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 // 数据读取完毕
-                break;
+                conn_timer_update(io_thread, conn);
+                return 0;
             } else {
-                int conn_fd = conn->fd;
                 log_error("Read error: %s", strerror(errno));
-                conn_mark_closing(conn);
-                event_loop_del(io_thread->event_loop, conn_fd);
-                conn_release(conn);
-                return;
+                close_connection(io_thread, conn);
+                return -1;
             }
         }
     }
 }
 
-// 处理写事件
-static void handle_write(io_thread_t *io_thread, connection_t *conn) {
-    if (conn->write_size <= 0) {
-        // 没有数据要写，切换回读模式
-        event_loop_mod(io_thread->event_loop, conn->fd, EVENT_READ | EVENT_ET, conn);
-        conn->state = CONN_STATE_READING;
-        return;
+// 完成模式的读事件：内核已把数据收进缓冲环，拷入连接的读缓冲区后同样按请求边界分发
+// 缓冲环中的缓冲区在下一次等待时归还，已交出的 slice 只引用连接自己的缓冲区
+// 返回 -1 表示连接已关闭
+static int handle_recv(io_thread_t *io_thread, connection_t *conn, const event_t *ev) {
+    if (ev->result <= 0) {
+        if (ev->result == 0) {
+            log_debug("Connection closed by client: fd=%d", conn->fd);
+        } else {
+            log_error("Read error: %s", strerror(-ev->result));
+        }
+        close_connection(io_thread, conn);
+        return -1;
     }
     
-    int n;
-    while (conn->write_pos < conn->write_size) {
-        n = write(conn->fd, conn->write_buf + conn->write_pos, 
-                 conn->write_size - conn->write_pos);
+    const char *data = ev->buf;
+    int left = ev->result;
+    while (left > 0) {
+        if (ensure_read_space(conn) != 0) {
+            log_error("Failed to allocate read buffer for fd=%d", conn->fd);
+            close_connection(io_thread, conn);
+            return -1;
+        }
+        
+        buf_t *buf = conn->read_buf;
+        int n = buf->size - conn->read_pos;
+        if (n > left) n = left;
+        memcpy(buf->data + conn->read_pos, data, n);
+        data += n;
+        left -= n;
+        
+        if (consume_input(io_thread, conn, n) != 0) {
+            return -1;
+        }
+    }
+    
+    conn_timer_update(io_thread, conn);
+    return 0;
+}
+
+// 写出输出链：内存片段按 IOV_MAX 分批 writev，文件片段 sendfile，部分写入时保留剩余片段并注册可写事件
+// 全部写完后恢复读事件；返回 -1 表示连接已关闭
+static int flush_output(io_thread_t *io_thread, connection_t *conn) {
+    struct iovec iov[IOV_MAX];
+    ssize_t n;
+    
+    while (!buf_chain_empty(&conn->out)) {
+        size_t batch_bytes;
+        n = buf_chain_write(conn->fd, &conn->out, iov, IOV_MAX, &batch_bytes);
         
         if (n > 0) {
-            conn->write_pos += n;
+            buf_chain_consume(&conn->out, n);
             
-            // 更新统计
-            pthread_mutex_lock(&io_thread->stats_mutex);
-            io_thread->bytes_written += n;
-            pthread_mutex_unlock(&io_thread->stats_mutex);
+            stat_add(&io_thread->stats.bytes_written, n);
+            
+            if (conn->out_ready_ns) {
+                uint64_t now_ns = metrics_now_ns();
+                metrics_record(METRIC_WRITE_WAIT, now_ns - conn->out_ready_ns);
+                if (conn->out_req_ns) {
+                    metrics_record(METRIC_END_TO_END, now_ns - conn->out_req_ns);
+                }
+                conn->out_ready_ns = 0;
+                conn->out_req_ns = 0;
+            }
             
-            conn->last_active = time(NULL);
+            conn->last_active = io_thread->now_ms;
+            
+            // 短写说明发送缓冲区已满，不再尝试必然返回 EAGAIN 的写
+            if ((size_t)n < batch_bytes) {
+                break;
+            }
         } else {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 暂时无法写入，等待下次事件
                 break;
+            } else if (errno == EINTR) {
+                continue;
             } else {
-                int conn_fd = conn->fd;
                 log_error("Write error: %s", strerror(errno));
-                conn_mark_closing(conn);
-                event_loop_del(io_thread->event_loop, conn_fd);
-                conn_release(conn);
-                return;
+                close_connection(io_thread, conn);
+                return -1;
             }
         }
     }
     
-    // 数据写完，切换回读模式
-    if (conn->write_pos >= conn->write_size) {
-        conn->write_pos = 0;
-        conn->write_size = 0;
-        event_loop_mod(io_thread->event_loop, conn->fd, EVENT_READ | EVENT_ET, conn);
-        conn->state = CONN_STATE_READING;
+    if (!buf_chain_empty(&conn->out)) {
+        // 暂时无法写入，等待可写事件
+        if (!conn->write_armed) {
+            event_loop_mod(io_thread->event_loop, conn->fd, EVENT_WRITE | EVENT_ET, conn);
+            if (io_thread->completions) {
+                // 与就绪模式一样，输出积压期间暂停接收
+                event_loop_recv_stop(io_thread->event_loop, conn->fd);
+            }
+            conn->write_armed = 1;
+            conn_timer_update(io_thread, conn);
+        }
+        return 0;
     }
+    
+    // 数据写完，切换回读模式（一次写完时无需任何 epoll_ctl）
+    if (conn->write_armed) {
+        event_loop_mod(io_thread->event_loop, conn->fd, conn_read_events(io_thread), conn);
+        if (io_thread->completions) {
+            event_loop_recv_start(io_thread->event_loop, conn->fd, conn);
+        }
+        conn->write_armed = 0;
+    }
+    conn->state = CONN_STATE_READING;
+    
+    // 没有乱序等待的响应时交还输出所有权，之后的响应可以由工作线程直接写
+    if (!conn->reorder && conn_is_valid(conn)) {
+        conn_output_release(conn);
+    }
+    return 0;
+}
+
+// 写出本轮登记的所有连接
+static void flush_pending(io_thread_t *io_thread) {
+    while (io_thread->flush_list) {
+        connection_t *conn = io_thread->flush_list;
+        io_thread->flush_list = conn->flush_next;
+        conn->flush_next = NULL;
+        conn->flush_queued = 0;
+        
+        // 已注册可写事件的连接等事件到来再写
+        if (conn_is_valid(conn) && !conn->write_armed) {
+            flush_output(io_thread, conn);
+        }
+        conn_release(conn);
+    }
+}
+
+// 将连接注册到本线程的 event loop
+static int io_thread_register_connection(io_thread_t *io_thread, connection_t *conn) {
+    conn->event_loop = io_thread->event_loop;
+    conn->io_thread = io_thread;
+    conn->last_active = io_thread->now_ms;
+    conn->request_start = io_thread->now_ms;
+    conn->timer.fn = conn_timer_expired;
+    
+    if (event_loop_add(io_thread->event_loop, conn->fd, 
+                       conn_read_events(io_thread), conn) != 0) {
+        log_error("Failed to add connection to epoll");
+        conn_release(conn);
+        return -1;
+    }
+    
+    if (io_thread->completions &&
+        event_loop_recv_start(io_thread->event_loop, conn->fd, conn) != 0) {
+        log_error("Failed to start receiving on fd=%d", conn->fd);
+        event_loop_del(io_thread->event_loop, conn->fd);
+        conn_release(conn);
+        return -1;
+    }
+    
+    conn_timer_update(io_thread, conn);
+    
+#ifdef SO_BUSY_POLL
+    // 套接字级忙轮询：读不到数据时在驱动队列上轮询一段时间
+    // 超过 net.core.busy_read 需要 CAP_NET_ADMIN，设置失败不影响连接
+    if (io_thread->busy_poll_us > 0) {
+        int usec = io_thread->busy_poll_us;
+        setsockopt(conn->fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+    }
+#endif
+    
+    stat_add(&io_thread->stats.connections_handled, 1);
+    stat_add(&io_thread->load.active_conns, 1);
+    
+    log_debug("IO thread %d: new connection fd=%d", 
+            io_thread->thread_index, conn->fd);
+    return 0;
+}
+
+// 为本线程接受的连接创建连接对象并注册
+static void accept_client(io_thread_t *io_thread, int client_fd, struct sockaddr_in *addr) {
+    int opt = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    
+    connection_t *conn = conn_create(client_fd, io_thread->event_loop, addr, io_thread,
+                                     io_thread->conn_pool);
+    if (!conn) {
+        log_error("Failed to create connection for fd=%d", client_fd);
+        close(client_fd);
+        return;
+    }
+    
+    io_thread_register_connection(io_thread, conn);
+}
+
+// 分片模式：在本线程内 accept，连接无需经过管道转交
+static void handle_accept(io_thread_t *io_thread) {
+    struct sockaddr_in client_addr;
+    socklen_t addr_len;
+    int client_fd;
+    
+    while (1) {
+        addr_len = sizeof(client_addr);
+        client_fd = accept(io_thread->listen_fd, (struct sockaddr*)&client_addr, &addr_len);
+        
+        if (client_fd == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            } else {
+                log_error("accept error: %s", strerror(errno));
+                break;
+            }
+        }
+        
+        set_nonblocking(client_fd);
+        accept_client(io_thread, client_fd, &client_addr);
+    }
+}
+
+static void accept_retry(tw_timer_t *timer, void *arg) {
+    (void)timer;
+    io_thread_t *io_thread = (io_thread_t*)arg;
+    
+    if (event_loop_accept_start(io_thread->event_loop, io_thread->listen_fd,
+                                &io_thread->listen_fd) != 0) {
+        log_error("IO thread %d: failed to restart accept", io_thread->thread_index);
+    }
+}
+
+// 完成模式的多发 accept：内核已接受连接（带 SOCK_NONBLOCK），result 即新的 fd
+static void handle_accept_completion(io_thread_t *io_thread, const event_t *ev) {
+    if (ev->result < 0) {
+        log_error("accept error: %s", strerror(-ev->result));
+        // 出错后 accept 已停止：除监听套接字本身失效外，稍后重新开始（fd 耗尽时不空转）
+        if (ev->result != -EBADF && ev->result != -EINVAL &&
+            !tw_timer_pending(&io_thread->accept_timer)) {
+            timer_wheel_add(&io_thread->timers, &io_thread->accept_timer,
+                            io_thread->now_ms + ACCEPT_RETRY_MS);
+        }
+        return;
+    }
+    
+    struct sockaddr_in client_addr;
+    socklen_t addr_len = sizeof(client_addr);
+    if (getpeername(ev->result, (struct sockaddr*)&client_addr, &addr_len) != 0) {
+        memset(&client_addr, 0, sizeof(client_addr));
+    }
+    
+    accept_client(io_thread, ev->result, &client_addr);
+}
+
+// 处理邮箱中的所有消息
+static void io_thread_process_messages(io_thread_t *io_thread) {
+    // 先清除唤醒标志再取消息：此后入队的生产者会重新发出唤醒
+    atomic_exchange(&io_thread->msg_signaled, 0);
+    
+    mpsc_node_t *node;
+    while ((node = mpsc_queue_pop(&io_thread->msg_queue))) {
+        io_message_t *msg = mpsc_container_of(node, io_message_t, node);
+        
+        if (!conn_is_valid(msg->conn)) {
+            free_message(msg);
+            continue;
+        }
+        
+        switch (msg->type) {
+            case IO_MSG_RESPONSE_READY:
+                deliver_response(io_thread, msg);
+                break;
+            case IO_MSG_CLOSE_CONN:
+                close_connection(io_thread, msg->conn);
+                free_message(msg);
+                break;
+            case IO_MSG_FLUSH:
+                // 工作线程已把输出所有权交过来
+                if (conn_is_valid(msg->conn)) {
+                    msg->conn->state = CONN_STATE_WRITING;
+                    schedule_flush(io_thread, msg->conn);
+                }
+                free_message(msg);
+                break;
+            default:
+                free_message(msg);
+                break;
+        }
+    }
+}
+
+// 每 LOAD_SAMPLE_MS 采样一次读写字节数，按 1/4 权重平滑为吞吐估计
+// 写给客户端的总字节数：IO 线程写出的加上工作线程直接写出的
+static long io_thread_bytes_written(io_thread_t *io_thread) {
+    return stat_read(&io_thread->stats.bytes_written) +
+           atomic_load_explicit(&io_thread->direct_bytes_written, memory_order_relaxed);
+}
+
+static void update_load(io_thread_t *io_thread) {
+    uint64_t elapsed = io_thread->now_ms - io_thread->load_sample_ms;
+    if (elapsed < LOAD_SAMPLE_MS) return;
+    
+    long bytes = stat_read(&io_thread->stats.bytes_read) + io_thread_bytes_written(io_thread);
+    long rate = (long)((bytes - io_thread->load_sample_bytes) * 1000 / (long)elapsed);
+    long smoothed = stat_read(&io_thread->load.bytes_rate);
+    long delta = rate - smoothed;
+    // 差值不足 4 时整除为 0，估计会停在非零值上（空闲后停在 3），此时直接取本次采样
+    stat_add(&io_thread->load.bytes_rate, (delta > -4 && delta < 4) ? delta : delta / 4);
+    
+    io_thread->load_sample_ms = io_thread->now_ms;
+    io_thread->load_sample_bytes = bytes;
+}
+
+// 阻塞等待的超时（微秒）：等到下一个定时器需要推进，没有定时器时无限期阻塞（-1）
+// 新连接、工作线程的响应和退出通知都通过描述符唤醒，不需要周期性醒来检查
+static long wait_timeout_us(io_thread_t *io_thread) {
+    long timeout_ms = timer_wheel_next_timeout(&io_thread->timers, io_thread->now_ms);
+    
+    // 吞吐估计不为 0 时继续定期采样，让它在空闲后衰减
+    if (stat_read(&io_thread->load.bytes_rate) != 0 &&
+        (timeout_ms < 0 || timeout_ms > LOAD_SAMPLE_MS)) {
+        timeout_ms = LOAD_SAMPLE_MS;
+    }
+    
+    if (timeout_ms < 0) return -1;
+    
+    // 粗粒度时钟可能比定时器晚一点，至少等 1 毫秒，避免在到期前空转
+    return (timeout_ms > 0 ? timeout_ms : 1) * 1000;
+}
+
+// 等待事件：先在自旋预算内反复零超时轮询，仍没有事件再阻塞
+// 自旋落空时预算减半；阻塞后在 busy_poll_us 内就被唤醒说明事件间隔短，预算翻倍
+static int io_thread_wait(io_thread_t *io_thread, event_t *events) {
+    if (io_thread->spin_us > 0) {
+        uint64_t deadline = metrics_now_ns() + (uint64_t)io_thread->spin_us * 1000;
+        do {
+            int nfds = event_loop_wait_us(io_thread->event_loop, events, MAX_EVENTS, 0);
+            if (nfds != 0) {
+                if (nfds > 0) stat_add(&io_thread->stats.spin_hits, 1);
+                return nfds;
+            }
+        } while (metrics_now_ns() < deadline);
+        io_thread->spin_us /= 2;
+    }
+    
+    uint64_t start = io_thread->busy_poll_us > 0 ? metrics_now_ns() : 0;
+    int nfds = event_loop_wait_us(io_thread->event_loop, events, MAX_EVENTS,
+                                  wait_timeout_us(io_thread));
+    stat_add(&io_thread->stats.sleeps, 1);
+    
+    if (io_thread->busy_poll_us > 0 && nfds > 0 &&
+        metrics_now_ns() - start <= (uint64_t)io_thread->busy_poll_us * 1000) {
+        long spin = io_thread->spin_us > 0 ? io_thread->spin_us * 2 : SPIN_MIN_US;
+        io_thread->spin_us = spin < io_thread->busy_poll_us ? spin : io_thread->busy_poll_us;
+    }
+    
+    return nfds;
 }
 
 // IO 线程主函数
@@ -105,74 +847,69 @@ static void* io_thread_run(void *arg) {
     
     log_info("IO thread %d started", io_thread->thread_index);
     
+    if (thread_placement_apply(&io_thread->placement) != 0) {
+        log_error("IO thread %d: failed to set CPU affinity", io_thread->thread_index);
+    }
+    
+    // 连接对象池归本线程所有，预分配的内存也由本线程首次写入（绑定 CPU 后即为本节点内存）
+    object_pool_bind(io_thread->conn_pool);
+    if (object_pool_prefill(io_thread->conn_pool, io_thread->conn_prealloc) != 0) {
+        log_error("IO thread %d: failed to preallocate %d connections",
+                 io_thread->thread_index, io_thread->conn_prealloc);
+    }
+    
     event_t events[MAX_EVENTS];
     
-    while (!io_thread->shutdown) {
-        int nfds = event_loop_wait(io_thread->event_loop, events, MAX_EVENTS, 1);
+    while (!atomic_load_explicit(&io_thread->shutdown, memory_order_relaxed)) {
+        int nfds = io_thread_wait(io_thread, events);
+        
+        // 本轮所有读写共用一次时钟读取
+        io_thread->now_ms = clock_now_ms();
         
         for (int i = 0; i < nfds; i++) {
             event_t *ev = &events[i];
             
+            // 检查是否是本线程的监听套接字（SO_REUSEPORT 分片模式）
+            if (ev->data == &io_thread->listen_fd) {
+                if (ev->events & EVENT_ACCEPT) {
+                    handle_accept_completion(io_thread, ev);
+                } else {
+                    handle_accept(io_thread);
+                }
+                continue;
+            }
+            
             // 检查是否是管道事件（用于接收新连接）
             if (ev->data == &io_thread->pipe_fd[0]) {
-                // 读取管道数据
-                connection_t *new_conn;
-                if (read(io_thread->pipe_fd[0], &new_conn, sizeof(new_conn)) == sizeof(new_conn)) {
-                    // 将新连接添加到 epoll
-                    new_conn->event_loop = io_thread->event_loop;
-                    new_conn->io_thread = io_thread;
-                    
-                    if (event_loop_add(io_thread->event_loop, new_conn->fd, 
-                                         EVENT_READ | EVENT_ET, new_conn) == 0) {
-                        pthread_mutex_lock(&io_thread->stats_mutex);
-                        io_thread->connections_handled++;
-                        pthread_mutex_unlock(&io_thread->stats_mutex);
-                        
-                        log_info("IO thread %d: new connection fd=%d", 
-                                io_thread->thread_index, new_conn->fd);
-                    } else {
-                        log_error("Failed to add connection to epoll");
-                        conn_release(new_conn);
+                // 边缘触发：一次读完管道中所有待接收的连接
+                conn_handoff_t handoff;
+                while (read(io_thread->pipe_fd[0], &handoff, sizeof(handoff)) == sizeof(handoff)) {
+                    atomic_fetch_sub_explicit(&io_thread->handoffs_pending, 1, memory_order_relaxed);
+                    connection_t *new_conn = conn_create(handoff.fd, io_thread->event_loop,
+                                                         &handoff.addr, io_thread,
+                                                         io_thread->conn_pool);
+                    if (!new_conn) {
+                        log_error("Failed to create connection for fd=%d", handoff.fd);
+                        close(handoff.fd);
+                        continue;
                     }
+                    // 将新连接添加到 epoll
+                    io_thread_register_connection(io_thread, new_conn);
                 }
                 continue;
             }
             
-            // 检查是否是消息管道事件
-            if (ev->data == &io_thread->msg_pipe_fd[0]) {
-                char dummy;
-                read(io_thread->msg_pipe_fd[0], &dummy, 1);  // 清空管道
-                
-                // 处理消息队列中的所有消息
-                pthread_mutex_lock(&io_thread->msg_queue_mutex);
-                while (io_thread->msg_queue_head) {
-                    io_message_t *msg = io_thread->msg_queue_head;
-                    io_thread->msg_queue_head = msg->next;
-                    if (!io_thread->msg_queue_head) {
-                        io_thread->msg_queue_tail = NULL;
-                    }
-                    pthread_mutex_unlock(&io_thread->msg_queue_mutex);
-                    
-                    // 处理消息（在释放队列锁后检查连接有效性）
-                    if (msg->type == IO_MSG_RESPONSE_READY) {
-                        if (conn_is_valid(msg->conn)) {
-                            event_loop_mod(io_thread->event_loop, msg->conn->fd, EVENT_WRITE | EVENT_ET, msg->conn);
-                        }
-                    }
-                    
-                    conn_release(msg->conn);
-                    free(msg);
-                    
-                    pthread_mutex_lock(&io_thread->msg_queue_mutex);
-                }
-                pthread_mutex_unlock(&io_thread->msg_queue_mutex);
+            // 检查是否是消息邮箱的唤醒事件
+            if (ev->data == &io_thread->msg_wakeup_fd[0]) {
+                wakeup_drain(io_thread->msg_wakeup_fd);
+                io_thread_process_messages(io_thread);
                 continue;
             }
             
             connection_t *conn = (connection_t*)ev->data;
             if (!conn) continue;
             
-            // Check if connection is already being closed to prevent double handling
+            // 本轮前面已关闭的连接（对象在本轮结束前不会释放）
             if (!conn_is_valid(conn)) {
                 continue;
             }
@@ -180,56 +917,96 @@ static void* io_thread_run(void *arg) {
             int conn_fd = conn->fd;  // Store fd before potential close
             
             if (ev->events & EVENT_READ) {
-                handle_read(io_thread, conn);
-                // Check if connection was closed during read
-                if (!conn_is_valid(conn)) {
+                // 连接在读取中被关闭时不能再访问
+                if (handle_read(io_thread, conn) != 0) {
                     continue;
                 }
             }
             
-            if (ev->events & EVENT_WRITE) {
-                handle_write(io_thread, conn);
-                // Check if connection was closed during write
-                if (!conn_is_valid(conn)) {
+            if (ev->events & EVENT_RECV) {
+                if (handle_recv(io_thread, conn, ev) != 0) {
+                    continue;
+                }
+            }
+            
+            // 只有输出积压时才注册可写事件，此时输出归 IO 线程所有
+            if ((ev->events & EVENT_WRITE) && conn->write_armed) {
+                if (flush_output(io_thread, conn) != 0) {
                     continue;
                 }
             }
             
             if (ev->events & (EVENT_ERROR | EVENT_HUP)) {
-                log_info("Connection error/hangup: fd=%d", conn_fd);
-                conn_mark_closing(conn);
-                event_loop_del(io_thread->event_loop, conn_fd);
-                conn_release(conn);
+                log_debug("Connection error/hangup: fd=%d", conn_fd);
+                close_connection(io_thread, conn);
             }
         }
+        
+        // 本轮产生的响应（内联处理或工作线程送回）统一写出
+        flush_pending(io_thread);
+        
+        // 检查超时连接
+        timer_wheel_advance(&io_thread->timers, io_thread->now_ms);
+        
+        release_closed(io_thread);
+        update_load(io_thread);
     }
     
+    release_closed(io_thread);
+    
     log_info("IO thread %d stopped", io_thread->thread_index);
     return NULL;
 }
 
 // 创建单个 IO 线程
-static io_thread_t* io_thread_create(int index, thread_pool_t *worker_pool) {
-    io_thread_t *io_thread = (io_thread_t*)malloc(sizeof(io_thread_t));
+static io_thread_t* io_thread_create(int index, thread_pool_t *worker_pool, int listen_fd,
+                                     const io_thread_config_t *config) {
+    io_thread_t *io_thread = (io_thread_t*)cache_aligned_calloc(1, sizeof(io_thread_t));
     if (!io_thread) return NULL;
     
     io_thread->thread_index = index;
     io_thread->worker_pool = worker_pool;
-    io_thread->shutdown = 0;
-    io_thread->connections_handled = 0;
-    io_thread->bytes_read = 0;
-    io_thread->bytes_written = 0;
+    io_thread->listen_fd = listen_fd;
+    atomic_init(&io_thread->shutdown, 0);
+    io_thread->conn_prealloc = config ? config->conn_prealloc : 0;
+    io_thread->run_to_completion = config ? config->run_to_completion : 0;
+    io_thread->idle_timeout_ms = config ? config->idle_timeout_ms : 0;
+    io_thread->header_timeout_ms = config ? config->header_timeout_ms : 0;
+    io_thread->write_timeout_ms = config ? config->write_timeout_ms : 0;
+    io_thread->busy_poll_us = config ? config->busy_poll_us : 0;
+    io_thread->direct_write = config ? config->direct_write : 0;
+    if (config && config->placement) {
+        io_thread->placement = config->placement[index];
+    } else {
+        io_thread->placement.node = -1;
+        io_thread->placement.group = -1;
+    }
+    io_thread->now_ms = clock_now_ms();
+    timer_wheel_init(&io_thread->timers, TIMER_TICK_MS, io_thread->now_ms);
+    tw_timer_init(&io_thread->accept_timer, accept_retry, io_thread);
+    io_thread->load_sample_ms = io_thread->now_ms;
+    io_thread->flush_list = NULL;
+    io_thread->release_list = NULL;
+    
+    // 创建连接对象池（预分配在线程启动后进行）
+    io_thread->conn_pool = object_pool_create("connection", sizeof(connection_t));
+    if (!io_thread->conn_pool) {
+        free(io_thread);
+        return NULL;
+    }
     
     // 创建管道用于通信
     if (pipe(io_thread->pipe_fd) == -1) {
+        object_pool_destroy(io_thread->conn_pool);
         free(io_thread);
         return NULL;
     }
     
-    // 创建消息管道
-    if (pipe(io_thread->msg_pipe_fd) == -1) {
+    // 创建消息唤醒描述符
+    if (wakeup_open(io_thread->msg_wakeup_fd) == -1) {
         close(io_thread->pipe_fd[0]);
         close(io_thread->pipe_fd[1]);
+        object_pool_destroy(io_thread->conn_pool);
         free(io_thread);
         return NULL;
     }
@@ -237,24 +1014,22 @@ static io_thread_t* io_thread_create(int index, thread_pool_t *worker_pool) {
     // 设置管道为非阻塞
     set_nonblocking(io_thread->pipe_fd[0]);
     set_nonblocking(io_thread->pipe_fd[1]);
-    set_nonblocking(io_thread->msg_pipe_fd[0]);
-    set_nonblocking(io_thread->msg_pipe_fd[1]);
-    
-    // 初始化消息队列
-    io_thread->msg_queue_head = NULL;
-    io_thread->msg_queue_tail = NULL;
-    pthread_mutex_init(&io_thread->msg_queue_mutex, NULL);
     
-    pthread_mutex_init(&io_thread->stats_mutex, NULL);
+    // 初始化消息邮箱
+    mpsc_queue_init(&io_thread->msg_queue);
+    atomic_init(&io_thread->msg_signaled, 0);
     
     // 创建 event loop 实例
     io_thread->event_loop = event_loop_create(MAX_EVENTS);
     if (!io_thread->event_loop) {
         close(io_thread->pipe_fd[0]);
         close(io_thread->pipe_fd[1]);
+        wakeup_close(io_thread->msg_wakeup_fd);
+        object_pool_destroy(io_thread->conn_pool);
         free(io_thread);
         return NULL;
     }
+    io_thread->completions = io_thread->event_loop->completions;
     
     // 将管道读端添加到 epoll
     if (event_loop_add(io_thread->event_loop, io_thread->pipe_fd[0], 
@@ -262,20 +1037,35 @@ static io_thread_t* io_thread_create(int index, thread_pool_t *worker_pool) {
         event_loop_destroy(io_thread->event_loop);
         close(io_thread->pipe_fd[0]);
         close(io_thread->pipe_fd[1]);
-        close(io_thread->msg_pipe_fd[0]);
-        close(io_thread->msg_pipe_fd[1]);
+        wakeup_close(io_thread->msg_wakeup_fd);
+        object_pool_destroy(io_thread->conn_pool);
         free(io_thread);
         return NULL;
     }
     
-    // 将消息管道读端添加到 epoll
-    if (event_loop_add(io_thread->event_loop, io_thread->msg_pipe_fd[0], 
-                         EVENT_READ | EVENT_ET, &io_thread->msg_pipe_fd[0]) == -1) {
+    // 将消息唤醒描述符添加到 epoll
+    if (event_loop_add(io_thread->event_loop, io_thread->msg_wakeup_fd[0], 
+                         EVENT_READ | EVENT_ET, &io_thread->msg_wakeup_fd[0]) == -1) {
         event_loop_destroy(io_thread->event_loop);
         close(io_thread->pipe_fd[0]);
         close(io_thread->pipe_fd[1]);
-        close(io_thread->msg_pipe_fd[0]);
-        close(io_thread->msg_pipe_fd[1]);
+        wakeup_close(io_thread->msg_wakeup_fd);
+        object_pool_destroy(io_thread->conn_pool);
+        free(io_thread);
+        return NULL;
+    }
+    
+    // 分片模式：监听套接字在线程启动前注册，之后只由本线程访问
+    if (io_thread->listen_fd != -1 &&
+        (io_thread->completions ?
+         event_loop_accept_start(io_thread->event_loop, io_thread->listen_fd, &io_thread->listen_fd) :
+         event_loop_add(io_thread->event_loop, io_thread->listen_fd,
+                        EVENT_READ | EVENT_ET, &io_thread->listen_fd)) == -1) {
+        event_loop_destroy(io_thread->event_loop);
+        close(io_thread->pipe_fd[0]);
+        close(io_thread->pipe_fd[1]);
+        wakeup_close(io_thread->msg_wakeup_fd);
+        object_pool_destroy(io_thread->conn_pool);
         free(io_thread);
         return NULL;
     }
@@ -285,6 +1075,8 @@ static io_thread_t* io_thread_create(int index, thread_pool_t *worker_pool) {
         event_loop_destroy(io_thread->event_loop);
         close(io_thread->pipe_fd[0]);
         close(io_thread->pipe_fd[1]);
+        wakeup_close(io_thread->msg_wakeup_fd);
+        object_pool_destroy(io_thread->conn_pool);
         free(io_thread);
         return NULL;
     }
@@ -296,37 +1088,56 @@ static io_thread_t* io_thread_create(int index, thread_pool_t *worker_pool) {
 static void io_thread_destroy(io_thread_t *io_thread) {
     if (!io_thread) return;
     
-    io_thread->shutdown = 1;
+    atomic_store(&io_thread->shutdown, 1);
     
-    // 通过管道通知线程退出
-    char dummy = 1;
-    write(io_thread->pipe_fd[1], &dummy, 1);
+    // 唤醒阻塞等待中的线程，让它看到退出标志
+    wakeup_signal(io_thread->msg_wakeup_fd);
     
     // 等待线程退出
     pthread_join(io_thread->thread_id, NULL);
     
+    // 释放邮箱中未处理的消息
+    mpsc_node_t *node;
+    while ((node = mpsc_queue_pop(&io_thread->msg_queue))) {
+        io_message_t *msg = mpsc_container_of(node, io_message_t, node);
+        free_message(msg);
+    }
+    
     // 清理资源
     event_loop_destroy(io_thread->event_loop);
     close(io_thread->pipe_fd[0]);
     close(io_thread->pipe_fd[1]);
-    pthread_mutex_destroy(&io_thread->stats_mutex);
+    wakeup_close(io_thread->msg_wakeup_fd);
     
     log_info("IO thread %d stats: connections=%ld, read=%ld bytes, written=%ld bytes",
-            io_thread->thread_index, io_thread->connections_handled,
-            io_thread->bytes_read, io_thread->bytes_written);
+            io_thread->thread_index, stat_read(&io_thread->stats.connections_handled),
+            stat_read(&io_thread->stats.bytes_read), io_thread_bytes_written(io_thread));
+    log_info("IO thread %d timers: timeouts=%ld, expired=%ld, cascaded=%ld, pending=%ld",
+            io_thread->thread_index, stat_read(&io_thread->stats.timeouts), io_thread->timers.expired,
+            io_thread->timers.cascaded, io_thread->timers.count);
+    
+    object_pool_stats_t pool_stats;
+    object_pool_get_stats(io_thread->conn_pool, &pool_stats);
+    log_info("IO thread %d conn pool: capacity=%ld, hits=%ld, misses=%ld, remote_frees=%ld",
+            io_thread->thread_index, pool_stats.capacity, pool_stats.hits,
+            pool_stats.misses, pool_stats.remote_frees);
+    
+    // 仍被工作线程引用的连接归还后，对象池才真正释放
+    object_pool_destroy(io_thread->conn_pool);
     
     free(io_thread);
 }
 
 // 创建 IO 线程池
-io_thread_pool_t* io_thread_pool_create(int io_thread_count, thread_pool_t *worker_pool) {
+io_thread_pool_t* io_thread_pool_create(int io_thread_count, thread_pool_t *worker_pool,
+                                        const int *listen_fds, const io_thread_config_t *config) {
     io_thread_pool_t *pool = (io_thread_pool_t*)malloc(sizeof(io_thread_pool_t));
     if (!pool) return NULL;
     
     pool->thread_count = io_thread_count;
-    pool->next_thread = 0;
+    pool->dispatch = config ? config->dispatch : IO_DISPATCH_ROUND_ROBIN;
+    atomic_init(&pool->next_thread, 0);
     pool->worker_pool = worker_pool;
-    pthread_mutex_init(&pool->mutex, NULL);
     
     pool->threads = (io_thread_t**)malloc(sizeof(io_thread_t*) * io_thread_count);
     if (!pool->threads) {
@@ -335,7 +1146,7 @@ io_thread_pool_t* io_thread_pool_create(int io_thread_count, thread_pool_t *work
     }
     
     for (int i = 0; i < io_thread_count; i++) {
-        pool->threads[i] = io_thread_create(i, worker_pool);
+        pool->threads[i] = io_thread_create(i, worker_pool, listen_fds ? listen_fds[i] : -1, config);
         if (!pool->threads[i]) {
             // 清理已创建的线程
             for (int j = 0; j < i; j++) {
@@ -362,68 +1173,322 @@ void io_thread_pool_destroy(io_thread_pool_t *pool) {
     }
     
     free(pool->threads);
-    pthread_mutex_destroy(&pool->mutex);
     free(pool);
     
     log_info("IO thread pool destroyed");
 }
 
-// 轮询获取下一个 IO 线程
+// 线程当前承担的连接数：已注册的加上已转交尚未接收的（一批 accept 不会全落到同一线程）
+static long io_thread_conn_load(io_thread_t *io_thread) {
+    return stat_read(&io_thread->load.active_conns) +
+           atomic_load_explicit(&io_thread->handoffs_pending, memory_order_relaxed);
+}
+
+// p2c 的负载：连接数加上按吞吐折算的连接数，少量重连接的线程也会被视为繁忙
+static long io_thread_p2c_load(io_thread_t *io_thread) {
+    return io_thread_conn_load(io_thread) +
+           stat_read(&io_thread->load.bytes_rate) / LOAD_BYTES_PER_CONN;
+}
+
+static unsigned int dispatch_rand(void) {
+    unsigned int x = tls_dispatch_rand;
+    if (x == 0) {
+        x = (unsigned int)(uintptr_t)&tls_dispatch_rand ^ (unsigned int)clock_now_ms() ^ 0x9E3779B9u;
+    }
+    
+    // xorshift32
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    tls_dispatch_rand = x;
+    return x;
+}
+
+// 按分配策略选择 IO 线程；负载信号由各 IO 线程自己维护，这里只读，不加锁
 io_thread_t* io_thread_pool_get_thread(io_thread_pool_t *pool) {
     if (!pool || pool->thread_count == 0) return NULL;
     
-    pthread_mutex_lock(&pool->mutex);
-    io_thread_t *thread = pool->threads[pool->next_thread];
-    pool->next_thread = (pool->next_thread + 1) % pool->thread_count;
-    pthread_mutex_unlock(&pool->mutex);
+    int n = pool->thread_count;
+    if (n == 1) return pool->threads[0];
     
-    return thread;
+    switch (pool->dispatch) {
+        case IO_DISPATCH_LEAST_CONN: {
+            // 从轮转的起点开始扫描，连接数相同时不总是偏向前面的线程
+            int start = (int)(atomic_fetch_add_explicit(&pool->next_thread, 1,
+                                                        memory_order_relaxed) % (unsigned int)n);
+            io_thread_t *best = pool->threads[start];
+            long best_load = io_thread_conn_load(best);
+            for (int i = 1; i < n && best_load > 0; i++) {
+                io_thread_t *t = pool->threads[(start + i) % n];
+                long load = io_thread_conn_load(t);
+                if (load < best_load) {
+                    best = t;
+                    best_load = load;
+                }
+            }
+            return best;
+        }
+            
+        case IO_DISPATCH_P2C: {
+            unsigned int r = dispatch_rand();
+            int a = (int)(r % (unsigned int)n);
+            int b = (int)((r >> 16) % (unsigned int)(n - 1));
+            if (b >= a) {
+                b++;
+            }
+            io_thread_t *ta = pool->threads[a];
+            io_thread_t *tb = pool->threads[b];
+            return io_thread_p2c_load(tb) < io_thread_p2c_load(ta) ? tb : ta;
+        }
+            
+        case IO_DISPATCH_ROUND_ROBIN:
+        default:
+            return pool->threads[atomic_fetch_add_explicit(&pool->next_thread, 1,
+                                                           memory_order_relaxed) % (unsigned int)n];
+    }
+}
+
+int io_dispatch_parse(const char *name, io_dispatch_t *dispatch) {
+    if (!name || !dispatch) return -1;
+    
+    if (strcmp(name, "rr") == 0) {
+        *dispatch = IO_DISPATCH_ROUND_ROBIN;
+    } else if (strcmp(name, "least") == 0) {
+        *dispatch = IO_DISPATCH_LEAST_CONN;
+    } else if (strcmp(name, "p2c") == 0) {
+        *dispatch = IO_DISPATCH_P2C;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* io_dispatch_name(io_dispatch_t dispatch) {
+    switch (dispatch) {
+        case IO_DISPATCH_LEAST_CONN: return "least";
+        case IO_DISPATCH_P2C:        return "p2c";
+        default:                     return "rr";
+    }
+}
+
+// 汇总所有 IO 线程的连接对象池统计（读取时不加锁，数值仅用于观测）
+void io_thread_pool_conn_pool_stats(io_thread_pool_t *pool, object_pool_stats_t *stats) {
+    if (!pool || !stats) return;
+    
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < pool->thread_count; i++) {
+        object_pool_stats_t s;
+        object_pool_get_stats(pool->threads[i]->conn_pool, &s);
+        stats->capacity += s.capacity;
+        stats->hits += s.hits;
+        stats->misses += s.misses;
+        stats->remote_frees += s.remote_frees;
+    }
+}
+
+// 汇总所有 IO 线程处理过的连接数
+long io_thread_pool_total_connections(io_thread_pool_t *pool) {
+    if (!pool) return 0;
+    
+    long total = 0;
+    for (int i = 0; i < pool->thread_count; i++) {
+        total += stat_read(&pool->threads[i]->stats.connections_handled);
+    }
+    
+    return total;
+}
+
+// 输出一组按 IO 线程区分的计数器（offset 为计数器在 io_thread_t 中的偏移）
+static void collect_io_counter(io_thread_pool_t *pool, metrics_out_t *out, const char *name,
+                               const char *type, const char *help, size_t offset) {
+    metrics_printf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    for (int i = 0; i < pool->thread_count; i++) {
+        const char *base = (const char*)pool->threads[i];
+        metrics_printf(out, "%s{thread=\"%d\"} %ld\n", name, i,
+                       stat_read((const stat_counter_t*)(base + offset)));
+    }
+}
+
+void io_thread_pool_collect_metrics(void *arg, metrics_out_t *out) {
+    io_thread_pool_t *pool = (io_thread_pool_t*)arg;
+    
+    collect_io_counter(pool, out, "reactor_io_connections_total", "counter",
+                       "Connections accepted", offsetof(io_thread_t, stats.connections_handled));
+    collect_io_counter(pool, out, "reactor_io_read_bytes_total", "counter",
+                       "Bytes read from clients", offsetof(io_thread_t, stats.bytes_read));
+    metrics_printf(out, "# HELP reactor_io_written_bytes_total Bytes written to clients\n"
+                   "# TYPE reactor_io_written_bytes_total counter\n");
+    for (int i = 0; i < pool->thread_count; i++) {
+        metrics_printf(out, "reactor_io_written_bytes_total{thread=\"%d\"} %ld\n", i,
+                       io_thread_bytes_written(pool->threads[i]));
+    }
+    collect_io_counter(pool, out, "reactor_io_timeouts_total", "counter",
+                       "Connections closed by a timeout", offsetof(io_thread_t, stats.timeouts));
+    collect_io_counter(pool, out, "reactor_io_sleeps_total", "counter",
+                       "Blocking event loop waits", offsetof(io_thread_t, stats.sleeps));
+    collect_io_counter(pool, out, "reactor_io_spin_hits_total", "counter",
+                       "Events found while busy polling", offsetof(io_thread_t, stats.spin_hits));
+    collect_io_counter(pool, out, "reactor_io_active_connections", "gauge",
+                       "Open connections", offsetof(io_thread_t, load.active_conns));
+    collect_io_counter(pool, out, "reactor_io_bytes_per_second", "gauge",
+                       "Recent read+write throughput (smoothed)", offsetof(io_thread_t, load.bytes_rate));
+    
+    metrics_printf(out, "# HELP reactor_heap_allocations_total Object pool heap allocations\n"
+                   "# TYPE reactor_heap_allocations_total counter\n"
+                   "reactor_heap_allocations_total %ld\n", object_pool_heap_allocs());
 }
 
 // 添加连接到 IO 线程
 int io_thread_add_connection(io_thread_t *io_thread, int client_fd, struct sockaddr_in *addr) {
     if (!io_thread || client_fd < 0) return -1;
     
-    // 创建连接对象 (event_loop will be set later in the IO thread)
-    connection_t *conn = conn_create(client_fd, NULL, addr, io_thread);
-    if (!conn) return -1;
+    // 连接对象由 IO 线程从自己的对象池创建，这里只转交 fd 和地址
+    conn_handoff_t handoff;
+    handoff.fd = client_fd;
+    if (addr) {
+        handoff.addr = *addr;
+    } else {
+        memset(&handoff.addr, 0, sizeof(handoff.addr));
+    }
     
-    // 通过管道发送连接指针到 IO 线程
-    if (write(io_thread->pipe_fd[1], &conn, sizeof(conn)) != sizeof(conn)) {
-        conn_release(conn);
+    // 先计入待接收数，分配方在 IO 线程接收之前就能看到这个连接
+    atomic_fetch_add_explicit(&io_thread->handoffs_pending, 1, memory_order_relaxed);
+    if (write(io_thread->pipe_fd[1], &handoff, sizeof(handoff)) != sizeof(handoff)) {
+        atomic_fetch_sub_explicit(&io_thread->handoffs_pending, 1, memory_order_relaxed);
         return -1;
     }
     
     return 0;
 }
 
+// 把消息放入 IO 线程邮箱
+static void mailbox_push(io_thread_t *io_thread, io_message_t *msg) {
+    mpsc_queue_push(&io_thread->msg_queue, &msg->node);
+    
+    // 只有邮箱从空闲变为待处理时才唤醒 IO 线程，其余消息搭同一次唤醒
+    if (!atomic_exchange(&io_thread->msg_signaled, 1)) {
+        wakeup_signal(io_thread->msg_wakeup_fd);
+    }
+}
+
+// 分配消息（调用线程的消息对象池），并增加连接引用计数，由 IO 线程处理完消息后释放
+static io_message_t* message_create(io_msg_type_t type, connection_t *conn) {
+    object_pool_t *msg_pool = object_pool_thread_local(&tls_msg_pool, "io_message",
+                                                       sizeof(io_message_t), MSG_POOL_PREFILL);
+    io_message_t *msg = (io_message_t*)object_pool_alloc(msg_pool);
+    if (!msg) return NULL;
+    
+    msg->type = type;
+    msg->conn = conn;
+    msg->seq = 0;
+    msg->req_ns = 0;
+    msg->next = NULL;
+    buf_chain_init(&msg->chain);
+    
+    conn_acquire(conn);
+    return msg;
+}
+
 // 向IO线程发送消息
 void io_thread_send_message(io_thread_t *io_thread, io_msg_type_t type, connection_t *conn) {
     if (!io_thread || !conn) return;
     
-    // 创建消息
-    io_message_t *msg = (io_message_t*)malloc(sizeof(io_message_t));
+    io_message_t *msg = message_create(type, conn);
     if (!msg) return;
     
-    msg->type = type;
-    msg->conn = conn;
-    msg->next = NULL;
+    mailbox_push(io_thread, msg);
+}
+
+// 把第 seq 个请求的响应交给 IO 线程
+// 分批 writev / sendfile，直到写完、发送缓冲区满或出错；返回写出的字节数
+static long write_chain(int fd, buf_chain_t *chain) {
+    struct iovec iov[IOV_MAX];
+    long total = 0;
+    
+    while (!buf_chain_empty(chain)) {
+        size_t batch_bytes;
+        ssize_t n = buf_chain_write(fd, chain, iov, IOV_MAX, &batch_bytes);
+        if (n > 0) {
+            buf_chain_consume(chain, n);
+            total += n;
+            if ((size_t)n < batch_bytes) break;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            // EAGAIN 或出错：剩下的交给 IO 线程
+            break;
+        }
+    }
     
-    // 将消息添加到队列（先获取队列锁，再增加引用计数）
-    pthread_mutex_lock(&io_thread->msg_queue_mutex);
+    return total;
+}
+
+// 工作线程持有输出所有权时直接写出响应
+// 写不完（发送缓冲区满或出错）时剩余输出连同所有权交给 IO 线程，由它注册可写事件或发现错误后关闭
+static long direct_write(io_thread_t *io_thread, connection_t *conn, unsigned long seq,
+                         uint64_t req_ns, buf_chain_t *chain) {
+    uint64_t ready_ns = metrics_now_ns();
+    long written = write_chain(conn->fd, chain);
+    atomic_store_explicit(&conn->resp_seq, seq + 1, memory_order_relaxed);
     
-    // 增加连接引用计数
-    conn_acquire(conn);
+    if (written > 0) {
+        atomic_fetch_add_explicit(&io_thread->direct_bytes_written, written, memory_order_relaxed);
+        uint64_t now_ns = metrics_now_ns();
+        metrics_record(METRIC_WRITE_WAIT, now_ns - ready_ns);
+        if (req_ns) {
+            metrics_record(METRIC_END_TO_END, now_ns - req_ns);
+        }
+    }
+    
+    if (buf_chain_empty(chain)) {
+        conn_output_release(conn);
+        return written;
+    }
+    
+    buf_chain_move(&conn->out, chain);
+    if (written == 0) {
+        conn->out_ready_ns = ready_ns;
+        conn->out_req_ns = req_ns;
+    }
+    atomic_store_explicit(&conn->output_owner, CONN_OUTPUT_IO, memory_order_release);
     
-    if (io_thread->msg_queue_tail) {
-        io_thread->msg_queue_tail->next = msg;
+    io_message_t *msg = message_create(IO_MSG_FLUSH, conn);
+    if (msg) {
+        mailbox_push(io_thread, msg);
     } else {
-        io_thread->msg_queue_head = msg;
+        // 剩余输出没有人负责写出：关闭套接字的读写两端，IO 线程随后读到 EOF/挂断，
+        // 按正常路径注销并关闭连接（fd 仍在 IO 线程的 event loop 中，不能在这里 close）
+        log_error("Failed to hand over output for fd=%d, closing", conn->fd);
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+    return written;
+}
+
+long io_thread_send_response(io_thread_t *io_thread, connection_t *conn, unsigned long seq,
+                             uint64_t req_ns, buf_chain_t *chain) {
+    if (!io_thread || !conn) {
+        buf_chain_clear(chain);
+        return 0;
     }
-    io_thread->msg_queue_tail = msg;
-    pthread_mutex_unlock(&io_thread->msg_queue_mutex);
     
-    // 通知IO线程处理消息
-    char dummy = 1;
-    write(io_thread->msg_pipe_fd[1], &dummy, 1);
-}
\ No newline at end of file
+    // 轮到这个响应且连接没有待发送的输出时直接写，省去唤醒 IO 线程、一轮事件循环和 epoll_ctl
+    if (io_thread->direct_write && conn_output_try_acquire(conn)) {
+        if (conn_is_valid(conn) && atomic_load_explicit(&conn->resp_seq, memory_order_relaxed) == seq) {
+            return direct_write(io_thread, conn, seq, req_ns, chain);
+        }
+        conn_output_release(conn);
+    }
+    
+    io_message_t *msg = message_create(IO_MSG_RESPONSE_READY, conn);
+    if (!msg) {
+        buf_chain_clear(chain);
+        return 0;
+    }
+    
+    msg->seq = seq;
+    msg->req_ns = req_ns;
+    buf_chain_move(&msg->chain, chain);
+    
+    mailbox_push(io_thread, msg);
+    return 0;
+}
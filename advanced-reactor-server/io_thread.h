@@ -5,50 +5,156 @@
 #include "common.h"
 #include "event_loop.h"
 #include "thread_pool.h"
+#include "object_pool.h"
+#include "metrics.h"
 
+// 新连接的分配策略（主线程 accept 时使用；SO_REUSEPORT 分片模式下由内核分配）
+typedef enum {
+    IO_DISPATCH_ROUND_ROBIN,    // 轮询
+    IO_DISPATCH_LEAST_CONN,     // 连接数（含已转交尚未接收的）最少的线程
+    IO_DISPATCH_P2C             // 随机取两个线程，按连接数和近期吞吐选较轻的
+} io_dispatch_t;
+
+// IO 线程配置
+typedef struct io_thread_config {
+    int conn_prealloc;     // 每个 IO 线程预分配的连接对象数
+    int run_to_completion; // 非阻塞处理函数直接在 IO 线程执行
+    int idle_timeout_ms;   // 空闲连接超时（0 表示不限）
+    int header_timeout_ms; // 请求头接收超时，从请求第一个字节算起（0 表示不限）
+    int write_timeout_ms;  // 输出积压且没有写出进展的超时（0 表示不限）
+    io_dispatch_t dispatch;
+    int busy_poll_us;      // 自适应忙轮询的最长自旋时间（微秒，0 表示没有事件时直接阻塞）
+    int direct_write;      // 工作线程在连接没有积压输出时直接写出响应
+    const thread_placement_t *placement;  // 第 i 个 IO 线程的放置（NULL 表示不绑定）
+} io_thread_config_t;
+
+// IO 线程统计（只由 IO 线程写入，其它线程随时读取）
+typedef struct io_thread_stats {
+    stat_counter_t connections_handled;
+    stat_counter_t bytes_read;
+    stat_counter_t bytes_written;
+    stat_counter_t timeouts;   // 因超时关闭的连接数
+    stat_counter_t sleeps;     // 阻塞等待次数
+    stat_counter_t spin_hits;  // 自旋期间等到事件的次数
+} io_thread_stats_t;
+
+// IO 线程负载信号（只由 IO 线程写入，分配新连接时读取）
+typedef struct io_thread_load {
+    stat_counter_t active_conns;    // 已注册的连接数
+    stat_counter_t bytes_rate;      // 近期读写吞吐（字节/秒，指数平滑）
+} io_thread_load_t;
+
+// 按写入方分组：只读配置、IO 线程私有状态、工作线程写入的邮箱、统计各占独立的缓存行
 typedef struct io_thread {
     pthread_t thread_id;
     int thread_index;
     event_loop_t *event_loop;  // Changed from epoll_wrapper_t
     thread_pool_t *worker_pool;
     int pipe_fd[2];        // 用于主线程通知 IO 线程
-    int shutdown;
-    
-    // 消息队列
-    io_message_t *msg_queue_head;
-    io_message_t *msg_queue_tail;
-    pthread_mutex_t msg_queue_mutex;
-    int msg_pipe_fd[2];    // 用于消息通知的管道
-    
-    // 统计信息
-    long connections_handled;
-    long bytes_read;
-    long bytes_written;
-    pthread_mutex_t stats_mutex;
+    int listen_fd;         // SO_REUSEPORT 分片模式下本线程的监听套接字（-1 表示未启用）
+    atomic_int shutdown;
+    int msg_wakeup_fd[2];  // Linux 上两端为同一个 eventfd，其它平台为管道
+    
+    // 连接对象池（本线程分配，任意线程归还）
+    object_pool_t *conn_pool;
+    int conn_prealloc;
+    thread_placement_t placement;  // 线程启动时绑定的 CPU
+    
+    // run-to-completion：非阻塞处理函数在本线程执行，响应直接写出
+    int run_to_completion;
+    
+    // 工作线程直接写响应（只读配置，工作线程读取）
+    int direct_write;
+    
+    int idle_timeout_ms;
+    int header_timeout_ms;
+    int write_timeout_ms;
+    int busy_poll_us;
+    
+    // 完成模式（io_uring）：内核把数据收进缓冲环后以 EVENT_RECV 送达，不再逐次 read；
+    // 分片模式下的监听套接字用多发 accept
+    int completions;
+    
+    // 以下为 IO 线程私有状态
+    // 连接超时：每轮事件循环缓存一次时钟，定时器挂在本线程的时间轮上
+    uint64_t now_ms CACHE_ALIGNED;
+    timer_wheel_t timers;
+    
+    // 完成模式下 accept 出错后，到期时重新开始 accept
+    tw_timer_t accept_timer;
+    
+    // 本轮事件处理中有新响应、等待统一写出的连接
+    connection_t *flush_list;
+    
+    // 本轮已关闭的连接：同一批事件中可能还有指向它们的事件，本轮结束后才释放引用
+    connection_t *release_list;
+    
+    // 上次采样吞吐的时间和累计字节数
+    uint64_t load_sample_ms;
+    long load_sample_bytes;
+    
+    // 当前自旋预算（微秒），在 0 和 busy_poll_us 之间自适应
+    long spin_us;
+    
+    // 消息邮箱（工作线程 -> IO 线程）：无锁 MPSC 队列 + 合并唤醒
+    mpsc_queue_t msg_queue CACHE_ALIGNED;
+    atomic_int msg_signaled CACHE_ALIGNED;  // 已发出唤醒、IO 线程尚未开始处理
+    
+    // 分配方写入：已写入管道、IO 线程尚未接收的连接数
+    atomic_int handoffs_pending CACHE_ALIGNED;
+    
+    // 工作线程直接写出的字节数（多个工作线程写入，不能用单写入方的 stat_counter_t）
+    atomic_long direct_bytes_written CACHE_ALIGNED;
+    
+    io_thread_load_t load CACHE_ALIGNED;
+    io_thread_stats_t stats CACHE_ALIGNED;
 } io_thread_t;
 
 // IO 线程池
 typedef struct io_thread_pool {
     io_thread_t **threads;
     int thread_count;
-    int next_thread;       // 轮询分配连接
-    pthread_mutex_t mutex;
+    io_dispatch_t dispatch;
+    atomic_uint next_thread;   // 轮询位置（最少连接策略中作为平局时的起点）
     thread_pool_t *worker_pool;
 } io_thread_pool_t;
 
-// 创建 IO 线程池
-io_thread_pool_t* io_thread_pool_create(int io_thread_count, thread_pool_t *worker_pool);
+// 创建 IO 线程池（listen_fds 非空时第 i 个 IO 线程自行 accept listen_fds[i]）
+io_thread_pool_t* io_thread_pool_create(int io_thread_count, thread_pool_t *worker_pool,
+                                        const int *listen_fds, const io_thread_config_t *config);
 
 // 销毁 IO 线程池
 void io_thread_pool_destroy(io_thread_pool_t *pool);
 
-// 分配连接到 IO 线程（轮询）
+// 按分配策略为新连接选择 IO 线程（无锁，可在任意线程调用）
 io_thread_t* io_thread_pool_get_thread(io_thread_pool_t *pool);
 
+// 解析分配策略名（rr、least、p2c），成功返回 0
+int io_dispatch_parse(const char *name, io_dispatch_t *dispatch);
+
+const char* io_dispatch_name(io_dispatch_t dispatch);
+
 // 添加连接到 IO 线程
 int io_thread_add_connection(io_thread_t *io_thread, int client_fd, struct sockaddr_in *addr);
 
+// 汇总所有 IO 线程的连接对象池统计
+void io_thread_pool_conn_pool_stats(io_thread_pool_t *pool, object_pool_stats_t *stats);
+
+// 汇总所有 IO 线程处理过的连接数
+long io_thread_pool_total_connections(io_thread_pool_t *pool);
+
+// /metrics 收集函数（arg 为 io_thread_pool_t）：各 IO 线程的连接、字节、超时计数和负载信号
+void io_thread_pool_collect_metrics(void *arg, metrics_out_t *out);
+
 // 向IO线程发送消息
 void io_thread_send_message(io_thread_t *io_thread, io_msg_type_t type, connection_t *conn);
 
+// 把连接上第 seq 个请求的响应片段交给 IO 线程（调用后 chain 为空）
+// IO 线程按序号顺序发送，流水线请求的响应不会乱序；启用 direct_write 时，轮到这个响应
+// 且连接没有积压输出的情况下由调用线程直接写出，只有写不完的部分才交给 IO 线程
+// req_ns 为请求的成帧时间（metrics_now_ns），用于统计端到端延迟，0 表示不统计
+// 返回调用线程直接写出的字节数
+long io_thread_send_response(io_thread_t *io_thread, connection_t *conn, unsigned long seq,
+                             uint64_t req_ns, buf_chain_t *chain);
+
 #endif // IO_THREAD_H
\ No newline at end of file
@@ -0,0 +1,817 @@
+// log.c
+#define _GNU_SOURCE
+#include "common.h"
+#include "metrics.h"
+#include <stdarg.h>
+
+// 每个线程的环形缓冲区大小（2 的幂）
+#define LOG_RING_SIZE (1 << 20)
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+
+// 记录按 LOG_ALIGN 对齐，保证回绕处剩余空间总能放下一个填充记录头；
+// 写入前预留 LOG_RECORD_MAX 的连续空间，参数直接编码进缓冲区
+#define LOG_ALIGN      16
+#define LOG_RECORD_MAX 4096
+
+// 单个字符串参数最多复制的字节数
+#define LOG_STR_MAX 1024
+
+// 日志线程每个输出目标的批量写缓冲区
+#define LOG_OUT_SIZE (64 * 1024)
+
+// 日志线程每处理这么多条记录归还一次缓冲区空间
+#define LOG_RELEASE_BATCH 64
+
+// 日志线程处理完一批记录后等待下一批的间隔（微秒），也是持续写日志时的最大输出延迟
+#define LOG_BATCH_WAIT_US 1000
+
+// 零填充整数（%03ld）快速路径支持的最大宽度
+#define LOG_PAD_MAX 20
+
+// 调用点状态
+enum {
+    SITE_NEW,
+    SITE_PARSING,
+    SITE_READY,
+    SITE_SYNC           // 格式串含不支持的转换（%n、%Lf 等）或参数过多，始终同步输出
+};
+
+// 参数类型：整数统一存为 8 字节，字符串存长度 + 内容
+enum {
+    ARG_INT,
+    ARG_UINT,
+    ARG_LONG,
+    ARG_ULONG,
+    ARG_LLONG,
+    ARG_ULLONG,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_PTR,
+    ARG_STR
+};
+
+#define PRECISION_NONE -1
+#define PRECISION_STAR -2
+
+// 格式串编译后的输出步骤：字面量、常见整数/字符串的快速路径，其余交给 snprintf
+enum {
+    OP_LITERAL,         // fmt[off, off + len)
+    OP_DEC,             // 没有标志、宽度、精度的 %d / %ld / %lld
+    OP_UDEC,            // 同上的 %u / %lu / %zu
+    OP_ZERO_PAD,        // %0Nd / %0Nu（如毫秒 %03ld）
+    OP_STR,             // 没有标志、宽度的 %s / %.Ns / %.*s（内容已按精度截断）
+    OP_SPEC             // 其他：specs[off] 开始的转换说明交给 snprintf
+};
+
+typedef struct log_op {
+    unsigned char kind;
+    unsigned char type;         // 参数类型
+    unsigned char nstars;       // 转换前的 * 参数个数
+    unsigned char width;        // OP_ZERO_PAD 的宽度
+    uint32_t off;
+    uint32_t len;
+} log_op_t;
+
+typedef struct log_program {
+    int count;
+    log_op_t *ops;
+    char *specs;                // OP_SPEC 的转换说明（各自以 '\0' 结尾）
+} log_program_t;
+
+// 记录头：site 为 NULL 时是回绕前的填充
+typedef struct log_record {
+    uint32_t size;              // 含记录头，LOG_ALIGN 对齐
+    uint32_t args_len;
+    const log_site_t *site;
+} log_record_t;
+
+// 一个线程的缓冲区：只有所属线程写入 tail，只有日志线程写入 head
+typedef struct log_ring {
+    struct log_ring *next;      // 全局链表（只增不减，日志线程停止时释放）
+    char *data;
+    size_t head_cache;          // 生产者看到的 head，空间不够时才重新读取
+    stat_counter_t records;     // 只由所属线程递增
+    stat_counter_t dropped;
+    atomic_size_t tail CACHE_ALIGNED;
+    atomic_size_t head CACHE_ALIGNED;
+} log_ring_t;
+
+// 日志线程的输出目标
+typedef struct log_out {
+    int fd;
+    int len;
+    char buf[LOG_OUT_SIZE];
+} log_out_t;
+
+atomic_int log_runtime_level = LOG_LEVEL_INFO;
+atomic_int log_access_on;
+
+static __thread log_ring_t *tls_ring;
+static _Atomic(log_ring_t*) rings;
+
+static pthread_t log_thread;
+static atomic_int running;
+static atomic_int stopping;
+
+// 日志线程没有记录可处理时阻塞；生产者发现它在睡眠时唤醒（只由一个生产者发出）
+static pthread_mutex_t wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake_cond = PTHREAD_COND_INITIALIZER;
+static atomic_int consumer_sleeping;
+
+static int access_fd = -1;
+static log_out_t out_stdout = { .fd = STDOUT_FILENO };
+static log_out_t out_stderr = { .fd = STDERR_FILENO };
+static log_out_t out_access = { .fd = -1 };
+
+static const char *level_prefix[] = { "[DEBUG] ", "[INFO] ", "[WARN] ", "[ERROR] ", "" };
+static const char *level_names[] = { "debug", "info", "warn", "error" };
+
+static int is_signed(int type) {
+    return type == ARG_INT || type == ARG_LONG || type == ARG_LLONG;
+}
+
+// 解析格式串：填充参数类型，并编译出日志线程使用的输出步骤
+static int site_parse(log_site_t *site) {
+    const char *fmt = site->fmt;
+    size_t fmt_len = strlen(fmt);
+    int max_ops = 2 * LOG_MAX_ARGS + 2;
+    
+    // 程序与调用点一样存活到进程退出，不释放
+    log_program_t *prog = malloc(sizeof(log_program_t) + max_ops * sizeof(log_op_t) + fmt_len + LOG_MAX_ARGS + 1);
+    if (!prog) return -1;
+    prog->ops = (log_op_t*)(prog + 1);
+    prog->specs = (char*)(prog->ops + max_ops);
+    prog->count = 0;
+    int specs_len = 0;
+    int n = 0;
+    
+    const char *p = fmt;
+    while (*p) {
+        const char *pct = strchr(p, '%');
+        if (pct != p) {
+            size_t len = pct ? (size_t)(pct - p) : strlen(p);
+            if (prog->count >= max_ops) goto unsupported;
+            prog->ops[prog->count++] = (log_op_t){ .kind = OP_LITERAL, .off = (uint32_t)(p - fmt), .len = (uint32_t)len };
+            p += len;
+            if (!pct) break;
+        }
+        if (prog->count >= max_ops - 1) goto unsupported;
+        
+        // 转换说明：%[标志][宽度][.精度][长度]转换符
+        const char *q = pct + 1;
+        if (*q == '%') {
+            prog->ops[prog->count++] = (log_op_t){ .kind = OP_LITERAL, .off = (uint32_t)(q - fmt), .len = 1 };
+            p = q + 1;
+            continue;
+        }
+        
+        int flags = 0, zero_only = 1, nstars = 0, width = -1, short_len = 0;
+        while (*q && strchr("-+ #0'", *q)) {
+            if (*q != '0') zero_only = 0;
+            flags++;
+            q++;
+        }
+        if (*q == '*') {
+            if (n == LOG_MAX_ARGS) goto unsupported;
+            site->types[n] = ARG_INT;
+            site->precision[n++] = PRECISION_NONE;
+            nstars++;
+            q++;
+        } else if (*q >= '0' && *q <= '9') {
+            width = 0;
+            while (*q >= '0' && *q <= '9') {
+                width = width * 10 + (*q - '0');
+                if (width > LOG_STR_MAX) goto unsupported;
+                q++;
+            }
+        }
+        
+        int precision = PRECISION_NONE;
+        if (*q == '.') {
+            q++;
+            if (*q == '*') {
+                if (n == LOG_MAX_ARGS) goto unsupported;
+                site->types[n] = ARG_INT;
+                site->precision[n++] = PRECISION_NONE;
+                nstars++;
+                precision = PRECISION_STAR;
+                q++;
+            } else {
+                precision = 0;
+                while (*q >= '0' && *q <= '9') {
+                    precision = precision * 10 + (*q - '0');
+                    if (precision > LOG_STR_MAX) {
+                        precision = LOG_STR_MAX;
+                    }
+                    q++;
+                }
+            }
+        }
+        
+        // 长度修饰：hh/h 按 int 传递，j 按 long long，t 按 long
+        int longs = 0, size = 0;
+        while (*q && strchr("hljzt", *q)) {
+            if (*q == 'l' || *q == 't') longs++;
+            if (*q == 'j') longs = 2;
+            if (*q == 'z') size = 1;
+            if (*q == 'h') short_len = 1;
+            q++;
+        }
+        
+        if (n == LOG_MAX_ARGS) goto unsupported;
+        int type;
+        switch (*q) {
+            case 'd': case 'i': case 'c':
+                type = size ? ARG_SIZE : longs == 0 ? ARG_INT : longs == 1 ? ARG_LONG : ARG_LLONG;
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                type = size ? ARG_SIZE : longs == 0 ? ARG_UINT : longs == 1 ? ARG_ULONG : ARG_ULLONG;
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                type = ARG_DOUBLE;
+                break;
+            case 's':
+                type = ARG_STR;
+                break;
+            case 'p':
+                type = ARG_PTR;
+                break;
+            default:
+                goto unsupported;
+        }
+        site->types[n] = (unsigned char)type;
+        site->precision[n++] = (short)(type == ARG_STR ? precision : PRECISION_NONE);
+        
+        // 选择输出步骤
+        char conv = *q++;
+        int decimal = (conv == 'd' || conv == 'i') ? is_signed(type) : conv == 'u';
+        int simple = flags == 0 && width < 0 && nstars == 0 && precision == PRECISION_NONE && !short_len;
+        log_op_t op = { .type = (unsigned char)type, .nstars = (unsigned char)nstars };
+        
+        if (type == ARG_STR && flags == 0 && width < 0 && nstars == (precision == PRECISION_STAR)) {
+            op.kind = OP_STR;
+        } else if (decimal && simple) {
+            op.kind = is_signed(type) ? OP_DEC : OP_UDEC;
+        } else if (decimal && flags > 0 && zero_only && width > 0 && width <= LOG_PAD_MAX &&
+                   nstars == 0 && precision == PRECISION_NONE && !short_len) {
+            op.kind = OP_ZERO_PAD;
+            op.width = (unsigned char)width;
+        } else {
+            op.kind = OP_SPEC;
+            op.off = (uint32_t)specs_len;
+            op.len = (uint32_t)(q - pct);
+            memcpy(prog->specs + specs_len, pct, op.len);
+            specs_len += (int)op.len;
+            prog->specs[specs_len++] = '\0';
+        }
+        prog->ops[prog->count++] = op;
+        p = q;
+    }
+    
+    site->nargs = n;
+    site->program = prog;
+    return 0;
+
+unsupported:
+    free(prog);
+    return -1;
+}
+
+static int site_prepare(log_site_t *site) {
+    int state = atomic_load_explicit(&site->state, memory_order_acquire);
+    if (state >= SITE_READY) return state;
+    
+    // 同一调用点第一次被多个线程同时调用时，未抢到解析权的线程本次同步输出
+    int expected = SITE_NEW;
+    if (!atomic_compare_exchange_strong(&site->state, &expected, SITE_PARSING)) return SITE_PARSING;
+    
+    state = site_parse(site) == 0 ? SITE_READY : SITE_SYNC;
+    atomic_store_explicit(&site->state, state, memory_order_release);
+    return state;
+}
+
+// 按类型复制参数，返回参数区长度
+static int encode_args(const log_site_t *site, va_list ap, char *out, int max) {
+    int pos = 0;
+    long last_int = -1;
+    
+    for (int i = 0; i < site->nargs; i++) {
+        int64_t v = 0;
+        
+        switch (site->types[i]) {
+            case ARG_INT:    v = va_arg(ap, int); last_int = (long)v; break;
+            case ARG_UINT:   v = va_arg(ap, unsigned int); break;
+            case ARG_LONG:   v = va_arg(ap, long); break;
+            case ARG_ULONG:  v = (int64_t)va_arg(ap, unsigned long); break;
+            case ARG_LLONG:  v = va_arg(ap, long long); break;
+            case ARG_ULLONG: v = (int64_t)va_arg(ap, unsigned long long); break;
+            case ARG_SIZE:   v = (int64_t)va_arg(ap, size_t); break;
+            case ARG_PTR:    v = (int64_t)(uintptr_t)va_arg(ap, void*); break;
+            case ARG_DOUBLE: {
+                double d = va_arg(ap, double);
+                memcpy(&v, &d, sizeof(d));
+                break;
+            }
+            case ARG_STR: {
+                const char *s = va_arg(ap, const char*);
+                if (!s) s = "(null)";
+                
+                long limit = site->precision[i];
+                if (limit == PRECISION_STAR) {
+                    limit = last_int;
+                }
+                if (limit < 0 || limit > LOG_STR_MAX) {
+                    limit = LOG_STR_MAX;
+                }
+                
+                // 长度 + 内容 + '\0'，按 8 字节对齐
+                uint32_t len = (uint32_t)strnlen(s, limit);
+                if (pos + 4 + (int)len + 1 > max) {
+                    len = max - pos - 5 > 0 ? (uint32_t)(max - pos - 5) : 0;
+                }
+                memcpy(out + pos, &len, 4);
+                memcpy(out + pos + 4, s, len);
+                out[pos + 4 + len] = '\0';
+                pos += (4 + (int)len + 1 + 7) & ~7;
+                continue;
+            }
+        }
+        
+        if (pos + 8 > max) break;
+        memcpy(out + pos, &v, 8);
+        pos += 8;
+    }
+    
+    return pos;
+}
+
+static log_ring_t* ring_get(void) {
+    if (tls_ring) return tls_ring;
+    
+    log_ring_t *ring = cache_aligned_calloc(1, sizeof(log_ring_t));
+    if (!ring) return NULL;
+    ring->data = malloc(LOG_RING_SIZE);
+    if (!ring->data) {
+        free(ring);
+        return NULL;
+    }
+    
+    // 由所属线程预先触碰全部页面，缺页不落在之后的日志调用上
+    memset(ring->data, 0, LOG_RING_SIZE);
+    
+    ring->next = atomic_load_explicit(&rings, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&rings, &ring->next, ring,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+    tls_ring = ring;
+    return ring;
+}
+
+// 尾部到缓冲区末尾不足一条最大记录时，这段空间用一个填充记录跳过
+static inline size_t ring_pad(size_t tail) {
+    size_t left = LOG_RING_SIZE - (tail & LOG_RING_MASK);
+    return left < LOG_RECORD_MAX ? left : 0;
+}
+
+// 预留 LOG_RECORD_MAX 的连续空间，返回写入位置，满时返回 NULL
+static char* ring_reserve(log_ring_t *ring, size_t tail) {
+    size_t pad = ring_pad(tail);
+    
+    if (tail + pad + LOG_RECORD_MAX - ring->head_cache > LOG_RING_SIZE) {
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail + pad + LOG_RECORD_MAX - ring->head_cache > LOG_RING_SIZE) return NULL;
+    }
+    
+    if (pad) {
+        log_record_t *filler = (log_record_t*)(ring->data + (tail & LOG_RING_MASK));
+        filler->size = (uint32_t)pad;
+        filler->site = NULL;
+    }
+    return ring->data + ((tail + pad) & LOG_RING_MASK);
+}
+
+// 提交记录并在日志线程睡眠时唤醒它：发布 tail 与读取 sleeping 都是 seq_cst，
+// 与日志线程的 sleeping = 1 / 检查 tail 配对，要么它看到新记录，要么这里看到它在睡眠
+static void ring_publish(log_ring_t *ring, size_t tail) {
+    atomic_exchange(&ring->tail, tail);
+    if (atomic_load(&consumer_sleeping) && atomic_exchange(&consumer_sleeping, 0)) {
+        pthread_mutex_lock(&wake_lock);
+        pthread_cond_signal(&wake_cond);
+        pthread_mutex_unlock(&wake_lock);
+    }
+}
+
+// 同步输出（日志线程未运行、调用点不支持二进制编码时）
+static void log_sync(const log_site_t *site, const char *fmt, va_list ap) {
+    if (site->level == LOG_LEVEL_ACCESS) {
+        char line[LOG_RECORD_MAX];
+        int n = vsnprintf(line, sizeof(line) - 1, fmt, ap);
+        if (access_fd >= 0 && n >= 0) {
+            n = n < (int)sizeof(line) - 1 ? n : (int)sizeof(line) - 2;
+            line[n++] = '\n';
+            ssize_t ret = write(access_fd, line, n);
+            (void)ret;
+        }
+        return;
+    }
+    
+    FILE *stream = site->level >= LOG_LEVEL_WARN ? stderr : stdout;
+    flockfile(stream);
+    fputs(level_prefix[site->level], stream);
+    vfprintf(stream, fmt, ap);
+    fputc('\n', stream);
+    funlockfile(stream);
+}
+
+void log_write(log_site_t *site, const char *fmt, ...) {
+    va_list ap;
+    log_ring_t *ring = NULL;
+    
+    if (site_prepare(site) != SITE_READY || !atomic_load_explicit(&running, memory_order_acquire) ||
+        !(ring = ring_get())) {
+        va_start(ap, fmt);
+        log_sync(site, fmt, ap);
+        va_end(ap);
+        return;
+    }
+    
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    char *slot = ring_reserve(ring, tail);
+    if (!slot) {
+        stat_add(&ring->dropped, 1);
+        return;
+    }
+    
+    log_record_t *rec = (log_record_t*)slot;
+    va_start(ap, fmt);
+    int len = encode_args(site, ap, slot + sizeof(log_record_t), LOG_RECORD_MAX - sizeof(log_record_t));
+    va_end(ap);
+    
+    rec->args_len = (uint32_t)len;
+    rec->size = (uint32_t)((sizeof(log_record_t) + len + LOG_ALIGN - 1) & ~(LOG_ALIGN - 1));
+    rec->site = site;
+    stat_add(&ring->records, 1);
+    ring_publish(ring, tail + ring_pad(tail) + rec->size);
+}
+
+// ---- 日志线程：格式化与输出 ----
+
+static void out_flush(log_out_t *out) {
+    int off = 0;
+    while (off < out->len && out->fd >= 0) {
+        ssize_t n = write(out->fd, out->buf + off, out->len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        off += (int)n;
+    }
+    out->len = 0;
+}
+
+// 保证 out 至少有 n 字节空闲（n 不超过 LOG_OUT_SIZE）
+static inline char* out_reserve(log_out_t *out, int n) {
+    if (LOG_OUT_SIZE - out->len < n) {
+        out_flush(out);
+    }
+    return out->buf + out->len;
+}
+
+static void out_append(log_out_t *out, const char *data, int len) {
+    if (len <= LOG_OUT_SIZE - out->len) {
+        memcpy(out->buf + out->len, data, len);
+        out->len += len;
+        return;
+    }
+    
+    while (len > 0) {
+        if (out->len == LOG_OUT_SIZE) {
+            out_flush(out);
+        }
+        int n = LOG_OUT_SIZE - out->len < len ? LOG_OUT_SIZE - out->len : len;
+        memcpy(out->buf + out->len, data, n);
+        out->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+// 十进制整数，width > 0 时补零到 width 位（负号计入宽度，与 printf 一致）
+static void out_decimal(log_out_t *out, uint64_t v, int negative, int width) {
+    char digits[24];
+    int n = 0;
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    
+    char *dst = out_reserve(out, LOG_PAD_MAX + 24);
+    int len = 0;
+    if (negative) {
+        dst[len++] = '-';
+    }
+    for (int pad = width - n - negative; pad > 0; pad--) {
+        dst[len++] = '0';
+    }
+    memcpy(dst + len, digits + sizeof(digits) - n, n);
+    out->len += len + n;
+}
+
+// 访问日志的字符串参数按 JSON 字符串转义（引号、反斜杠、控制字符）
+static void out_json_string(log_out_t *out, const char *s, uint32_t len) {
+    static const char hex[] = "0123456789abcdef";
+    uint32_t run = 0;
+    
+    for (uint32_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        
+        out_append(out, s + run, (int)(i - run));
+        char *dst = out_reserve(out, 6);
+        if (c == '"' || c == '\\') {
+            dst[0] = '\\';
+            dst[1] = (char)c;
+            out->len += 2;
+        } else {
+            memcpy(dst, "\\u00", 4);
+            dst[4] = hex[c >> 4];
+            dst[5] = hex[c & 15];
+            out->len += 6;
+        }
+        run = i + 1;
+    }
+    out_append(out, s + run, (int)(len - run));
+}
+
+// 用单个转换说明格式化一个参数（stars 为前面 * 给出的宽度/精度）
+static void out_spec(log_out_t *out, const char *spec, int nstars, const int *stars,
+                     int type, int64_t v, const char *str) {
+    char tmp[LOG_STR_MAX + 64];
+    int n;
+
+#define FORMAT_ARG(value) \
+    (nstars == 0 ? snprintf(tmp, sizeof(tmp), spec, value) : \
+     nstars == 1 ? snprintf(tmp, sizeof(tmp), spec, stars[0], value) : \
+                   snprintf(tmp, sizeof(tmp), spec, stars[0], stars[1], value))
+    
+    switch (type) {
+        case ARG_INT:    n = FORMAT_ARG((int)v); break;
+        case ARG_UINT:   n = FORMAT_ARG((unsigned int)v); break;
+        case ARG_LONG:   n = FORMAT_ARG((long)v); break;
+        case ARG_ULONG:  n = FORMAT_ARG((unsigned long)v); break;
+        case ARG_LLONG:  n = FORMAT_ARG((long long)v); break;
+        case ARG_ULLONG: n = FORMAT_ARG((unsigned long long)v); break;
+        case ARG_SIZE:   n = FORMAT_ARG((size_t)v); break;
+        case ARG_PTR:    n = FORMAT_ARG((void*)(uintptr_t)v); break;
+        case ARG_STR:    n = FORMAT_ARG(str); break;
+        case ARG_DOUBLE: {
+            double d;
+            memcpy(&d, &v, sizeof(d));
+            n = FORMAT_ARG(d);
+            break;
+        }
+        default:
+            return;
+    }
+#undef FORMAT_ARG
+    
+    if (n > 0) {
+        out_append(out, tmp, n < (int)sizeof(tmp) ? n : (int)sizeof(tmp) - 1);
+    }
+}
+
+static void format_record(const log_record_t *rec) {
+    const log_site_t *site = rec->site;
+    const log_program_t *prog = site->program;
+    const char *args = (const char*)(rec + 1);
+    const char *args_end = args + rec->args_len;
+    int access = site->level == LOG_LEVEL_ACCESS;
+    log_out_t *out = access ? &out_access : site->level >= LOG_LEVEL_WARN ? &out_stderr : &out_stdout;
+    
+    if (out->fd < 0) return;
+    
+    const char *prefix = level_prefix[site->level];
+    if (*prefix) {
+        out_append(out, prefix, (int)strlen(prefix));
+    }
+    
+    for (int i = 0; i < prog->count; i++) {
+        const log_op_t *op = &prog->ops[i];
+        if (op->kind == OP_LITERAL) {
+            out_append(out, site->fmt + op->off, (int)op->len);
+            continue;
+        }
+        
+        // 参数按编码顺序读取：先是 * 给出的宽度/精度，再是转换本身的参数
+        int stars[2] = { 0, 0 };
+        for (int s = 0; s < op->nstars && args + 8 <= args_end; s++) {
+            int64_t star;
+            memcpy(&star, args, 8);
+            args += 8;
+            stars[s] = (int)star;
+        }
+        if (args >= args_end) break;
+        
+        if (op->type == ARG_STR) {
+            uint32_t len;
+            memcpy(&len, args, 4);
+            const char *str = args + 4;
+            args += (4 + len + 1 + 7) & ~7;
+            
+            // 访问日志只转义不带宽度的 %s（带宽度的按 printf 原样输出）
+            if (op->kind == OP_STR && access) {
+                out_json_string(out, str, len);
+            } else if (op->kind == OP_STR) {
+                out_append(out, str, (int)len);
+            } else {
+                out_spec(out, prog->specs + op->off, op->nstars, stars, op->type, 0, str);
+            }
+            continue;
+        }
+        
+        int64_t v;
+        memcpy(&v, args, 8);
+        args += 8;
+        
+        switch (op->kind) {
+            case OP_DEC:
+                out_decimal(out, v < 0 ? 0 - (uint64_t)v : (uint64_t)v, v < 0, 0);
+                break;
+            case OP_UDEC:
+                out_decimal(out, (uint64_t)v, 0, 0);
+                break;
+            case OP_ZERO_PAD:
+                if (is_signed(op->type)) {
+                    out_decimal(out, v < 0 ? 0 - (uint64_t)v : (uint64_t)v, v < 0, op->width);
+                } else {
+                    out_decimal(out, (uint64_t)v, 0, op->width);
+                }
+                break;
+            default:
+                out_spec(out, prog->specs + op->off, op->nstars, stars, op->type, v, NULL);
+                break;
+        }
+    }
+    
+    *out_reserve(out, 1) = '\n';
+    out->len++;
+}
+
+// 处理一个缓冲区中已提交的记录，返回处理条数
+static long drain_ring(log_ring_t *ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    long count = 0;
+    
+    while (head != tail) {
+        const log_record_t *rec = (const log_record_t*)(ring->data + (head & LOG_RING_MASK));
+        if (rec->site) {
+            format_record(rec);
+            count++;
+        }
+        head += rec->size;
+        
+        if (count % LOG_RELEASE_BATCH == 0) {
+            atomic_store_explicit(&ring->head, head, memory_order_release);
+        }
+    }
+    atomic_store_explicit(&ring->head, head, memory_order_release);
+    return count;
+}
+
+static int rings_pending(void) {
+    for (log_ring_t *ring = atomic_load_explicit(&rings, memory_order_acquire); ring; ring = ring->next) {
+        if (atomic_load(&ring->tail) != atomic_load_explicit(&ring->head, memory_order_relaxed)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void* log_thread_run(void *arg) {
+    (void)arg;
+    
+    int idle = 0;
+    while (1) {
+        long count = 0;
+        for (log_ring_t *ring = atomic_load_explicit(&rings, memory_order_acquire); ring; ring = ring->next) {
+            count += drain_ring(ring);
+        }
+        if (count > 0) {
+            idle = 0;
+            continue;
+        }
+        
+        out_flush(&out_stdout);
+        out_flush(&out_stderr);
+        out_flush(&out_access);
+        
+        if (atomic_load(&stopping)) break;
+        
+        // 刚处理过记录时先睡一个批量间隔（不登记睡眠，生产者不会发唤醒），
+        // 持续有日志时每个间隔批量处理一次，生产者不必每条都唤醒日志线程
+        if (!idle) {
+            idle = 1;
+            struct timespec ts = { 0, LOG_BATCH_WAIT_US * 1000L };
+            nanosleep(&ts, NULL);
+            continue;
+        }
+        
+        // 一个间隔内没有新记录：阻塞直到生产者唤醒
+        pthread_mutex_lock(&wake_lock);
+        atomic_store(&consumer_sleeping, 1);
+        if (!rings_pending() && !atomic_load(&stopping)) {
+            pthread_cond_wait(&wake_cond, &wake_lock);
+        }
+        atomic_store(&consumer_sleeping, 0);
+        pthread_mutex_unlock(&wake_lock);
+    }
+    
+    return NULL;
+}
+
+int log_init(void) {
+    if (atomic_load(&running)) return 0;
+    
+    // 之前经 stdio 缓冲的输出先写出，保持先后顺序
+    fflush(stdout);
+    fflush(stderr);
+    
+    atomic_store(&stopping, 0);
+    if (pthread_create(&log_thread, NULL, log_thread_run, NULL) != 0) return -1;
+    atomic_store_explicit(&running, 1, memory_order_release);
+    return 0;
+}
+
+void log_shutdown(void) {
+    if (atomic_load(&running)) {
+        atomic_store(&running, 0);
+        atomic_store(&stopping, 1);
+        
+        pthread_mutex_lock(&wake_lock);
+        pthread_cond_signal(&wake_cond);
+        pthread_mutex_unlock(&wake_lock);
+        pthread_join(log_thread, NULL);
+    }
+    
+    log_ring_t *ring = atomic_exchange(&rings, NULL);
+    while (ring) {
+        log_ring_t *next = ring->next;
+        free(ring->data);
+        free(ring);
+        ring = next;
+    }
+    tls_ring = NULL;
+    
+    atomic_store(&log_access_on, 0);
+    if (access_fd >= 0) {
+        close(access_fd);
+        access_fd = out_access.fd = -1;
+    }
+}
+
+void log_set_level(log_level_t level) {
+    atomic_store_explicit(&log_runtime_level, level, memory_order_relaxed);
+}
+
+int log_level_parse(const char *name, log_level_t *level) {
+    for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_ERROR; i++) {
+        if (strcmp(name, level_names[i]) == 0) {
+            *level = (log_level_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int log_open_access(const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        log_error("Failed to open access log %s: %s", path, strerror(errno));
+        return -1;
+    }
+    
+    access_fd = out_access.fd = fd;
+    atomic_store(&log_access_on, 1);
+    return 0;
+}
+
+void log_get_stats(long *records, long *dropped) {
+    *records = *dropped = 0;
+    for (log_ring_t *ring = atomic_load_explicit(&rings, memory_order_acquire); ring; ring = ring->next) {
+        *records += stat_read(&ring->records);
+        *dropped += stat_read(&ring->dropped);
+    }
+}
+
+void log_collect_metrics(void *arg, struct metrics_out *out) {
+    (void)arg;
+    
+    long records, dropped;
+    log_get_stats(&records, &dropped);
+    
+    metrics_printf(out, "# HELP reactor_log_records_total Log and access log records queued to the log thread\n"
+                   "# TYPE reactor_log_records_total counter\n"
+                   "reactor_log_records_total %ld\n", records);
+    metrics_printf(out, "# HELP reactor_log_dropped_total Log records dropped because a thread's ring was full\n"
+                   "# TYPE reactor_log_dropped_total counter\n"
+                   "reactor_log_dropped_total %ld\n", dropped);
+}
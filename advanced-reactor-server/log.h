@@ -0,0 +1,109 @@
+// log.h
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// 异步日志
+//
+// 调用线程只把参数按二进制复制进自己的环形缓冲区（单生产者单消费者，无锁），
+// 不格式化、不加锁，除了唤醒空闲的日志线程之外不做系统调用；后台日志线程轮流取出
+// 各线程的记录，格式化后批量 write。每个调用点有一个静态的 log_site_t，第一次调用时
+// 解析格式串得到参数类型，之后只按类型复制参数（%s 复制字符串内容，受精度限制）；
+// 格式串同时被编译成字面量和转换步骤，日志线程不再逐字符解析。
+// 缓冲区满时丢弃记录并计数，调用线程从不等待。不同线程的记录之间不保证先后顺序。
+//
+// 日志线程处理完一批记录后先睡 1ms 再取下一批，持续写日志时调用线程不需要唤醒它；
+// 一个间隔内没有新记录才阻塞，由下一条日志唤醒（空闲时不占 CPU）。
+//
+// 级别低于 LOG_COMPILE_LEVEL 的调用在编译期删除（默认删除 debug，
+// 编译时加 -DLOG_COMPILE_LEVEL=0 保留），运行时级别由 log_set_level 设置。
+// 日志线程未启动时（或已停止后）退回同步输出。
+//
+// 访问日志（access_log）走同一套缓冲区，写到 log_open_access 打开的文件，
+// 不带宽度的 %s 参数按 JSON 字符串转义。
+
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_ACCESS        // 访问日志，不受运行时级别限制
+} log_level_t;
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+// 单条日志的最多参数个数（含 * 宽度/精度），超过时该调用点退回同步输出
+#define LOG_MAX_ARGS 24
+
+// 调用点：格式串和解析出的参数类型（首次调用时填充）
+typedef struct log_site {
+    const char *fmt;
+    int level;
+    atomic_int state;
+    int nargs;
+    unsigned char types[LOG_MAX_ARGS];
+    short precision[LOG_MAX_ARGS];  // %s 的精度：-1 没有，-2 由前一个 * 参数给出
+    void *program;                  // 编译后的格式串（日志线程按它输出）
+} log_site_t;
+
+extern atomic_int log_runtime_level;
+extern atomic_int log_access_on;
+
+// 由日志宏调用：fmt 与 site->fmt 相同，只用于编译期检查参数和同步输出
+void log_write(log_site_t *site, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// 该级别的日志是否会输出（准备参数本身有开销时先检查）
+#define log_enabled(lvl) \
+    ((lvl) >= LOG_COMPILE_LEVEL && \
+     (lvl) >= atomic_load_explicit(&log_runtime_level, memory_order_relaxed))
+
+#define LOG_AT(lvl, format, ...) \
+    do { \
+        if (log_enabled(lvl)) { \
+            static log_site_t log_site_ = { .fmt = format, .level = (lvl) }; \
+            log_write(&log_site_, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define log_debug(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define log_info(fmt, ...)  LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define log_warn(fmt, ...)  LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define log_error(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+static inline int log_access_enabled(void) {
+    return atomic_load_explicit(&log_access_on, memory_order_relaxed);
+}
+
+#define access_log(fmt, ...) \
+    do { \
+        if (log_access_enabled()) { \
+            LOG_AT(LOG_LEVEL_ACCESS, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+// 启动日志线程（之前的 stdout 输出先 fflush），成功返回 0
+int log_init(void);
+
+// 写完所有已提交的记录后停止日志线程并关闭访问日志，之后的调用同步输出
+void log_shutdown(void);
+
+void log_set_level(log_level_t level);
+
+// 解析级别名（debug、info、warn、error），成功返回 0
+int log_level_parse(const char *name, log_level_t *level);
+
+// 打开访问日志文件（追加写），在 log_init 之前或之后调用均可，成功返回 0
+int log_open_access(const char *path);
+
+// 所有线程累计提交和丢弃的记录数
+void log_get_stats(long *records, long *dropped);
+
+// /metrics 收集函数：提交和丢弃的记录数
+struct metrics_out;
+void log_collect_metrics(void *arg, struct metrics_out *out);
+
+#endif // LOG_H
@@ -1,8 +1,32 @@
 // main.c
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <getopt.h>
 #include "server.h"
+#include "event_loop.h"
+
+// 只有长选项的参数
+enum {
+    OPT_IO_CPUS = 256,
+    OPT_WORKER_CPUS,
+    OPT_BUSY_POLL,
+    OPT_NO_DIRECT_WRITE,
+    OPT_STATIC_COPY,
+    OPT_CACHE_MB,
+    OPT_CACHE_TTL,
+    OPT_CACHE_VARY,
+    OPT_LOG_LEVEL,
+    OPT_ACCESS_LOG,
+    OPT_COMPLETION
+};
+
+// 自旋时间上限（微秒），再长的自旋不如直接阻塞
+#define MAX_BUSY_POLL_US 10000
+
+// 响应缓存上限（MB）和默认 TTL 上限（秒）
+#define MAX_CACHE_MB      (64 * 1024)
+#define MAX_CACHE_TTL_SEC (7 * 24 * 3600)
 
 static void print_usage(const char *prog) {
     printf("Usage: %s [options]\n", prog);
@@ -10,6 +34,32 @@ static void print_usage(const char *prog) {
     printf("  -p, --port PORT          Server port (default: 8080)\n");
     printf("  -i, --io-threads NUM     Number of IO threads (default: 4)\n");
     printf("  -w, --worker-threads NUM Number of worker threads (default: 8)\n");
+    printf("  -e, --event-backend NAME Event loop backend: epoll, io_uring, kqueue\n");
+    printf("                           (default: epoll on Linux, kqueue on macOS)\n");
+    printf("      --completion         io_uring only: multishot accept and recv into a provided\n");
+    printf("                           buffer ring instead of readiness polling\n");
+    printf("  -r, --reuseport          One SO_REUSEPORT listen socket per IO thread\n");
+    printf("  -q, --task-queue KIND    Worker task queue: mutex (default), lockfree\n");
+    printf("  -c, --conn-prealloc NUM  Connections preallocated per IO thread (default: 256)\n");
+    printf("  -R, --run-to-completion  Run non-blocking handlers inline on the IO thread\n");
+    printf("  -t, --idle-timeout SEC   Close keep-alive connections idle for SEC seconds (default: 60)\n");
+    printf("  -H, --header-timeout SEC Limit for receiving request headers (default: 10)\n");
+    printf("  -W, --write-timeout SEC  Close connections whose output makes no progress (default: 30)\n");
+    printf("                           (0 disables a timeout)\n");
+    printf("  -d, --dispatch POLICY    Connection dispatch to IO threads: rr (default), least, p2c\n");
+    printf("  -a, --affinity           Pin IO threads and workers by CPU topology from /sys\n");
+    printf("      --io-cpus LIST       Pin IO thread i to the i-th CPU of LIST (e.g. 0-3,8)\n");
+    printf("      --worker-cpus LIST   Pin worker i to the i-th CPU of LIST\n");
+    printf("      --busy-poll USEC     Busy poll up to USEC microseconds before blocking (default: 0)\n");
+    printf("      --no-direct-write    Always hand worker responses to the IO thread\n");
+    printf("  -s, --static-root DIR    Serve files under DIR at /static/\n");
+    printf("      --static-copy        Read static file bodies into buffers instead of sendfile\n");
+    printf("      --cache-mb MB        Cache responses of cacheable handlers in up to MB megabytes\n");
+    printf("                           (default: 0, disabled)\n");
+    printf("      --cache-ttl SEC      Response cache TTL without Cache-Control max-age (default: 10)\n");
+    printf("      --cache-vary LIST    Request headers added to the cache key (default: Accept-Encoding)\n");
+    printf("      --log-level LEVEL    Minimum log level: debug, info (default), warn, error\n");
+    printf("      --access-log PATH    Append one JSON line per request to PATH\n");
     printf("  -h, --help               Show this help message\n");
 }
 
@@ -17,18 +67,60 @@ int main(int argc, char *argv[]) {
     int port = 8080;
     int io_threads = 12;  // 基于测试结果的最优配置
     int worker_threads = 24;
+    int reuseport = 0;
+    int completion = 0;
+    task_queue_kind_t queue_kind = TASK_QUEUE_MUTEX;
+    int conn_prealloc = 256;
+    int run_to_completion = 0;
+    int idle_timeout = 60;
+    int header_timeout = 10;
+    int write_timeout = 30;
+    io_dispatch_t dispatch = IO_DISPATCH_ROUND_ROBIN;
+    int busy_poll = 0;
+    int direct_write = 1;
+    const char *static_root = NULL;
+    static_send_mode_t static_mode = STATIC_SEND_SENDFILE;
+    int cache_mb = 0;
+    int cache_ttl = 10;
+    const char *cache_vary = "Accept-Encoding";
+    const char *log_level = "info";
+    const char *access_log_path = NULL;
+    affinity_config_t affinity;
+    memset(&affinity, 0, sizeof(affinity));
     
     // 解析命令行参数
     static struct option long_options[] = {
         {"port", required_argument, 0, 'p'},
         {"io-threads", required_argument, 0, 'i'},
         {"worker-threads", required_argument, 0, 'w'},
+        {"event-backend", required_argument, 0, 'e'},
+        {"reuseport", no_argument, 0, 'r'},
+        {"task-queue", required_argument, 0, 'q'},
+        {"conn-prealloc", required_argument, 0, 'c'},
+        {"run-to-completion", no_argument, 0, 'R'},
+        {"idle-timeout", required_argument, 0, 't'},
+        {"header-timeout", required_argument, 0, 'H'},
+        {"write-timeout", required_argument, 0, 'W'},
+        {"dispatch", required_argument, 0, 'd'},
+        {"affinity", no_argument, 0, 'a'},
+        {"io-cpus", required_argument, 0, OPT_IO_CPUS},
+        {"worker-cpus", required_argument, 0, OPT_WORKER_CPUS},
+        {"busy-poll", required_argument, 0, OPT_BUSY_POLL},
+        {"no-direct-write", no_argument, 0, OPT_NO_DIRECT_WRITE},
+        {"static-root", required_argument, 0, 's'},
+        {"static-copy", no_argument, 0, OPT_STATIC_COPY},
+        {"cache-mb", required_argument, 0, OPT_CACHE_MB},
+        {"cache-ttl", required_argument, 0, OPT_CACHE_TTL},
+        {"cache-vary", required_argument, 0, OPT_CACHE_VARY},
+        {"log-level", required_argument, 0, OPT_LOG_LEVEL},
+        {"access-log", required_argument, 0, OPT_ACCESS_LOG},
+        {"completion", no_argument, 0, OPT_COMPLETION},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
     
     int opt;
-    while ((opt = getopt_long(argc, argv, "p:i:w:h", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "p:i:w:e:rq:c:Rt:H:W:d:as:h", long_options, NULL)) != -1) {
         switch (opt) {
             case 'p':
                 port = atoi(optarg);
@@ -47,6 +139,114 @@ int main(int argc, char *argv[]) {
                     exit(EXIT_FAILURE);
                 }
                 break;
+            case 'e':
+                if (event_loop_set_backend(optarg) != 0) {
+                    fprintf(stderr, "Event backend not available: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'r':
+                reuseport = 1;
+                break;
+            case 'q':
+                if (task_queue_kind_parse(optarg, &queue_kind) != 0) {
+                    fprintf(stderr, "Invalid task queue: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'c':
+                conn_prealloc = atoi(optarg);
+                if (conn_prealloc < 0) {
+                    fprintf(stderr, "Invalid connection prealloc count: %d\n", conn_prealloc);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'R':
+                run_to_completion = 1;
+                break;
+            case 't':
+            case 'H':
+            case 'W': {
+                int seconds = atoi(optarg);
+                if (seconds < 0) {
+                    fprintf(stderr, "Invalid timeout: %d\n", seconds);
+                    exit(EXIT_FAILURE);
+                }
+                if (opt == 't') {
+                    idle_timeout = seconds;
+                } else if (opt == 'H') {
+                    header_timeout = seconds;
+                } else {
+                    write_timeout = seconds;
+                }
+                break;
+            }
+            case 'd':
+                if (io_dispatch_parse(optarg, &dispatch) != 0) {
+                    fprintf(stderr, "Invalid dispatch policy: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'a':
+                affinity.enabled = 1;
+                break;
+            case OPT_IO_CPUS:
+            case OPT_WORKER_CPUS:
+                if (cpu_list_parse(optarg, opt == OPT_IO_CPUS ? &affinity.io_cpus
+                                                              : &affinity.worker_cpus) != 0) {
+                    fprintf(stderr, "Invalid CPU list: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_BUSY_POLL:
+                busy_poll = atoi(optarg);
+                if (busy_poll < 0 || busy_poll > MAX_BUSY_POLL_US) {
+                    fprintf(stderr, "Invalid busy poll time: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_NO_DIRECT_WRITE:
+                direct_write = 0;
+                break;
+            case 's':
+                static_root = optarg;
+                break;
+            case OPT_STATIC_COPY:
+                static_mode = STATIC_SEND_COPY;
+                break;
+            case OPT_CACHE_MB:
+                cache_mb = atoi(optarg);
+                if (cache_mb < 0 || cache_mb > MAX_CACHE_MB) {
+                    fprintf(stderr, "Invalid response cache size: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_CACHE_TTL:
+                cache_ttl = atoi(optarg);
+                if (cache_ttl < 0 || cache_ttl > MAX_CACHE_TTL_SEC) {
+                    fprintf(stderr, "Invalid response cache TTL: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_CACHE_VARY:
+                cache_vary = optarg;
+                break;
+            case OPT_LOG_LEVEL: {
+                log_level_t level;
+                if (log_level_parse(optarg, &level) != 0) {
+                    fprintf(stderr, "Invalid log level: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                log_set_level(level);
+                log_level = optarg;
+                break;
+            }
+            case OPT_ACCESS_LOG:
+                access_log_path = optarg;
+                break;
+            case OPT_COMPLETION:
+                completion = 1;
+                break;
             case 'h':
                 print_usage(argv[0]);
                 exit(EXIT_SUCCESS);
@@ -56,16 +256,85 @@ int main(int argc, char *argv[]) {
         }
     }
     
+    // -e 可以出现在 --completion 之后，解析完再检查后端是否支持
+    if (completion && event_loop_set_completions(1) != 0) {
+        fprintf(stderr, "--completion requires -e io_uring with provided buffer rings (Linux 6.0+)\n");
+        exit(EXIT_FAILURE);
+    }
+    
     printf("========================================\n");
     printf("Reactor Server Configuration:\n");
     printf("  Port: %d\n", port);
     printf("  IO Threads: %d\n", io_threads);
     printf("  Worker Threads: %d\n", worker_threads);
+    printf("  Event Backend: %s (%s)\n", event_loop_backend_name(),
+           completion ? "completion: multishot accept/recv" : "readiness");
+    printf("  Acceptor: %s\n", reuseport ? "per IO thread (SO_REUSEPORT)" : "main thread");
+    if (!reuseport) {
+        printf("  Dispatch: %s\n", io_dispatch_name(dispatch));
+    }
+    printf("  Task Queue: %s\n", task_queue_kind_name(queue_kind));
+    printf("  Conn Prealloc: %d per IO thread\n", conn_prealloc);
+    printf("  Execution: %s\n", run_to_completion ? "run-to-completion (blocking handlers on workers)"
+                                                   : "worker pool");
+    printf("  Worker Responses: %s\n", direct_write ? "direct write" : "via IO thread");
+    if (static_root) {
+        printf("  Static Files: %s (%s)\n", static_root,
+               static_mode == STATIC_SEND_COPY ? "copy" : "sendfile");
+    }
+    if (cache_mb > 0) {
+        printf("  Response Cache: %dMB, TTL %ds, vary \"%s\"\n", cache_mb, cache_ttl, cache_vary);
+    }
+    printf("  Timeouts: idle %ds, header %ds, write %ds\n",
+           idle_timeout, header_timeout, write_timeout);
+    if (busy_poll > 0) {
+        printf("  Busy Poll: up to %dus before blocking\n", busy_poll);
+    }
+    if (affinity.enabled || cpu_mask_count(&affinity.io_cpus) || cpu_mask_count(&affinity.worker_cpus)) {
+        char io_cpus[128], worker_cpus[128];
+        cpu_mask_format(&affinity.io_cpus, io_cpus, sizeof(io_cpus));
+        cpu_mask_format(&affinity.worker_cpus, worker_cpus, sizeof(worker_cpus));
+        printf("  CPU Affinity: IO %s, workers %s\n", io_cpus[0] ? io_cpus : "auto",
+               worker_cpus[0] ? worker_cpus : "auto");
+    }
+    printf("  Logging: level %s, access log %s\n", log_level, access_log_path ? access_log_path : "off");
     printf("========================================\n\n");
     
+    if (access_log_path && log_open_access(access_log_path) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    
+    // 之后的日志由后台线程输出
+    if (log_init() != 0) {
+        fprintf(stderr, "Failed to start log thread, logging synchronously\n");
+    }
+    
     // 创建并启动服务器
-    reactor_server_t *server = server_create(port, io_threads, worker_threads);
+    server_config_t config;
+    server_config_init(&config);
+    config.port = port;
+    config.io_threads = io_threads;
+    config.worker_threads = worker_threads;
+    config.reuseport = reuseport;
+    config.queue_kind = queue_kind;
+    config.conn_prealloc = conn_prealloc;
+    config.run_to_completion = run_to_completion;
+    config.idle_timeout_ms = idle_timeout * 1000;
+    config.header_timeout_ms = header_timeout * 1000;
+    config.write_timeout_ms = write_timeout * 1000;
+    config.dispatch = dispatch;
+    config.busy_poll_us = busy_poll;
+    config.direct_write = direct_write;
+    config.static_root = static_root;
+    config.static_mode = static_mode;
+    config.cache.max_bytes = (size_t)cache_mb << 20;
+    config.cache.default_ttl_ms = cache_ttl * 1000;
+    config.cache.vary = cache_vary;
+    config.affinity = affinity;
+    
+    reactor_server_t *server = server_create(&config);
     if (!server) {
+        log_shutdown();
         fprintf(stderr, "Failed to create server\n");
         exit(EXIT_FAILURE);
     }
@@ -75,6 +344,7 @@ int main(int argc, char *argv[]) {
     
     // 清理
     server_destroy(server);
+    log_shutdown();
     
     return ret;
 }
\ No newline at end of file
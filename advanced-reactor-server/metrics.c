@@ -0,0 +1,241 @@
+// metrics.c
+#include "metrics.h"
+
+// 导出的直方图桶边界：2^10 ns (约 1 us) 到 2^34 ns (约 17 s)，每个 2 的幂一个
+#define EXPORT_MIN_SHIFT 10
+#define EXPORT_MAX_SHIFT 34
+
+// 一个线程的全部直方图（独占缓存行，只由该线程写入）
+typedef struct metrics_thread {
+    histogram_t hist[METRIC_HIST_COUNT];
+} CACHE_ALIGNED metrics_thread_t;
+
+// 已登记的线程；线程退出后其直方图保留，累计值不会倒退
+static _Atomic(metrics_thread_t*) threads[METRICS_MAX_THREADS];
+static atomic_int thread_count;
+static __thread metrics_thread_t *tls_metrics;
+static __thread int tls_metrics_unavailable;
+
+typedef struct collector {
+    metrics_collector_fn fn;
+    void *arg;
+} collector_t;
+
+static collector_t collectors[METRICS_MAX_COLLECTORS];
+static int collector_count;
+
+static const struct {
+    const char *name;
+    const char *help;
+} hist_info[METRIC_HIST_COUNT] = {
+    [METRIC_QUEUE_WAIT] = { "reactor_queue_wait_seconds",
+                            "Time from task submission to the start of its execution on a worker" },
+    [METRIC_HANDLER]    = { "reactor_handler_seconds",
+                            "Request handler execution time" },
+    [METRIC_WRITE_WAIT] = { "reactor_write_wait_seconds",
+                            "Time from a response being queued for output to its first write" },
+    [METRIC_END_TO_END] = { "reactor_request_seconds",
+                            "Time from reading a request to the first write of its response" },
+};
+
+static const double export_quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+static inline int hist_index(uint64_t value) {
+    if (value < HIST_SUB_BUCKETS) return (int)value;
+    
+    int exp = 63 - __builtin_clzll(value);
+    int sub = (int)((value >> (exp - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1));
+    return (exp - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS + sub;
+}
+
+// 桶内的最大值
+static uint64_t hist_upper(int index) {
+    if (index < HIST_SUB_BUCKETS) return (uint64_t)index;
+    
+    int exp = index / HIST_SUB_BUCKETS + HIST_SUB_BITS - 1;
+    int sub = index % HIST_SUB_BUCKETS;
+    uint64_t width = 1ULL << (exp - HIST_SUB_BITS);
+    return ((uint64_t)(HIST_SUB_BUCKETS + sub) << (exp - HIST_SUB_BITS)) + width - 1;
+}
+
+// 为当前线程分配直方图并登记；登记满或分配失败时本线程不再记录
+static metrics_thread_t* metrics_thread_get(void) {
+    if (tls_metrics_unavailable) return NULL;
+    
+    int slot = atomic_fetch_add(&thread_count, 1);
+    metrics_thread_t *m = NULL;
+    if (slot < METRICS_MAX_THREADS) {
+        m = (metrics_thread_t*)cache_aligned_calloc(1, sizeof(metrics_thread_t));
+    }
+    if (!m) {
+        tls_metrics_unavailable = 1;
+        return NULL;
+    }
+    
+    atomic_store_explicit(&threads[slot], m, memory_order_release);
+    tls_metrics = m;
+    return m;
+}
+
+void metrics_record(metric_hist_t which, uint64_t ns) {
+    metrics_thread_t *m = tls_metrics;
+    if (!m && !(m = metrics_thread_get())) return;
+    
+    histogram_t *h = &m->hist[which];
+    stat_add(&h->buckets[hist_index(ns)], 1);
+    stat_add(&h->sum, (long)ns);
+    stat_add(&h->count, 1);
+}
+
+int metrics_register_collector(metrics_collector_fn fn, void *arg) {
+    if (!fn || collector_count >= METRICS_MAX_COLLECTORS) return -1;
+    
+    collectors[collector_count].fn = fn;
+    collectors[collector_count].arg = arg;
+    collector_count++;
+    return 0;
+}
+
+void metrics_clear_collectors(void) {
+    collector_count = 0;
+}
+
+// 把当前缓冲区已写入的部分挂到输出链上
+static void metrics_out_flush(metrics_out_t *out) {
+    if (!out->buf) return;
+    
+    if (out->used > 0 && buf_chain_append(&out->chain, out->buf, 0, out->used) != 0) {
+        out->failed = 1;
+    }
+    buf_unref(out->buf);
+    out->buf = NULL;
+    out->used = 0;
+}
+
+void metrics_printf(metrics_out_t *out, const char *fmt, ...) {
+    // 当前缓冲区放不下时换一个新缓冲区重写这一行
+    for (int attempt = 0; attempt < 2 && !out->failed; attempt++) {
+        if (!out->buf) {
+            out->buf = buf_alloc(BUF_CHUNK_SIZE);
+            if (!out->buf) {
+                out->failed = 1;
+                return;
+            }
+            out->used = 0;
+        }
+        
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(out->buf->data + out->used, out->buf->size - out->used, fmt, ap);
+        va_end(ap);
+        
+        if (n < 0) {
+            out->failed = 1;
+            return;
+        }
+        if (out->used + n < out->buf->size) {
+            out->used += n;
+            return;
+        }
+        metrics_out_flush(out);
+    }
+    
+    out->failed = 1;
+}
+
+// 汇总所有线程的同一个直方图
+static void hist_aggregate(metric_hist_t which, long *buckets, long *count, long *sum) {
+    int n = atomic_load(&thread_count);
+    if (n > METRICS_MAX_THREADS) {
+        n = METRICS_MAX_THREADS;
+    }
+    
+    memset(buckets, 0, sizeof(long) * HIST_BUCKETS);
+    *count = 0;
+    *sum = 0;
+    
+    for (int t = 0; t < n; t++) {
+        metrics_thread_t *m = atomic_load_explicit(&threads[t], memory_order_acquire);
+        if (!m) continue;
+        
+        histogram_t *h = &m->hist[which];
+        for (int i = 0; i < HIST_BUCKETS; i++) {
+            buckets[i] += stat_read(&h->buckets[i]);
+        }
+        *count += stat_read(&h->count);
+        *sum += stat_read(&h->sum);
+    }
+}
+
+static void render_histogram(metrics_out_t *out, metric_hist_t which) {
+    long buckets[HIST_BUCKETS];
+    long count, sum;
+    const char *name = hist_info[which].name;
+    
+    hist_aggregate(which, buckets, &count, &sum);
+    
+    // 各线程的计数分别读取，桶的合计可能与 count 略有出入，以桶为准
+    long total = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        total += buckets[i];
+    }
+    
+    metrics_printf(out, "# HELP %s %s\n# TYPE %s histogram\n", name, hist_info[which].help, name);
+    
+    long cumulative = 0;
+    int index = 0;
+    for (int shift = EXPORT_MIN_SHIFT; shift <= EXPORT_MAX_SHIFT; shift++) {
+        int limit = hist_index(1ULL << shift);
+        while (index < limit) {
+            cumulative += buckets[index++];
+        }
+        metrics_printf(out, "%s_bucket{le=\"%.10g\"} %ld\n", name, (double)(1ULL << shift) / 1e9,
+                       cumulative);
+    }
+    metrics_printf(out, "%s_bucket{le=\"+Inf\"} %ld\n", name, total);
+    metrics_printf(out, "%s_sum %.9f\n%s_count %ld\n", name, (double)sum / 1e9, name, total);
+    
+    // 分位数按细粒度桶计算（误差不超过 1/8）
+    metrics_printf(out, "# HELP %s_quantile %s (quantiles)\n# TYPE %s_quantile gauge\n",
+                   name, hist_info[which].help, name);
+    for (size_t q = 0; q < sizeof(export_quantiles) / sizeof(export_quantiles[0]); q++) {
+        long rank = (long)(export_quantiles[q] * total);
+        if (rank < 1) rank = 1;
+        
+        long seen = 0;
+        uint64_t value = 0;
+        for (int i = 0; i < HIST_BUCKETS && total > 0; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                value = hist_upper(i);
+                break;
+            }
+        }
+        metrics_printf(out, "%s_quantile{quantile=\"%g\"} %.9f\n", name, export_quantiles[q],
+                       (double)value / 1e9);
+    }
+}
+
+int metrics_render(buf_chain_t *body) {
+    metrics_out_t out;
+    buf_chain_init(&out.chain);
+    out.buf = NULL;
+    out.used = 0;
+    out.failed = 0;
+    
+    for (int i = 0; i < METRIC_HIST_COUNT; i++) {
+        render_histogram(&out, (metric_hist_t)i);
+    }
+    for (int i = 0; i < collector_count; i++) {
+        collectors[i].fn(collectors[i].arg, &out);
+    }
+    
+    metrics_out_flush(&out);
+    if (out.failed) {
+        buf_chain_clear(&out.chain);
+        return -1;
+    }
+    
+    buf_chain_move(body, &out.chain);
+    return 0;
+}
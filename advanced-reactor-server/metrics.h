@@ -0,0 +1,70 @@
+// metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdarg.h>
+#include "common.h"
+
+// 运行时指标：每个线程独占一组对数-线性直方图，记录只做一次下标计算和几次单写者计数，
+// 不加锁；GET /metrics 时汇总所有线程的直方图，连同各模块登记的计数器一起
+// 以 Prometheus 文本格式输出。
+//
+// 直方图把每个 2 的幂区间等分为 HIST_SUB_BUCKETS 个子桶（相对误差不超过 1/8），
+// 覆盖 0 到 2^64 纳秒。
+
+#define HIST_SUB_BITS    3
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS     ((64 - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+// 最多登记的线程数和指标收集函数数
+#define METRICS_MAX_THREADS    256
+#define METRICS_MAX_COLLECTORS 16
+
+typedef enum {
+    METRIC_QUEUE_WAIT,      // 任务提交到开始执行
+    METRIC_HANDLER,         // 处理函数执行时间
+    METRIC_WRITE_WAIT,      // 响应就绪到第一次写出
+    METRIC_END_TO_END,      // 请求读入到响应第一次写出
+    METRIC_HIST_COUNT
+} metric_hist_t;
+
+typedef struct histogram {
+    stat_counter_t count;
+    stat_counter_t sum;         // 纳秒
+    stat_counter_t buckets[HIST_BUCKETS];
+} histogram_t;
+
+// 输出缓冲：渲染结果写入一串 buf_t
+typedef struct metrics_out {
+    buf_chain_t chain;
+    buf_t *buf;             // 当前写入的缓冲区
+    int used;
+    int failed;
+} metrics_out_t;
+
+// 收集函数：把模块自己的计数器按 Prometheus 文本格式写入 out
+typedef void (*metrics_collector_fn)(void *arg, metrics_out_t *out);
+
+// 单调时钟（纳秒）
+static inline uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 记录一个样本到当前线程的直方图（首次调用时为本线程分配并登记）
+void metrics_record(metric_hist_t which, uint64_t ns);
+
+// 登记收集函数（在服务器启动前调用）
+int metrics_register_collector(metrics_collector_fn fn, void *arg);
+
+// 清除所有收集函数（收集函数引用的对象销毁前调用）
+void metrics_clear_collectors(void);
+
+// 追加格式化文本
+void metrics_printf(metrics_out_t *out, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// 渲染全部指标到 body（Prometheus 文本格式 0.0.4）
+int metrics_render(buf_chain_t *body);
+
+#endif // METRICS_H
@@ -0,0 +1,72 @@
+// mpsc_queue.h
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "cpu_relax.h"
+
+// 侵入式无锁多生产者单消费者队列（Vyukov）
+// 生产者只做一次原子交换；消费者独占 tail，无需加锁
+typedef struct mpsc_node {
+    _Atomic(struct mpsc_node*) next;
+} mpsc_node_t;
+
+typedef struct mpsc_queue {
+    _Atomic(mpsc_node_t*) head;     // 生产者端
+    char pad[CACHE_LINE_SIZE - sizeof(void*)];
+    mpsc_node_t *tail;              // 消费者端
+    mpsc_node_t stub;
+} mpsc_queue_t;
+
+#define mpsc_container_of(ptr, type, member) \
+    ((type*)((char*)(ptr) - offsetof(type, member)))
+
+static inline void mpsc_queue_init(mpsc_queue_t *q) {
+    atomic_init(&q->stub.next, NULL);
+    atomic_init(&q->head, &q->stub);
+    q->tail = &q->stub;
+}
+
+// 入队（任意线程）
+static inline void mpsc_queue_push(mpsc_queue_t *q, mpsc_node_t *node) {
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    mpsc_node_t *prev = atomic_exchange_explicit(&q->head, node, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+// 出队（仅消费者线程），队列为空返回 NULL
+// 生产者处于交换与链接之间时短暂自旋，保证已入队的节点不会被漏掉
+static inline mpsc_node_t* mpsc_queue_pop(mpsc_queue_t *q) {
+    mpsc_node_t *tail = q->tail;
+    mpsc_node_t *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    
+    if (tail == &q->stub) {
+        if (!next) {
+            if (atomic_load_explicit(&q->head, memory_order_acquire) == &q->stub) {
+                return NULL;
+            }
+            while (!(next = atomic_load_explicit(&tail->next, memory_order_acquire))) {
+                cpu_relax();
+            }
+        }
+        q->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+    
+    if (!next) {
+        // tail 是最后一个节点：把 stub 接到它后面，使其可以出队
+        if (atomic_load_explicit(&q->head, memory_order_acquire) == tail) {
+            mpsc_queue_push(q, &q->stub);
+        }
+        while (!(next = atomic_load_explicit(&tail->next, memory_order_acquire))) {
+            cpu_relax();
+        }
+    }
+    
+    q->tail = next;
+    return tail;
+}
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,213 @@
+// object_pool.c
+#include "object_pool.h"
+
+// 线程标识：每个线程的该变量地址不同
+static __thread char thread_token;
+
+// 线程局部池：线程退出时由 pthread key 的析构函数销毁
+static pthread_key_t tls_pools_key;
+static pthread_once_t tls_pools_once = PTHREAD_ONCE_INIT;
+
+// 全局 malloc 计数
+static atomic_long heap_allocs;
+
+typedef struct pool_chunk {
+    struct pool_chunk *next;
+} __attribute__((aligned(16))) pool_chunk_t;
+
+#define OBJ_HEADER(obj) ((pool_obj_header_t*)(obj) - 1)
+#define OBJ_DATA(hdr)   ((void*)((pool_obj_header_t*)(hdr) + 1))
+
+static size_t slot_size(object_pool_t *pool) {
+    size_t size = sizeof(pool_obj_header_t) + pool->obj_size;
+    return (size + 15) & ~(size_t)15;
+}
+
+object_pool_t* object_pool_create(const char *name, size_t obj_size) {
+    object_pool_t *pool = (object_pool_t*)calloc(1, sizeof(object_pool_t));
+    if (!pool) return NULL;
+    
+    pool->name = name;
+    pool->obj_size = obj_size;
+    pool->owner = NULL;
+    atomic_init(&pool->remote_free, NULL);
+    atomic_init(&pool->remote_frees, 0);
+    atomic_init(&pool->refs, 1);
+    
+    return pool;
+}
+
+void object_pool_bind(object_pool_t *pool) {
+    if (!pool) return;
+    pool->owner = &thread_token;
+}
+
+int object_pool_prefill(object_pool_t *pool, int count) {
+    if (!pool || count <= 0) return 0;
+    
+    size_t slot = slot_size(pool);
+    pool_chunk_t *chunk = (pool_chunk_t*)malloc(sizeof(pool_chunk_t) + slot * count);
+    if (!chunk) return -1;
+    
+    // 写入整块内存，让缺页发生在启动阶段（并由所有者线程首次访问）
+    memset(chunk, 0, sizeof(pool_chunk_t) + slot * count);
+    
+    chunk->next = (pool_chunk_t*)pool->chunks;
+    pool->chunks = chunk;
+    
+    char *base = (char*)(chunk + 1);
+    for (int i = count - 1; i >= 0; i--) {
+        pool_obj_header_t *hdr = (pool_obj_header_t*)(base + slot * i);
+        hdr->pool = pool;
+        hdr->from_heap = 0;
+        hdr->next = pool->free_list;
+        pool->free_list = hdr;
+    }
+    pool->capacity += count;
+    
+    return 0;
+}
+
+void* object_pool_alloc(object_pool_t *pool) {
+    pool_obj_header_t *hdr;
+    
+    if (!pool) {
+        return NULL;
+    }
+    
+    hdr = pool->free_list;
+    if (!hdr) {
+        // 取回其它线程归还的全部对象
+        hdr = atomic_exchange_explicit(&pool->remote_free, NULL, memory_order_acquire);
+    }
+    
+    if (hdr) {
+        pool->free_list = hdr->next;
+        pool->hits++;
+    } else {
+        hdr = (pool_obj_header_t*)malloc(slot_size(pool));
+        if (!hdr) return NULL;
+        hdr->pool = pool;
+        hdr->from_heap = 1;
+        pool->misses++;
+        pool->capacity++;
+        atomic_fetch_add_explicit(&heap_allocs, 1, memory_order_relaxed);
+    }
+    
+    hdr->next = NULL;
+    atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    return OBJ_DATA(hdr);
+}
+
+// 释放池的全部内存（引用计数归零时调用）
+static void pool_release_memory(object_pool_t *pool) {
+    pool_obj_header_t *lists[2] = {
+        pool->free_list,
+        atomic_load_explicit(&pool->remote_free, memory_order_acquire)
+    };
+    
+    for (int i = 0; i < 2; i++) {
+        pool_obj_header_t *hdr = lists[i];
+        while (hdr) {
+            pool_obj_header_t *next = hdr->next;
+            if (hdr->from_heap) {
+                free(hdr);
+            }
+            hdr = next;
+        }
+    }
+    
+    pool_chunk_t *chunk = (pool_chunk_t*)pool->chunks;
+    while (chunk) {
+        pool_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    
+    free(pool);
+}
+
+void object_pool_free(void *obj) {
+    if (!obj) return;
+    
+    pool_obj_header_t *hdr = OBJ_HEADER(obj);
+    object_pool_t *pool = hdr->pool;
+    
+    if (pool->owner == &thread_token) {
+        hdr->next = pool->free_list;
+        pool->free_list = hdr;
+    } else {
+        pool_obj_header_t *old = atomic_load_explicit(&pool->remote_free, memory_order_relaxed);
+        do {
+            hdr->next = old;
+        } while (!atomic_compare_exchange_weak_explicit(&pool->remote_free, &old, hdr,
+                                                        memory_order_release,
+                                                        memory_order_relaxed));
+        atomic_fetch_add_explicit(&pool->remote_frees, 1, memory_order_relaxed);
+    }
+    
+    if (atomic_fetch_sub_explicit(&pool->refs, 1, memory_order_acq_rel) == 1) {
+        pool_release_memory(pool);
+    }
+}
+
+void object_pool_get_stats(object_pool_t *pool, object_pool_stats_t *stats) {
+    if (!pool || !stats) return;
+    
+    stats->capacity = pool->capacity;
+    stats->hits = pool->hits;
+    stats->misses = pool->misses;
+    stats->remote_frees = atomic_load_explicit(&pool->remote_frees, memory_order_relaxed);
+}
+
+void object_pool_destroy(object_pool_t *pool) {
+    if (!pool) return;
+    
+    // 此后的归还一律走远程释放栈，避免复用同一 TLS 地址的新线程误判为所有者
+    pool->owner = NULL;
+    
+    if (atomic_fetch_sub_explicit(&pool->refs, 1, memory_order_acq_rel) == 1) {
+        pool_release_memory(pool);
+    }
+}
+
+static void tls_pools_destructor(void *value) {
+    object_pool_t *pool = (object_pool_t*)value;
+    while (pool) {
+        object_pool_t *next = pool->next_owned;
+        object_pool_destroy(pool);
+        pool = next;
+    }
+}
+
+static void tls_pools_key_init(void) {
+    pthread_key_create(&tls_pools_key, tls_pools_destructor);
+}
+
+object_pool_t* object_pool_thread_local(object_pool_t **slot, const char *name,
+                                        size_t obj_size, int prefill) {
+    if (*slot) return *slot;
+    
+    pthread_once(&tls_pools_once, tls_pools_key_init);
+    
+    object_pool_t *pool = object_pool_create(name, obj_size);
+    if (!pool) return NULL;
+    
+    object_pool_bind(pool);
+    object_pool_prefill(pool, prefill);
+    
+    // 挂到本线程的池链表上，线程退出时统一销毁
+    pool->next_owned = (object_pool_t*)pthread_getspecific(tls_pools_key);
+    pthread_setspecific(tls_pools_key, pool);
+    
+    *slot = pool;
+    return pool;
+}
+
+void object_pool_count_heap_alloc(void) {
+    atomic_fetch_add_explicit(&heap_allocs, 1, memory_order_relaxed);
+}
+
+long object_pool_heap_allocs(void) {
+    return atomic_load_explicit(&heap_allocs, memory_order_relaxed);
+}
@@ -0,0 +1,86 @@
+// object_pool.h
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "common.h"
+
+// 定长对象池（slab + 空闲链表）
+//
+// 每个池属于一个线程：只有所有者线程调用 object_pool_alloc，本地空闲链表无需同步。
+// 任何线程都可以 object_pool_free；非所有者释放的对象压入无锁的远程释放栈，
+// 所有者在本地链表耗尽时一次性取回。池耗尽时退回 malloc 并计为 miss，
+// 这些对象释放后同样归还到池中。
+//
+// 池本身按引用计数销毁：object_pool_destroy 之后，最后一个归还的对象负责释放内存，
+// 因此对象可以比创建它的线程活得更久。
+//
+// 所有池退回 malloc 的次数累加到一个全局计数器，稳态下该计数应保持不变。
+
+typedef struct object_pool_stats {
+    long capacity;        // 池中对象总数（预分配 + miss 后加入的）
+    long hits;            // 从空闲链表分配
+    long misses;          // 空闲链表为空，退回 malloc
+    long remote_frees;    // 由其它线程归还
+} object_pool_stats_t;
+
+typedef struct pool_obj_header {
+    struct object_pool *pool;        // 所属的池
+    struct pool_obj_header *next;    // 空闲链表
+    int from_heap;                   // miss 时单独 malloc 的对象
+} __attribute__((aligned(16))) pool_obj_header_t;
+
+typedef struct object_pool {
+    const char *name;
+    size_t obj_size;
+    const void *owner;                      // 所有者线程标识
+    struct object_pool *next_owned;         // 同一线程的线程局部池链表
+    
+    // 所有者独占
+    pool_obj_header_t *free_list;
+    void *chunks;                           // 预分配的内存块链表
+    long capacity;
+    long hits;
+    long misses;
+    
+    // 远程释放（任意线程）
+    char pad[CACHE_LINE_SIZE];
+    _Atomic(pool_obj_header_t*) remote_free;
+    atomic_long remote_frees;
+    atomic_long refs;                       // 未归还的对象数 + 1（池本身）
+} object_pool_t;
+
+// 创建对象池（不预分配，未绑定所有者）
+object_pool_t* object_pool_create(const char *name, size_t obj_size);
+
+// 将调用线程设为所有者
+void object_pool_bind(object_pool_t *pool);
+
+// 预分配 count 个对象并逐页写入，避免运行时缺页（所有者线程调用）
+int object_pool_prefill(object_pool_t *pool, int count);
+
+// 返回调用线程在 *slot 中的线程局部池，首次调用时创建、绑定并预分配 prefill 个对象；
+// slot 应为调用方的 __thread 变量，线程退出时池自动销毁
+object_pool_t* object_pool_thread_local(object_pool_t **slot, const char *name,
+                                        size_t obj_size, int prefill);
+
+// 分配对象（所有者线程调用）
+void* object_pool_alloc(object_pool_t *pool);
+
+// 归还对象（任意线程）
+void object_pool_free(void *obj);
+
+// 读取统计信息
+void object_pool_get_stats(object_pool_t *pool, object_pool_stats_t *stats);
+
+// 销毁对象池（仍在使用中的对象归还后才真正释放内存）
+void object_pool_destroy(object_pool_t *pool);
+
+// 记录一次池外的 malloc（例如超出内联大小的数据）
+void object_pool_count_heap_alloc(void);
+
+// 进程内所有对象池累计的 malloc 次数（miss + 池外分配）
+long object_pool_heap_allocs(void);
+
+#endif // OBJECT_POOL_H
@@ -0,0 +1,417 @@
+// response_cache.c
+#define _GNU_SOURCE
+#include "response_cache.h"
+#include "timer_wheel.h"
+#include <strings.h>
+
+#define STRIPE_BUCKETS    1024
+#define CACHE_KEY_MAX     512
+#define CACHE_CONTROL_MAX 128
+
+// 单个响应最多占分片预算的比例（1/N）
+#define ENTRY_BUDGET_SHARE 4
+
+typedef struct cache_entry {
+    struct cache_entry *hash_next;
+    struct cache_entry *clock_prev;     // 分片内的 CLOCK 环
+    struct cache_entry *clock_next;
+    uint64_t hash;
+    uint64_t expires_ms;
+    int referenced;                     // 指针上次扫过之后被命中过
+    buf_t *resp;                        // 完整响应（只读，命中的请求各持有一个引用）
+    int resp_len;
+    size_t charge;                      // 计入分片预算的字节数
+    int key_len;
+    char key[];
+} cache_entry_t;
+
+// 一个分片：锁内只做哈希查找、链表操作和引用计数，复制响应在锁外
+typedef struct cache_stripe {
+    pthread_mutex_t lock CACHE_ALIGNED;
+    cache_entry_t *buckets[STRIPE_BUCKETS];
+    cache_entry_t *hand;                // CLOCK 指针，新条目插在它前面
+    size_t bytes;
+    int count;
+    
+    // 统计信息（持锁更新）
+    long hits;
+    long misses;
+    long inserts;
+    long evictions;
+    long expirations;
+} cache_stripe_t;
+
+typedef struct cache_key {
+    uint64_t hash;
+    int len;
+    char data[CACHE_KEY_MAX];
+} cache_key_t;
+
+static int cache_enabled;
+static size_t stripe_budget;
+static size_t entry_max;
+static long default_ttl_ms;
+static char *vary_names[RESPONSE_CACHE_VARY_MAX];
+static int vary_count;
+static cache_stripe_t stripes[RESPONSE_CACHE_STRIPES];
+
+static uint64_t hash_key(const char *data, int len) {
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// 键：方法 SP 请求目标 LF，之后每个 vary 头的值各一行（没有该头时为空行）
+static int build_key(const request_t *req, cache_key_t *key) {
+    const char *data = buf_slice_data(req->data);
+    long len = req->data->len;
+    
+    int method_len;
+    if (len > 4 && memcmp(data, "GET ", 4) == 0) {
+        method_len = 3;
+    } else if (len > 5 && memcmp(data, "HEAD ", 5) == 0) {
+        method_len = 4;
+    } else {
+        return -1;
+    }
+    
+    // 带正文或认证信息的请求不缓存
+    const char *head_end = memmem(data, len, "\r\n\r\n", 4);
+    if (!head_end || head_end + 4 != data + len) return -1;
+    
+    int value_len;
+    if (http_find_header(data, len, "Authorization", &value_len)) return -1;
+    
+    if (!req->path || method_len + 1 + req->path_len + 1 > CACHE_KEY_MAX) return -1;
+    
+    int n = method_len + 1;
+    memcpy(key->data, data, n);
+    memcpy(key->data + n, req->path, req->path_len);
+    n += req->path_len;
+    key->data[n++] = '\n';
+    
+    for (int i = 0; i < vary_count; i++) {
+        const char *value = http_find_header(data, len, vary_names[i], &value_len);
+        if (value) {
+            if (n + value_len + 1 > CACHE_KEY_MAX) return -1;
+            memcpy(key->data + n, value, value_len);
+            n += value_len;
+        }
+        key->data[n++] = '\n';
+    }
+    
+    key->len = n;
+    key->hash = hash_key(key->data, n);
+    return 0;
+}
+
+static cache_stripe_t* stripe_of(uint64_t hash) {
+    return &stripes[hash % RESPONSE_CACHE_STRIPES];
+}
+
+static cache_entry_t** bucket_of(cache_stripe_t *stripe, uint64_t hash) {
+    return &stripe->buckets[(hash / RESPONSE_CACHE_STRIPES) % STRIPE_BUCKETS];
+}
+
+// 以下 stripe_* 函数需持有 stripe->lock
+static cache_entry_t* stripe_find(cache_stripe_t *stripe, const cache_key_t *key) {
+    for (cache_entry_t *e = *bucket_of(stripe, key->hash); e; e = e->hash_next) {
+        if (e->hash == key->hash && e->key_len == key->len && memcmp(e->key, key->data, key->len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void stripe_insert(cache_stripe_t *stripe, cache_entry_t *entry) {
+    cache_entry_t **bucket = bucket_of(stripe, entry->hash);
+    entry->hash_next = *bucket;
+    *bucket = entry;
+    
+    // 插到指针前面：新条目要等指针转完一圈才会被检查
+    if (stripe->hand) {
+        entry->clock_next = stripe->hand;
+        entry->clock_prev = stripe->hand->clock_prev;
+        entry->clock_prev->clock_next = entry;
+        stripe->hand->clock_prev = entry;
+    } else {
+        entry->clock_prev = entry->clock_next = entry;
+        stripe->hand = entry;
+    }
+    
+    stripe->bytes += entry->charge;
+    stripe->count++;
+}
+
+// 移出并释放缓存持有的引用（正在发送它的响应写完后才回收缓冲区）
+static void stripe_remove(cache_stripe_t *stripe, cache_entry_t *entry) {
+    cache_entry_t **pos = bucket_of(stripe, entry->hash);
+    while (*pos != entry) {
+        pos = &(*pos)->hash_next;
+    }
+    *pos = entry->hash_next;
+    
+    if (entry->clock_next == entry) {
+        stripe->hand = NULL;
+    } else {
+        entry->clock_prev->clock_next = entry->clock_next;
+        entry->clock_next->clock_prev = entry->clock_prev;
+        if (stripe->hand == entry) {
+            stripe->hand = entry->clock_next;
+        }
+    }
+    
+    stripe->bytes -= entry->charge;
+    stripe->count--;
+    buf_unref(entry->resp);
+    free(entry);
+}
+
+// CLOCK：腾出 need 字节。指针扫过最近被命中的条目时清除标记、放过一轮，
+// 否则淘汰它；已过期的条目直接淘汰
+static void stripe_evict(cache_stripe_t *stripe, size_t need, uint64_t now_ms) {
+    while (stripe->hand && stripe->bytes + need > stripe_budget) {
+        cache_entry_t *entry = stripe->hand;
+        int expired = entry->expires_ms <= now_ms;
+        
+        if (entry->referenced && !expired) {
+            entry->referenced = 0;
+            stripe->hand = entry->clock_next;
+            continue;
+        }
+        
+        if (expired) {
+            stripe->expirations++;
+        } else {
+            stripe->evictions++;
+        }
+        stripe_remove(stripe, entry);
+    }
+}
+
+// 响应允许缓存时返回 TTL（毫秒），否则返回 0
+static long response_ttl(const char *data, int len) {
+    if (len < 13 || memcmp(data, "HTTP/1.1 200 ", 13) != 0) return 0;
+    
+    int value_len;
+    const char *value = http_find_header(data, len, "Cache-Control", &value_len);
+    if (!value) return default_ttl_ms;
+    
+    char cc[CACHE_CONTROL_MAX];
+    if (value_len >= (int)sizeof(cc)) {
+        value_len = sizeof(cc) - 1;
+    }
+    memcpy(cc, value, value_len);
+    cc[value_len] = '\0';
+    
+    if (strcasestr(cc, "no-store") || strcasestr(cc, "no-cache") || strcasestr(cc, "private")) {
+        return 0;
+    }
+    
+    const char *max_age = strcasestr(cc, "max-age=");
+    if (max_age) {
+        long seconds = atol(max_age + 8);
+        return seconds > 0 ? seconds * 1000 : 0;
+    }
+    return default_ttl_ms;
+}
+
+static int cacheable(const handler_t *handler) {
+    return cache_enabled && handler && (handler->flags & HANDLER_CACHEABLE);
+}
+
+static void free_vary_names(void) {
+    for (int i = 0; i < vary_count; i++) {
+        free(vary_names[i]);
+    }
+    vary_count = 0;
+}
+
+int response_cache_init(const response_cache_config_t *config) {
+    if (config->max_bytes == 0) return 0;
+    
+    // vary 头名：逗号分隔，忽略空白
+    const char *p = config->vary;
+    while (p && *p) {
+        while (*p == ',' || *p == ' ') {
+            p++;
+        }
+        const char *end = p;
+        while (*end && *end != ',' && *end != ' ') {
+            end++;
+        }
+        if (end > p) {
+            if (vary_count == RESPONSE_CACHE_VARY_MAX) {
+                log_error("Too many response cache vary headers (max %d)", RESPONSE_CACHE_VARY_MAX);
+                free_vary_names();
+                return -1;
+            }
+            vary_names[vary_count++] = strndup(p, end - p);
+        }
+        p = end;
+    }
+    
+    for (int i = 0; i < RESPONSE_CACHE_STRIPES; i++) {
+        pthread_mutex_init(&stripes[i].lock, NULL);
+    }
+    
+    stripe_budget = config->max_bytes / RESPONSE_CACHE_STRIPES;
+    entry_max = stripe_budget / ENTRY_BUDGET_SHARE;
+    default_ttl_ms = config->default_ttl_ms;
+    cache_enabled = 1;
+    return 0;
+}
+
+void response_cache_cleanup(void) {
+    if (!cache_enabled) return;
+    cache_enabled = 0;
+    
+    for (int i = 0; i < RESPONSE_CACHE_STRIPES; i++) {
+        cache_stripe_t *stripe = &stripes[i];
+        pthread_mutex_lock(&stripe->lock);
+        while (stripe->hand) {
+            stripe_remove(stripe, stripe->hand);
+        }
+        pthread_mutex_unlock(&stripe->lock);
+        pthread_mutex_destroy(&stripe->lock);
+    }
+    free_vary_names();
+}
+
+int response_cache_enabled(void) {
+    return cache_enabled;
+}
+
+int response_cache_lookup(const handler_t *handler, const request_t *req, buf_chain_t *resp) {
+    if (!cacheable(handler)) return -1;
+    
+    cache_key_t key;
+    if (build_key(req, &key) != 0) return -1;
+    
+    cache_stripe_t *stripe = stripe_of(key.hash);
+    uint64_t now_ms = clock_now_ms();
+    buf_t *buf = NULL;
+    int len = 0;
+    
+    pthread_mutex_lock(&stripe->lock);
+    cache_entry_t *entry = stripe_find(stripe, &key);
+    if (entry && entry->expires_ms <= now_ms) {
+        stripe->expirations++;
+        stripe_remove(stripe, entry);
+        entry = NULL;
+    }
+    if (entry) {
+        entry->referenced = 1;
+        buf = buf_ref(entry->resp);
+        len = entry->resp_len;
+        stripe->hits++;
+    } else {
+        stripe->misses++;
+    }
+    pthread_mutex_unlock(&stripe->lock);
+    
+    if (!buf) return -1;
+    
+    int ret = buf_chain_append(resp, buf, 0, len);
+    buf_unref(buf);
+    return ret;
+}
+
+void response_cache_store(const handler_t *handler, const request_t *req, const buf_chain_t *resp) {
+    if (!cacheable(handler) || resp->bytes == 0 || resp->bytes > entry_max) return;
+    
+    cache_key_t key;
+    if (build_key(req, &key) != 0) return;
+    
+    // 响应可能由多个片段组成（头 + 引用的正文），复制成一块独立缓冲区
+    buf_t *buf = buf_alloc_exact((int)resp->bytes);
+    if (!buf) return;
+    
+    int len = 0;
+    for (const buf_seg_t *seg = resp->head; seg; seg = seg->next) {
+        if (seg->file) {
+            buf_unref(buf);
+            return;
+        }
+        memcpy(buf->data + len, buf_slice_data(&seg->slice), seg->slice.len);
+        len += seg->slice.len;
+    }
+    
+    long ttl_ms = response_ttl(buf->data, len);
+    cache_entry_t *entry = ttl_ms > 0 ? malloc(sizeof(cache_entry_t) + key.len) : NULL;
+    if (!entry) {
+        buf_unref(buf);
+        return;
+    }
+    
+    uint64_t now_ms = clock_now_ms();
+    entry->hash = key.hash;
+    entry->expires_ms = now_ms + ttl_ms;
+    entry->referenced = 0;
+    entry->resp = buf;
+    entry->resp_len = len;
+    entry->charge = sizeof(cache_entry_t) + key.len + sizeof(buf_t) + len;
+    entry->key_len = key.len;
+    memcpy(entry->key, key.data, key.len);
+    
+    cache_stripe_t *stripe = stripe_of(key.hash);
+    pthread_mutex_lock(&stripe->lock);
+    
+    // 并发未命中时多个线程可能先后存入同一个键，保留最新的
+    cache_entry_t *old = stripe_find(stripe, &key);
+    if (old) {
+        stripe_remove(stripe, old);
+    }
+    stripe_evict(stripe, entry->charge, now_ms);
+    stripe_insert(stripe, entry);
+    stripe->inserts++;
+    
+    pthread_mutex_unlock(&stripe->lock);
+}
+
+void response_cache_collect_metrics(void *arg, metrics_out_t *out) {
+    (void)arg;
+    
+    long hits = 0, misses = 0, inserts = 0, evictions = 0, expirations = 0, count = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < RESPONSE_CACHE_STRIPES; i++) {
+        cache_stripe_t *stripe = &stripes[i];
+        pthread_mutex_lock(&stripe->lock);
+        hits += stripe->hits;
+        misses += stripe->misses;
+        inserts += stripe->inserts;
+        evictions += stripe->evictions;
+        expirations += stripe->expirations;
+        count += stripe->count;
+        bytes += stripe->bytes;
+        pthread_mutex_unlock(&stripe->lock);
+    }
+    
+    metrics_printf(out, "# HELP reactor_response_cache_hit_ratio Response cache hits / lookups since start\n"
+                   "# TYPE reactor_response_cache_hit_ratio gauge\n"
+                   "reactor_response_cache_hit_ratio %.4f\n",
+                   hits + misses ? (double)hits / (hits + misses) : 0.0);
+    metrics_printf(out, "# HELP reactor_response_cache_hits_total Requests answered from the response cache\n"
+                   "# TYPE reactor_response_cache_hits_total counter\n"
+                   "reactor_response_cache_hits_total %ld\n", hits);
+    metrics_printf(out, "# HELP reactor_response_cache_misses_total Cacheable requests not found in the cache\n"
+                   "# TYPE reactor_response_cache_misses_total counter\n"
+                   "reactor_response_cache_misses_total %ld\n", misses);
+    metrics_printf(out, "# HELP reactor_response_cache_inserts_total Responses stored in the cache\n"
+                   "# TYPE reactor_response_cache_inserts_total counter\n"
+                   "reactor_response_cache_inserts_total %ld\n", inserts);
+    metrics_printf(out, "# HELP reactor_response_cache_evictions_total Live entries evicted by CLOCK\n"
+                   "# TYPE reactor_response_cache_evictions_total counter\n"
+                   "reactor_response_cache_evictions_total %ld\n", evictions);
+    metrics_printf(out, "# HELP reactor_response_cache_expirations_total Entries dropped after their TTL\n"
+                   "# TYPE reactor_response_cache_expirations_total counter\n"
+                   "reactor_response_cache_expirations_total %ld\n", expirations);
+    metrics_printf(out, "# HELP reactor_response_cache_entries Entries in the response cache\n"
+                   "# TYPE reactor_response_cache_entries gauge\n"
+                   "reactor_response_cache_entries %ld\n", count);
+    metrics_printf(out, "# HELP reactor_response_cache_bytes Bytes charged against the cache limit\n"
+                   "# TYPE reactor_response_cache_bytes gauge\n"
+                   "reactor_response_cache_bytes %zu\n", bytes);
+}
@@ -0,0 +1,46 @@
+// response_cache.h
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include "handler.h"
+#include "metrics.h"
+
+// 响应缓存
+//
+// IO 线程在提交任务之前先查缓存，命中时把缓存的响应（一个只读 buf_t）按引用挂到输出链上，
+// 请求不进入工作线程池，也不执行处理函数。未命中的请求照常执行，带 HANDLER_CACHEABLE 的
+// 处理函数生成的 200 响应由执行它的线程（工作线程或 run-to-completion 的 IO 线程）存入缓存。
+//
+// 键为方法 + 请求目标 + 配置的 vary 请求头的值；只缓存没有正文、不带 Authorization 的
+// GET/HEAD 请求。缓存按键哈希分成 RESPONSE_CACHE_STRIPES 个分片，每个分片一把锁和一份
+// 内存预算，超出预算时用 CLOCK 淘汰。每个条目有自己的过期时间：响应带
+// Cache-Control: max-age=N 时为 N 秒，否则为配置的默认 TTL；no-store、no-cache、
+// private 的响应不缓存。
+
+#define RESPONSE_CACHE_STRIPES  16
+#define RESPONSE_CACHE_VARY_MAX 8
+
+typedef struct response_cache_config {
+    size_t max_bytes;       // 全部分片的内存上限（0 表示不启用）
+    int default_ttl_ms;
+    const char *vary;       // 逗号分隔的请求头名（NULL 表示只按方法和请求目标）
+} response_cache_config_t;
+
+// 初始化缓存，成功返回 0；max_bytes 为 0 时什么也不做
+int response_cache_init(const response_cache_config_t *config);
+
+// 释放所有条目（仍被响应引用的缓冲区在引用释放时回收）
+void response_cache_cleanup(void);
+
+int response_cache_enabled(void);
+
+// 查找 req 的缓存响应：命中时追加到 resp 并返回 0，未命中或不可缓存返回 -1
+int response_cache_lookup(const handler_t *handler, const request_t *req, buf_chain_t *resp);
+
+// 把处理函数生成的响应存入缓存（复制一份，不修改 resp）
+void response_cache_store(const handler_t *handler, const request_t *req, const buf_chain_t *resp);
+
+// /metrics 收集函数：命中率、命中、未命中、插入、淘汰、过期次数，条目数和字节数
+void response_cache_collect_metrics(void *arg, metrics_out_t *out);
+
+#endif // RESPONSE_CACHE_H
@@ -1,19 +1,40 @@
 // server.c
 #include "server.h"
 #include "event_loop.h"
+#include "handler.h"
 
 // 信号处理
 static volatile int g_shutdown = 0;
 
+// 主循环无限期阻塞等待，信号可能投递给任意线程，由信号处理函数（或 server_stop）写管道唤醒
+static int g_wakeup_pipe[2] = { -1, -1 };
+
+static void wakeup_main_loop(void) {
+    if (g_wakeup_pipe[1] >= 0) {
+        int saved_errno = errno;
+        char dummy = 1;
+        (void)!write(g_wakeup_pipe[1], &dummy, 1);
+        errno = saved_errno;
+    }
+}
+
+static void close_wakeup_pipe(void) {
+    int read_fd = g_wakeup_pipe[0], write_fd = g_wakeup_pipe[1];
+    g_wakeup_pipe[0] = g_wakeup_pipe[1] = -1;
+    close(read_fd);
+    close(write_fd);
+}
+
 static void signal_handler(int sig) {
     if (sig == SIGINT || sig == SIGTERM) {
-        log_info("Received shutdown signal");
+        // 信号处理函数中不能写日志（日志缓冲区不是异步信号安全的）
         g_shutdown = 1;
+        wakeup_main_loop();
     }
 }
 
-// 创建监听套接字
-static int create_listen_socket(int port) {
+// 创建监听套接字（reuseport 为真时 SO_REUSEPORT 失败视为致命错误）
+static int create_listen_socket(int port, int reuseport) {
     int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (listen_fd == -1) {
         handle_error("socket");
@@ -26,6 +47,9 @@ static int create_listen_socket(int port) {
     }
     
     if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+        if (reuseport) {
+            handle_error("setsockopt SO_REUSEPORT");
+        }
         log_error("setsockopt SO_REUSEPORT failed: %s", strerror(errno));
     }
     
@@ -51,6 +75,36 @@ static int create_listen_socket(int port) {
     return listen_fd;
 }
 
+// 把已接受的连接分配给 IO 线程
+static void assign_connection(reactor_server_t *server, int client_fd, struct sockaddr_in *addr) {
+    // 设置 TCP_NODELAY
+    int opt = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    
+    // 获取 IO 线程（轮询）
+    io_thread_t *io_thread = io_thread_pool_get_thread(server->io_pool);
+    if (!io_thread) {
+        log_error("No IO thread available");
+        close(client_fd);
+        return;
+    }
+    
+    // 将连接分配给 IO 线程
+    if (io_thread_add_connection(io_thread, client_fd, addr) == 0) {
+        server->total_connections++;
+        
+        if (log_enabled(LOG_LEVEL_DEBUG)) {
+            char client_ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &addr->sin_addr, client_ip, sizeof(client_ip));
+            log_debug("New connection from %s:%d, assigned to IO thread %d", 
+                    client_ip, ntohs(addr->sin_port), io_thread->thread_index);
+        }
+    } else {
+        log_error("Failed to add connection to IO thread");
+        close(client_fd);
+    }
+}
+
 // 接受新连接
 static void accept_connections(reactor_server_t *server) {
     struct sockaddr_in client_addr;
@@ -76,60 +130,203 @@ static void accept_connections(reactor_server_t *server) {
         // 设置客户端套接字为非阻塞
         set_nonblocking(client_fd);
         
-        // 设置 TCP_NODELAY
-        int opt = 1;
-        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
-        
-        // 获取 IO 线程（轮询）
-        io_thread_t *io_thread = io_thread_pool_get_thread(server->io_pool);
-        if (!io_thread) {
-            log_error("No IO thread available");
-            close(client_fd);
-            continue;
+        assign_connection(server, client_fd, &client_addr);
+    }
+}
+
+// 完成模式的多发 accept：内核已接受连接（带 SOCK_NONBLOCK），result 即新的 fd
+static void accept_completion(reactor_server_t *server, const event_t *ev) {
+    if (ev->result < 0) {
+        log_error("accept error: %s", strerror(-ev->result));
+        // 出错后 accept 已停止：除监听套接字本身失效外，稍后重新开始（fd 耗尽时不空转）
+        if (ev->result != -EBADF && ev->result != -EINVAL) {
+            server->accept_retry_ms = clock_now_ms() + ACCEPT_RETRY_MS;
         }
-        
-        // 将连接分配给 IO 线程
-        if (io_thread_add_connection(io_thread, client_fd, &client_addr) == 0) {
-            pthread_mutex_lock(&server->stats_mutex);
-            server->total_connections++;
-            pthread_mutex_unlock(&server->stats_mutex);
-            
-            char client_ip[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, sizeof(client_ip));
-            log_info("New connection from %s:%d, assigned to IO thread %d", 
-                    client_ip, ntohs(client_addr.sin_port), io_thread->thread_index);
+        return;
+    }
+    
+    struct sockaddr_in client_addr;
+    socklen_t addr_len = sizeof(client_addr);
+    if (getpeername(ev->result, (struct sockaddr*)&client_addr, &addr_len) != 0) {
+        memset(&client_addr, 0, sizeof(client_addr));
+    }
+    
+    assign_connection(server, ev->result, &client_addr);
+}
+
+void server_config_init(server_config_t *config) {
+    if (!config) return;
+    
+    config->port = 8080;
+    config->io_threads = 4;
+    config->worker_threads = 8;
+    config->reuseport = 0;
+    config->queue_kind = TASK_QUEUE_MUTEX;
+    config->conn_prealloc = 256;
+    config->run_to_completion = 0;
+    config->idle_timeout_ms = 60 * 1000;
+    config->header_timeout_ms = 10 * 1000;
+    config->write_timeout_ms = 30 * 1000;
+    config->dispatch = IO_DISPATCH_ROUND_ROBIN;
+    config->busy_poll_us = 0;
+    config->direct_write = 1;
+    config->static_root = NULL;
+    config->static_mode = STATIC_SEND_SENDFILE;
+    config->cache.max_bytes = 0;
+    config->cache.default_ttl_ms = 10000;
+    config->cache.vary = "Accept-Encoding";
+    memset(&config->affinity, 0, sizeof(config->affinity));
+}
+
+// 关闭所有监听套接字
+static void close_listen_sockets(reactor_server_t *server) {
+    if (server->listen_fd != -1) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+    }
+    if (server->listen_fds) {
+        for (int i = 0; i < server->listen_fd_count; i++) {
+            close(server->listen_fds[i]);
+        }
+        free(server->listen_fds);
+        server->listen_fds = NULL;
+        server->listen_fd_count = 0;
+    }
+}
+
+static void log_placement(const char *kind, int index, const thread_placement_t *placement) {
+    char cpus[256];
+    cpu_mask_format(&placement->cpus, cpus, sizeof(cpus));
+    log_info("%s %d -> CPU %s (node %d, group %d)", kind, index, cpus[0] ? cpus : "any",
+            placement->node, placement->group);
+}
+
+// 按配置计算 IO 线程和 worker 的 CPU 放置；未启用或无法读取拓扑时两者都为 NULL（不绑定）
+static void plan_placement(const server_config_t *config, thread_placement_t **io,
+                           thread_placement_t **workers) {
+    *io = NULL;
+    *workers = NULL;
+    
+    const affinity_config_t *affinity = &config->affinity;
+    if (!affinity->enabled && cpu_mask_count(&affinity->io_cpus) == 0 &&
+        cpu_mask_count(&affinity->worker_cpus) == 0) {
+        return;
+    }
+    
+    cpu_topology_t *topo = (cpu_topology_t*)malloc(sizeof(cpu_topology_t));
+    *io = (thread_placement_t*)calloc(config->io_threads, sizeof(thread_placement_t));
+    *workers = (thread_placement_t*)calloc(config->worker_threads, sizeof(thread_placement_t));
+    
+    int ok = topo && *io && *workers;
+    if (ok) {
+        if (cpu_topology_detect(topo) == 0) {
+            log_info("CPU topology: %d CPUs in %d LLC/NUMA groups", topo->count, topo->group_count);
         } else {
-            log_error("Failed to add connection to IO thread");
-            close(client_fd);
+            topo->count = 0;
         }
+        ok = affinity_plan(affinity, topo, config->io_threads, *io,
+                           config->worker_threads, *workers) == 0;
+    }
+    free(topo);
+    
+    if (!ok) {
+        log_error("CPU affinity unavailable, threads are not pinned");
+        free(*io);
+        free(*workers);
+        *io = NULL;
+        *workers = NULL;
+        return;
+    }
+    
+    for (int i = 0; i < config->io_threads; i++) {
+        log_placement("IO thread", i, &(*io)[i]);
+    }
+    for (int i = 0; i < config->worker_threads; i++) {
+        log_placement("Worker", i, &(*workers)[i]);
     }
 }
 
-reactor_server_t* server_create(int port, int io_threads, int worker_threads) {
+reactor_server_t* server_create(const server_config_t *config) {
+    if (!config) return NULL;
+    
     reactor_server_t *server = (reactor_server_t*)malloc(sizeof(reactor_server_t));
     if (!server) return NULL;
     
+    int port = config->port;
+    int io_threads = config->io_threads;
+    int worker_threads = config->worker_threads;
+    
     server->port = port;
+    server->reuseport = config->reuseport;
     server->running = 0;
     server->total_connections = 0;
-    pthread_mutex_init(&server->stats_mutex, NULL);
+    server->listen_fd = -1;
+    server->listen_fds = NULL;
+    server->listen_fd_count = 0;
+    server->accept_retry_ms = 0;
+    
+    // 分片模式：每个 IO 线程一个监听套接字，由内核按四元组哈希分发连接
+    if (server->reuseport) {
+        server->listen_fds = (int*)malloc(sizeof(int) * io_threads);
+        if (!server->listen_fds) {
+            free(server);
+            return NULL;
+        }
+        for (int i = 0; i < io_threads; i++) {
+            server->listen_fds[i] = create_listen_socket(port, 1);
+            server->listen_fd_count++;
+        }
+    } else {
+        // 创建监听套接字
+        server->listen_fd = create_listen_socket(port, 0);
+    }
+    
+    // 注册内置请求处理函数
+    handler_register_builtins();
+    if (config->static_root && static_files_init(config->static_root, config->static_mode) != 0) {
+        close_listen_sockets(server);
+        free(server);
+        return NULL;
+    }
+    if (response_cache_init(&config->cache) != 0) {
+        static_files_cleanup();
+        close_listen_sockets(server);
+        free(server);
+        return NULL;
+    }
     
-    // 创建监听套接字
-    server->listen_fd = create_listen_socket(port);
+    // 计算 CPU 放置（线程启动后自行绑定）
+    thread_placement_t *io_placement, *worker_placement;
+    plan_placement(config, &io_placement, &worker_placement);
     
     // 创建工作线程池
-    server->worker_pool = thread_pool_create(worker_threads, 2000);
+    server->worker_pool = thread_pool_create(worker_threads, 2000, config->queue_kind,
+                                             worker_placement);
+    free(worker_placement);
     if (!server->worker_pool) {
-        close(server->listen_fd);
+        free(io_placement);
+        close_listen_sockets(server);
         free(server);
         return NULL;
     }
     
-    // 创建 IO 线程池
-    server->io_pool = io_thread_pool_create(io_threads, server->worker_pool);
+    // 创建 IO 线程池（分片模式下每个 IO 线程监听自己的套接字）
+    io_thread_config_t io_config;
+    io_config.conn_prealloc = config->conn_prealloc;
+    io_config.run_to_completion = config->run_to_completion;
+    io_config.idle_timeout_ms = config->idle_timeout_ms;
+    io_config.header_timeout_ms = config->header_timeout_ms;
+    io_config.write_timeout_ms = config->write_timeout_ms;
+    io_config.dispatch = config->dispatch;
+    io_config.busy_poll_us = config->busy_poll_us;
+    io_config.direct_write = config->direct_write;
+    io_config.placement = io_placement;
+    server->io_pool = io_thread_pool_create(io_threads, server->worker_pool, server->listen_fds,
+                                            &io_config);
+    free(io_placement);
     if (!server->io_pool) {
         thread_pool_destroy(server->worker_pool);
-        close(server->listen_fd);
+        close_listen_sockets(server);
         free(server);
         return NULL;
     }
@@ -139,24 +336,39 @@ reactor_server_t* server_create(int port, int io_threads, int worker_threads) {
     if (!server->main_event_loop) {
         io_thread_pool_destroy(server->io_pool);
         thread_pool_destroy(server->worker_pool);
-        close(server->listen_fd);
+        close_listen_sockets(server);
         free(server);
         return NULL;
     }
     
-    // 将监听套接字添加到主 event loop
-    if (event_loop_add(server->main_event_loop, server->listen_fd, 
-                       EVENT_READ | EVENT_ET, NULL) == -1) {
+    // 将监听套接字添加到主 event loop（分片模式下主线程不参与 accept）
+    if (server->listen_fd != -1 &&
+        (server->main_event_loop->completions ?
+         event_loop_accept_start(server->main_event_loop, server->listen_fd, NULL) :
+         event_loop_add(server->main_event_loop, server->listen_fd,
+                        EVENT_READ | EVENT_ET, NULL)) == -1) {
         event_loop_destroy(server->main_event_loop);
         io_thread_pool_destroy(server->io_pool);
         thread_pool_destroy(server->worker_pool);
-        close(server->listen_fd);
+        close_listen_sockets(server);
         free(server);
         return NULL;
     }
     
-    log_info("Server created: port=%d, io_threads=%d, worker_threads=%d", 
-            port, io_threads, worker_threads);
+    // /metrics 输出各线程的计数器
+    metrics_register_collector(io_thread_pool_collect_metrics, server->io_pool);
+    metrics_register_collector(thread_pool_collect_metrics, server->worker_pool);
+    if (config->static_root) {
+        metrics_register_collector(static_files_collect_metrics, NULL);
+    }
+    if (response_cache_enabled()) {
+        metrics_register_collector(response_cache_collect_metrics, NULL);
+    }
+    metrics_register_collector(log_collect_metrics, NULL);
+    
+    log_info("Server created: port=%d, io_threads=%d, worker_threads=%d, acceptor=%s", 
+            port, io_threads, worker_threads,
+            server->reuseport ? "per-io-thread (SO_REUSEPORT)" : "main thread");
     
     return server;
 }
@@ -169,13 +381,38 @@ int server_start(reactor_server_t *server) {
     signal(SIGTERM, signal_handler);
     signal(SIGPIPE, SIG_IGN);
     
+    if (pipe(g_wakeup_pipe) == -1) {
+        log_error("pipe error: %s", strerror(errno));
+        return -1;
+    }
+    set_nonblocking(g_wakeup_pipe[0]);
+    set_nonblocking(g_wakeup_pipe[1]);
+    if (event_loop_add(server->main_event_loop, g_wakeup_pipe[0], EVENT_READ, g_wakeup_pipe) == -1) {
+        log_error("Failed to add wakeup pipe to event loop");
+        close_wakeup_pipe();
+        return -1;
+    }
+    
     server->running = 1;
     log_info("Server starting on port %d...", server->port);
     
-    // 主循环：只处理 accept
+    // 主循环：只处理 accept，没有新连接时一直阻塞
     event_t events[10];
     while (server->running && !g_shutdown) {
-        int nfds = event_loop_wait(server->main_event_loop, events, 10, 1);
+        int timeout = -1;
+        if (server->accept_retry_ms) {
+            uint64_t now = clock_now_ms();
+            if (now >= server->accept_retry_ms) {
+                server->accept_retry_ms = 0;
+                if (event_loop_accept_start(server->main_event_loop, server->listen_fd, NULL) != 0) {
+                    log_error("Failed to restart accept");
+                }
+            } else {
+                timeout = (int)(server->accept_retry_ms - now);
+            }
+        }
+        
+        int nfds = event_loop_wait(server->main_event_loop, events, 10, timeout);
         
         if (nfds == -1) {
             if (errno == EINTR) continue;
@@ -186,10 +423,21 @@ int server_start(reactor_server_t *server) {
         for (int i = 0; i < nfds; i++) {
             event_t *ev = &events[i];
             
+            // 唤醒只用于重新检查退出标志
+            if (ev->data == g_wakeup_pipe) {
+                char drain[64];
+                while (read(g_wakeup_pipe[0], drain, sizeof(drain)) > 0);
+                continue;
+            }
+            
             if (ev->events & EVENT_READ) {
                 accept_connections(server);
             }
             
+            if (ev->events & EVENT_ACCEPT) {
+                accept_completion(server, ev);
+            }
+            
             if (ev->events & (EVENT_ERROR | EVENT_HUP)) {
                 log_error("Error on listen socket");
                 server->running = 0;
@@ -198,30 +446,50 @@ int server_start(reactor_server_t *server) {
         }
     }
     
+    if (g_shutdown) {
+        log_info("Received shutdown signal");
+    }
+    
+    event_loop_del(server->main_event_loop, g_wakeup_pipe[0]);
+    close_wakeup_pipe();
+    
+    if (server->reuseport) {
+        // 分片模式下连接由各 IO 线程自行 accept
+        server->total_connections = io_thread_pool_total_connections(server->io_pool);
+    }
+    
     log_info("Server stopped. Total connections handled: %ld", server->total_connections);
     
+    // 连接、任务、消息均来自对象池：稳态下该值只随峰值并发增长，不随请求数增长
+    object_pool_stats_t conn_stats;
+    io_thread_pool_conn_pool_stats(server->io_pool, &conn_stats);
+    log_info("Heap allocations: %ld (connection pool hits=%ld, misses=%ld)",
+            object_pool_heap_allocs(), conn_stats.hits, conn_stats.misses);
+    
     return 0;
 }
 
 void server_stop(reactor_server_t *server) {
     if (!server) return;
     server->running = 0;
+    wakeup_main_loop();
 }
 
 void server_destroy(reactor_server_t *server) {
     if (!server) return;
     
-    // 关闭监听套接字
-    if (server->listen_fd != -1) {
-        close(server->listen_fd);
-    }
+    metrics_clear_collectors();
     
     // 销毁各组件
     event_loop_destroy(server->main_event_loop);
     io_thread_pool_destroy(server->io_pool);
     thread_pool_destroy(server->worker_pool);
+    static_files_cleanup();
+    response_cache_cleanup();
+    
+    // 关闭监听套接字（IO 线程退出后再关闭分片套接字）
+    close_listen_sockets(server);
     
-    pthread_mutex_destroy(&server->stats_mutex);
     
     free(server);
     
@@ -6,10 +6,36 @@
 #include "thread_pool.h"
 #include "io_thread.h"
 #include "event_loop.h"
+#include "static_file.h"
+#include "response_cache.h"
+
+// 服务器配置
+typedef struct server_config {
+    int port;
+    int io_threads;
+    int worker_threads;
+    int reuseport;         // 每个 IO 线程独占一个 SO_REUSEPORT 监听套接字
+    task_queue_kind_t queue_kind;  // 工作线程池任务队列实现
+    int conn_prealloc;     // 每个 IO 线程预分配的连接对象数
+    int run_to_completion; // 非阻塞处理函数直接在 IO 线程执行
+    int idle_timeout_ms;   // 空闲连接超时（0 表示不限）
+    int header_timeout_ms; // 请求头接收超时（0 表示不限）
+    int write_timeout_ms;  // 输出积压超时（0 表示不限）
+    io_dispatch_t dispatch;    // 单 acceptor 模式下新连接的分配策略
+    int busy_poll_us;      // IO 线程阻塞前的最长自旋时间（微秒，0 表示不自旋）
+    int direct_write;      // 工作线程在连接没有积压输出时直接写出响应
+    const char *static_root;       // /static/ 对应的根目录（NULL 表示不提供静态文件）
+    static_send_mode_t static_mode;
+    response_cache_config_t cache; // 响应缓存（max_bytes 为 0 表示不启用）
+    affinity_config_t affinity;    // IO 线程和 worker 的 CPU 绑定
+} server_config_t;
 
 typedef struct reactor_server {
-    int listen_fd;
+    int listen_fd;         // 单 acceptor 模式下的监听套接字（分片模式为 -1）
+    int *listen_fds;       // 分片模式下每个 IO 线程的监听套接字
+    int listen_fd_count;
     int port;
+    int reuseport;
     
     // 线程池
     thread_pool_t *worker_pool;
@@ -18,16 +44,21 @@ typedef struct reactor_server {
     // 主线程 event loop（只监听 listen_fd）
     event_loop_t *main_event_loop;
     
+    // 完成模式下 accept 出错后重新开始 accept 的时间（0 表示未暂停）
+    uint64_t accept_retry_ms;
+    
     // 运行状态
     volatile int running;
     
-    // 统计信息
+    // 统计信息（只由主线程访问）
     long total_connections;
-    pthread_mutex_t stats_mutex;
 } reactor_server_t;
 
+// 填充默认配置
+void server_config_init(server_config_t *config);
+
 // 创建服务器
-reactor_server_t* server_create(int port, int io_threads, int worker_threads);
+reactor_server_t* server_create(const server_config_t *config);
 
 // 启动服务器
 int server_start(reactor_server_t *server);
@@ -0,0 +1,548 @@
+// static_file.c
+#define _GNU_SOURCE
+#include "static_file.h"
+#include "handler.h"
+#include "object_pool.h"
+#include "timer_wheel.h"
+#include <strings.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/openat2.h>
+#endif
+
+#define STATIC_CACHE_MAX     1024
+#define STATIC_HASH_BUCKETS  2048
+#define STATIC_REVALIDATE_MS 1000
+#define STATIC_PATH_MAX      256
+
+#define HTTP_DATE_SIZE   32
+#define HTTP_DATE_FORMAT "%a, %d %b %Y %H:%M:%S GMT"
+
+// 附加头部行的缓冲区大小
+#define EXTRA_HEADERS_SIZE 256
+
+// 只解析路径、不读取内容的打开方式：没有 O_PATH 的平台按只读打开
+#ifdef __linux__
+#define OPEN_LOOKUP O_PATH
+#else
+#define OPEN_LOOKUP O_RDONLY
+#endif
+
+typedef struct static_file {
+    buf_file_t file;                // 缓存和每个引用它的响应各持有一个引用
+    char path[STATIC_PATH_MAX];     // 相对根目录的路径
+    off_t size;
+    time_t mtime;
+    dev_t dev;
+    ino_t ino;
+    char last_modified[HTTP_DATE_SIZE];
+    const char *content_type;
+    buf_t *body;                    // 小文件的正文（NULL 表示发送时 sendfile）
+    
+    // 以下由缓存锁保护
+    uint64_t checked_ms;            // 上次确认文件没有变化的时间
+    int cached;
+    struct static_file *hash_next;
+    struct static_file *lru_prev;   // 表头为最近使用
+    struct static_file *lru_next;
+} static_file_t;
+
+// 所有工作线程共享一个缓存，锁内只做哈希查找和链表操作，open/fstat/read 都在锁外
+typedef struct static_cache {
+    pthread_mutex_t lock;
+    static_file_t *buckets[STATIC_HASH_BUCKETS];
+    static_file_t *lru_head;
+    static_file_t *lru_tail;
+    int count;
+    
+    // 统计信息（持锁更新）
+    long hits;
+    long misses;
+    long evictions;
+} static_cache_t;
+
+static int root_fd = -1;
+#ifdef __linux__
+static atomic_int openat2_missing;      // 内核不支持 openat2 时改用逐级打开
+#endif
+static static_send_mode_t send_mode;
+static static_cache_t cache = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static const struct {
+    const char *ext;
+    const char *type;
+} content_types[] = {
+    { "html", "text/html" },
+    { "htm",  "text/html" },
+    { "css",  "text/css" },
+    { "js",   "application/javascript" },
+    { "json", "application/json" },
+    { "txt",  "text/plain" },
+    { "svg",  "image/svg+xml" },
+    { "png",  "image/png" },
+    { "jpg",  "image/jpeg" },
+    { "jpeg", "image/jpeg" },
+    { "gif",  "image/gif" },
+    { "ico",  "image/x-icon" },
+    { "wasm", "application/wasm" },
+};
+
+static const char* guess_content_type(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (dot && !strchr(dot, '/')) {
+        for (size_t i = 0; i < sizeof(content_types) / sizeof(content_types[0]); i++) {
+            if (strcasecmp(dot + 1, content_types[i].ext) == 0) {
+                return content_types[i].type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+static unsigned int hash_path(const char *path) {
+    unsigned int h = 2166136261u;
+    for (; *path; path++) {
+        h = (h ^ (unsigned char)*path) * 16777619u;
+    }
+    return h % STATIC_HASH_BUCKETS;
+}
+
+// 最后一个引用释放：关闭 fd
+static void static_file_release(buf_file_t *file) {
+    static_file_t *entry = (static_file_t*)file;
+    close(entry->file.fd);
+    buf_unref(entry->body);
+    free(entry);
+}
+
+static void lru_unlink(static_file_t *entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache.lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache.lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void lru_push_front(static_file_t *entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = cache.lru_head;
+    if (cache.lru_head) {
+        cache.lru_head->lru_prev = entry;
+    } else {
+        cache.lru_tail = entry;
+    }
+    cache.lru_head = entry;
+}
+
+// 以下 cache_* 函数需持有 cache.lock
+static static_file_t* cache_find(const char *path) {
+    for (static_file_t *e = cache.buckets[hash_path(path)]; e; e = e->hash_next) {
+        if (strcmp(e->path, path) == 0) return e;
+    }
+    return NULL;
+}
+
+// 移出缓存并释放缓存持有的引用（响应仍引用时推迟到响应写完）
+static void cache_remove(static_file_t *entry) {
+    static_file_t **pos = &cache.buckets[hash_path(entry->path)];
+    while (*pos != entry) {
+        pos = &(*pos)->hash_next;
+    }
+    *pos = entry->hash_next;
+    lru_unlink(entry);
+    entry->cached = 0;
+    cache.count--;
+    buf_file_unref(&entry->file);
+}
+
+static void cache_insert(static_file_t *entry) {
+    unsigned int bucket = hash_path(entry->path);
+    entry->hash_next = cache.buckets[bucket];
+    cache.buckets[bucket] = entry;
+    lru_push_front(entry);
+    entry->cached = 1;
+    cache.count++;
+    
+    while (cache.count > STATIC_CACHE_MAX) {
+        cache_remove(cache.lru_tail);
+        cache.evictions++;
+    }
+}
+
+static int same_file(const static_file_t *entry, const struct stat *st) {
+    return S_ISREG(st->st_mode) && st->st_dev == entry->dev && st->st_ino == entry->ino &&
+           st->st_size == entry->size && st->st_mtime == entry->mtime;
+}
+
+// 不支持 openat2（或非 Linux）时逐级打开：每一级都带 O_NOFOLLOW，路径中任何符号链接都会导致失败
+static int open_beneath_walk(const char *path, int flags) {
+    int dir_fd = root_fd;
+    const char *p = path;
+    
+    for (;;) {
+        const char *slash = strchr(p, '/');
+        size_t len = slash ? (size_t)(slash - p) : strlen(p);
+        char name[STATIC_PATH_MAX];
+        if (len == 0 || len >= sizeof(name) ||
+            (len == 2 && p[0] == '.' && p[1] == '.')) {
+            if (dir_fd != root_fd) close(dir_fd);
+            errno = EACCES;
+            return -1;
+        }
+        memcpy(name, p, len);
+        name[len] = '\0';
+        
+        int fd = slash ? openat(dir_fd, name, OPEN_LOOKUP | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)
+                       : openat(dir_fd, name, flags | O_NOFOLLOW | O_CLOEXEC);
+        if (dir_fd != root_fd) close(dir_fd);
+        if (fd < 0 || !slash) return fd;
+        
+        dir_fd = fd;
+        p = slash + 1;
+    }
+}
+
+// 在根目录之下打开 path：解析过程不能离开根目录，也不能经过 /proc 魔法链接。
+// 根目录内部的符号链接照常解析，指向根目录之外的返回 EXDEV
+static int open_beneath(const char *path, int flags) {
+#ifdef __linux__
+    if (!atomic_load_explicit(&openat2_missing, memory_order_relaxed)) {
+        struct open_how how = {
+            .flags = (uint64_t)(flags | O_CLOEXEC),
+            .resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS,
+        };
+        int fd = (int)syscall(SYS_openat2, root_fd, path, &how, sizeof(how));
+        if (fd >= 0 || errno != ENOSYS) return fd;
+        atomic_store_explicit(&openat2_missing, 1, memory_order_relaxed);
+    }
+#endif
+    return open_beneath_walk(path, flags);
+}
+
+// 打开文件并读取元数据（小文件连同正文），返回的项持有一个引用
+static static_file_t* static_file_open(const char *path, uint64_t now_ms) {
+    int fd = open_beneath(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+    
+    static_file_t *entry = calloc(1, sizeof(static_file_t));
+    if (!entry) {
+        close(fd);
+        return NULL;
+    }
+    object_pool_count_heap_alloc();
+    
+    atomic_init(&entry->file.refs, 1);
+    entry->file.fd = fd;
+    entry->file.release = static_file_release;
+    snprintf(entry->path, sizeof(entry->path), "%s", path);
+    entry->size = st.st_size;
+    entry->mtime = st.st_mtime;
+    entry->dev = st.st_dev;
+    entry->ino = st.st_ino;
+    entry->content_type = guess_content_type(path);
+    entry->checked_ms = now_ms;
+    
+    struct tm tm;
+    gmtime_r(&entry->mtime, &tm);
+    strftime(entry->last_modified, sizeof(entry->last_modified), HTTP_DATE_FORMAT, &tm);
+    
+    if (send_mode == STATIC_SEND_SENDFILE && entry->size > 0 && entry->size <= BUF_CHUNK_SIZE) {
+        entry->body = buf_alloc((int)entry->size);
+        if (!entry->body || pread(fd, entry->body->data, entry->size, 0) != entry->size) {
+            buf_file_unref(&entry->file);
+            return NULL;
+        }
+    }
+    
+    return entry;
+}
+
+// 查找（必要时打开并缓存）文件，返回的项由调用方持有一个引用
+static static_file_t* static_file_get(const char *path) {
+    uint64_t now_ms = clock_now_ms();
+    
+    pthread_mutex_lock(&cache.lock);
+    static_file_t *entry = cache_find(path);
+    int fresh = 0;
+    if (entry) {
+        buf_file_ref(&entry->file);
+        lru_unlink(entry);
+        lru_push_front(entry);
+        fresh = now_ms - entry->checked_ms < STATIC_REVALIDATE_MS;
+        if (fresh) cache.hits++;
+    }
+    pthread_mutex_unlock(&cache.lock);
+    
+    if (fresh) return entry;
+    
+    if (entry) {
+        // 缓存项到了复查时间：文件没变就继续使用。
+        // 按打开时同样的规则解析路径（Linux 上 O_PATH 不读文件），期间换成指向根目录外的符号链接也能发现
+        struct stat st;
+        int fd = open_beneath(path, OPEN_LOOKUP);
+        int unchanged = fd >= 0 && fstat(fd, &st) == 0 && same_file(entry, &st);
+        if (fd >= 0) close(fd);
+        
+        pthread_mutex_lock(&cache.lock);
+        if (unchanged) {
+            entry->checked_ms = now_ms;
+            cache.hits++;
+        } else if (entry->cached) {
+            cache_remove(entry);
+        }
+        pthread_mutex_unlock(&cache.lock);
+        
+        if (unchanged) return entry;
+        buf_file_unref(&entry->file);
+    }
+    
+    entry = static_file_open(path, now_ms);
+    
+    pthread_mutex_lock(&cache.lock);
+    cache.misses++;
+    if (entry) {
+        // 其它线程可能同时打开了同一路径，以较新的为准
+        static_file_t *old = cache_find(path);
+        if (old) {
+            cache_remove(old);
+        }
+        buf_file_ref(&entry->file);
+        cache_insert(entry);
+    }
+    pthread_mutex_unlock(&cache.lock);
+    
+    return entry;
+}
+
+// 取出 /static/ 之后的相对路径：去掉查询串，拒绝空路径、".." 段、百分号编码和控制字符
+static int static_path(const request_t *req, char *out, int size) {
+    int prefix_len = (int)sizeof(STATIC_URL_PREFIX) - 1;
+    int len = 0;
+    
+    for (int i = prefix_len; i < req->path_len && req->path[i] != '?'; i++) {
+        char c = req->path[i];
+        if (c == '%' || c == '\\' || (unsigned char)c < 0x20 || len >= size - 1) return -1;
+        out[len++] = c;
+    }
+    out[len] = '\0';
+    
+    if (len == 0 || out[0] == '/') return -1;
+    
+    for (const char *seg = out; seg; ) {
+        const char *slash = strchr(seg, '/');
+        int seg_len = slash ? (int)(slash - seg) : (int)strlen(seg);
+        if ((seg_len == 2 && seg[0] == '.' && seg[1] == '.') || seg_len == 0) return -1;
+        seg = slash ? slash + 1 : NULL;
+    }
+    
+    return 0;
+}
+
+// 在请求头中查找 name
+static const char* find_header(const request_t *req, const char *name, int *value_len) {
+    return http_find_header(buf_slice_data(req->data), req->data->len, name, value_len);
+}
+
+// 解析单段 Range（bytes=a-b、bytes=a-、bytes=-n），end 为闭区间
+// 返回 1 表示有效区间；0 表示忽略（多段或格式不支持，按整个文件响应）；-1 表示无法满足
+static int parse_range(const char *value, int len, off_t size, off_t *start, off_t *end) {
+    char spec[64];
+    if (len <= 6 || len >= (int)sizeof(spec) || strncasecmp(value, "bytes=", 6) != 0) return 0;
+    memcpy(spec, value + 6, len - 6);
+    spec[len - 6] = '\0';
+    if (strchr(spec, ',')) return 0;
+    
+    char *dash = strchr(spec, '-');
+    if (!dash) return 0;
+    *dash = '\0';
+    
+    char *first_end, *last_end;
+    long long first = strtoll(spec, &first_end, 10);
+    long long last = strtoll(dash + 1, &last_end, 10);
+    int has_first = first_end != spec && *first_end == '\0';
+    int has_last = last_end != dash + 1 && *last_end == '\0';
+    if ((!has_first && spec[0]) || (!has_last && dash[1]) || first < 0 || last < 0) return 0;
+    
+    if (!has_first) {
+        // 最后 n 字节
+        if (!has_last) return 0;
+        if (last == 0 || size == 0) return -1;
+        *start = last < size ? size - last : 0;
+        *end = size - 1;
+        return 1;
+    }
+    
+    if (has_last && last < first) return 0;
+    if (first >= size) return -1;
+    
+    *start = first;
+    *end = has_last && last < size - 1 ? last : size - 1;
+    return 1;
+}
+
+// If-Modified-Since 不早于文件修改时间时返回 1
+static int not_modified(const request_t *req, const static_file_t *entry) {
+    int len;
+    const char *value = find_header(req, "If-Modified-Since", &len);
+    if (!value || len >= HTTP_DATE_SIZE) return 0;
+    
+    char date[HTTP_DATE_SIZE];
+    memcpy(date, value, len);
+    date[len] = '\0';
+    
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char *rest = strptime(date, HTTP_DATE_FORMAT, &tm);
+    if (!rest || *rest) return 0;
+    
+    return entry->mtime <= timegm(&tm);
+}
+
+// copy 模式：把正文 pread 到对象池缓冲区
+static int append_copy(buf_chain_t *resp, const static_file_t *entry, off_t off, off_t len) {
+    while (len > 0) {
+        buf_t *buf = buf_alloc(BUF_CHUNK_SIZE);
+        if (!buf) return -1;
+        
+        int want = len > BUF_CHUNK_SIZE ? BUF_CHUNK_SIZE : (int)len;
+        ssize_t n = pread(entry->file.fd, buf->data, want, off);
+        int ret = n > 0 ? buf_chain_append(resp, buf, 0, (int)n) : -1;
+        buf_unref(buf);
+        if (ret != 0) return -1;
+        
+        off += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int append_body(buf_chain_t *resp, static_file_t *entry, off_t off, off_t len) {
+    if (len == 0) return 0;
+    if (send_mode == STATIC_SEND_COPY) {
+        return append_copy(resp, entry, off, len);
+    }
+    if (entry->body) {
+        return buf_chain_append(resp, entry->body, (int)off, (int)len);
+    }
+    return buf_chain_append_file(resp, &entry->file, off, (size_t)len);
+}
+
+// GET/HEAD /static/<path>
+static int static_file_handler(const request_t *req, buf_chain_t *resp) {
+    const char *method = buf_slice_data(req->data);
+    int head_only = req->data->len >= 5 && memcmp(method, "HEAD ", 5) == 0;
+    if (!head_only && (req->data->len < 4 || memcmp(method, "GET ", 4) != 0)) {
+        return handler_append_status(resp, 405, NULL, 0, "Allow: GET, HEAD\r\n");
+    }
+    
+    char path[STATIC_PATH_MAX];
+    if (static_path(req, path, sizeof(path)) != 0) {
+        return handler_append_status(resp, 403, NULL, 0, NULL);
+    }
+    
+    static_file_t *entry = static_file_get(path);
+    if (!entry) {
+        return handler_append_status(resp, 404, NULL, 0, NULL);
+    }
+    
+    char extra[EXTRA_HEADERS_SIZE];
+    int extra_len = snprintf(extra, sizeof(extra), "Last-Modified: %s\r\nAccept-Ranges: bytes\r\n",
+                             entry->last_modified);
+    int ret;
+    
+    if (not_modified(req, entry)) {
+        ret = handler_append_status(resp, 304, NULL, -1, extra);
+        buf_file_unref(&entry->file);
+        return ret;
+    }
+    
+    off_t start = 0, end = entry->size - 1;
+    int status = 200;
+    int value_len;
+    const char *range = find_header(req, "Range", &value_len);
+    int range_ok = range ? parse_range(range, value_len, entry->size, &start, &end) : 0;
+    
+    if (range_ok < 0) {
+        snprintf(extra + extra_len, sizeof(extra) - extra_len, "Content-Range: bytes */%lld\r\n",
+                 (long long)entry->size);
+        ret = handler_append_status(resp, 416, NULL, 0, extra);
+        buf_file_unref(&entry->file);
+        return ret;
+    }
+    if (range_ok > 0) {
+        status = 206;
+        snprintf(extra + extra_len, sizeof(extra) - extra_len, "Content-Range: bytes %lld-%lld/%lld\r\n",
+                 (long long)start, (long long)end, (long long)entry->size);
+    }
+    
+    off_t len = end - start + 1;
+    ret = handler_append_status(resp, status, entry->content_type, (long)len, extra);
+    if (ret == 0 && !head_only) {
+        ret = append_body(resp, entry, start, len);
+    }
+    
+    buf_file_unref(&entry->file);
+    return ret;
+}
+
+int static_files_init(const char *root, static_send_mode_t mode) {
+    int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        log_error("Failed to open static root %s: %s", root, strerror(errno));
+        return -1;
+    }
+    
+    root_fd = fd;
+    send_mode = mode;
+    
+    // 打开文件、读小文件正文都可能阻塞在磁盘上，只在工作线程执行
+    return handler_register(STATIC_URL_PREFIX, static_file_handler, HANDLER_BLOCKING);
+}
+
+void static_files_cleanup(void) {
+    pthread_mutex_lock(&cache.lock);
+    while (cache.lru_head) {
+        cache_remove(cache.lru_head);
+    }
+    pthread_mutex_unlock(&cache.lock);
+    
+    if (root_fd >= 0) {
+        close(root_fd);
+        root_fd = -1;
+    }
+}
+
+void static_files_collect_metrics(void *arg, metrics_out_t *out) {
+    (void)arg;
+    
+    pthread_mutex_lock(&cache.lock);
+    long hits = cache.hits, misses = cache.misses, evictions = cache.evictions;
+    int count = cache.count;
+    pthread_mutex_unlock(&cache.lock);
+    
+    metrics_printf(out, "# HELP reactor_static_cache_hits_total Static file cache hits\n"
+                   "# TYPE reactor_static_cache_hits_total counter\n"
+                   "reactor_static_cache_hits_total %ld\n", hits);
+    metrics_printf(out, "# HELP reactor_static_cache_misses_total Static file opens\n"
+                   "# TYPE reactor_static_cache_misses_total counter\n"
+                   "reactor_static_cache_misses_total %ld\n", misses);
+    metrics_printf(out, "# HELP reactor_static_cache_evictions_total Static files evicted from the LRU\n"
+                   "# TYPE reactor_static_cache_evictions_total counter\n"
+                   "reactor_static_cache_evictions_total %ld\n", evictions);
+    metrics_printf(out, "# HELP reactor_static_cache_entries Open files in the static cache\n"
+                   "# TYPE reactor_static_cache_entries gauge\n"
+                   "reactor_static_cache_entries %d\n", count);
+}
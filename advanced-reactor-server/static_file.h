@@ -0,0 +1,31 @@
+// static_file.h
+#ifndef STATIC_FILE_H
+#define STATIC_FILE_H
+
+#include "metrics.h"
+
+// 静态文件服务
+//
+// GET/HEAD /static/<path> 返回根目录下的普通文件。打开的 fd 和元数据缓存在按路径索引的 LRU 中
+// （最多 STATIC_CACHE_MAX 项），命中时不再 open/fstat，每 STATIC_REVALIDATE_MS 用 fstatat
+// 确认一次文件没有变化。不超过 BUF_CHUNK_SIZE 的文件正文也缓存在内存里，和响应头一起 writev；
+// 更大的文件以文件片段挂到响应链上，由写出方 sendfile，正文不复制到用户态。
+// 支持单段 Range（206 / 416）和 If-Modified-Since（304）。
+
+#define STATIC_URL_PREFIX "/static/"
+
+typedef enum {
+    STATIC_SEND_SENDFILE,   // 小文件走内存缓存，其余 sendfile
+    STATIC_SEND_COPY        // 每次请求把正文 pread 到缓冲区再 writev（用于对比）
+} static_send_mode_t;
+
+// 以 root 为根目录注册 /static/ 处理函数，成功返回 0
+int static_files_init(const char *root, static_send_mode_t mode);
+
+// 释放缓存（所有连接释放之后调用；仍被响应引用的文件在引用释放时关闭）
+void static_files_cleanup(void);
+
+// /metrics 收集函数：缓存命中、未命中、淘汰次数和缓存项数
+void static_files_collect_metrics(void *arg, metrics_out_t *out);
+
+#endif // STATIC_FILE_H
@@ -1,16 +1,57 @@
 // task_queue.c
 #include "task_queue.h"
 #include "common.h"
+#include "object_pool.h"
+
+// 无锁队列进入休眠前的自旋次数
+#define LOCKFREE_SPIN_LIMIT 256
+
+// 每个线程的任务对象池预分配数
+#define TASK_POOL_PREFILL 64
+
+// 创建任务的线程（通常是 IO 线程）的任务对象池，工作线程销毁任务时远程归还
+static __thread object_pool_t *tls_task_pool;
 
 task_queue_t* task_queue_create(int max_size) {
+    return task_queue_create_kind(max_size, TASK_QUEUE_MUTEX);
+}
+
+task_queue_t* task_queue_create_kind(int max_size, task_queue_kind_t kind) {
+    if (max_size <= 0) return NULL;
+    
     task_queue_t *queue = (task_queue_t*)malloc(sizeof(task_queue_t));
     if (!queue) return NULL;
     
+    queue->kind = kind;
+    queue->cells = NULL;
+    queue->mask = 0;
+    atomic_init(&queue->idle_consumers, 0);
+    atomic_init(&queue->idle_producers, 0);
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+    
+    if (kind == TASK_QUEUE_LOCKFREE) {
+        size_t capacity = 2;
+        while (capacity < (size_t)max_size) capacity <<= 1;
+        
+        queue->cells = (task_queue_cell_t*)malloc(sizeof(task_queue_cell_t) * capacity);
+        if (!queue->cells) {
+            free(queue);
+            return NULL;
+        }
+        for (size_t i = 0; i < capacity; i++) {
+            atomic_init(&queue->cells[i].sequence, i);
+            queue->cells[i].task = NULL;
+        }
+        queue->mask = capacity - 1;
+        max_size = (int)capacity;
+    }
+    
     queue->head = NULL;
     queue->tail = NULL;
     queue->size = 0;
     queue->max_size = max_size;
-    queue->shutdown = 0;
+    atomic_init(&queue->shutdown, 0);
     
     pthread_mutex_init(&queue->mutex, NULL);
     pthread_cond_init(&queue->not_empty, NULL);
@@ -19,9 +60,141 @@ task_queue_t* task_queue_create(int max_size) {
     return queue;
 }
 
+// 无锁入队，队列满返回 -1
+static int lockfree_try_push(task_queue_t *queue, task_t *task) {
+    size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    
+    for (;;) {
+        task_queue_cell_t *cell = &queue->cells[pos & queue->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->task = task;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                return 0;
+            }
+        } else if (diff < 0) {
+            return -1;  // 满
+        } else {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// 无锁出队，队列空返回 NULL
+static task_t* lockfree_try_pop(task_queue_t *queue) {
+    size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    
+    for (;;) {
+        task_queue_cell_t *cell = &queue->cells[pos & queue->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                task_t *task = cell->task;
+                atomic_store_explicit(&cell->sequence, pos + queue->mask + 1,
+                                      memory_order_release);
+                return task;
+            }
+        } else if (diff < 0) {
+            return NULL;  // 空
+        } else {
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// 有线程在 cond 上休眠时才进入内核唤醒
+static void lockfree_wake(task_queue_t *queue, atomic_int *idle, pthread_cond_t *cond) {
+    // 与休眠方的 "登记 idle -> 重新检查队列" 配对，避免丢失唤醒
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(idle, memory_order_relaxed) > 0) {
+        pthread_mutex_lock(&queue->mutex);
+        pthread_cond_signal(cond);
+        pthread_mutex_unlock(&queue->mutex);
+    }
+}
+
+static int lockfree_push(task_queue_t *queue, task_t *task) {
+    if (atomic_load(&queue->shutdown)) return -1;
+    
+    int spins = 0;
+    while (lockfree_try_push(queue, task) != 0) {
+        if (atomic_load(&queue->shutdown)) return -1;
+        
+        if (spins++ < LOCKFREE_SPIN_LIMIT) {
+            cpu_relax();
+            continue;
+        }
+        
+        // 队列持续满：休眠等待消费者
+        int pushed = 0;
+        pthread_mutex_lock(&queue->mutex);
+        atomic_fetch_add(&queue->idle_producers, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        while (!atomic_load(&queue->shutdown) &&
+               !(pushed = (lockfree_try_push(queue, task) == 0))) {
+            pthread_cond_wait(&queue->not_full, &queue->mutex);
+        }
+        atomic_fetch_sub(&queue->idle_producers, 1);
+        pthread_mutex_unlock(&queue->mutex);
+        
+        if (!pushed) return -1;
+        break;
+    }
+    
+    lockfree_wake(queue, &queue->idle_consumers, &queue->not_empty);
+    return 0;
+}
+
+static task_t* lockfree_pop(task_queue_t *queue) {
+    int spins = 0;
+    task_t *task;
+    
+    while (!(task = lockfree_try_pop(queue))) {
+        if (atomic_load(&queue->shutdown)) return NULL;
+        
+        if (spins++ < LOCKFREE_SPIN_LIMIT) {
+            cpu_relax();
+            continue;
+        }
+        
+        // 队列持续为空：休眠等待生产者
+        pthread_mutex_lock(&queue->mutex);
+        atomic_fetch_add(&queue->idle_consumers, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        while (!atomic_load(&queue->shutdown) && !(task = lockfree_try_pop(queue))) {
+            pthread_cond_wait(&queue->not_empty, &queue->mutex);
+        }
+        atomic_fetch_sub(&queue->idle_consumers, 1);
+        pthread_mutex_unlock(&queue->mutex);
+        
+        if (!task) return NULL;
+        break;
+    }
+    
+    lockfree_wake(queue, &queue->idle_producers, &queue->not_full);
+    return task;
+}
+
 void task_queue_destroy(task_queue_t *queue) {
     if (!queue) return;
     
+    if (queue->kind == TASK_QUEUE_LOCKFREE) {
+        task_t *task;
+        while ((task = lockfree_try_pop(queue))) {
+            task_destroy(task);
+        }
+        free(queue->cells);
+    }
+    
     pthread_mutex_lock(&queue->mutex);
     
     // 清理所有未处理的任务
@@ -41,9 +214,28 @@ void task_queue_destroy(task_queue_t *queue) {
     free(queue);
 }
 
+// 添加任务到队尾并通知等待的消费者（调用方持有 mutex）
+static void mutex_append(task_queue_t *queue, task_t *task) {
+    task->next = NULL;
+    if (queue->tail) {
+        queue->tail->next = task;
+        queue->tail = task;
+    } else {
+        queue->head = queue->tail = task;
+    }
+    
+    queue->size++;
+    
+    pthread_cond_signal(&queue->not_empty);
+}
+
 int task_queue_push(task_queue_t *queue, task_t *task) {
     if (!queue || !task) return -1;
     
+    if (queue->kind == TASK_QUEUE_LOCKFREE) {
+        return lockfree_push(queue, task);
+    }
+    
     pthread_mutex_lock(&queue->mutex);
     
     // 等待队列不满
@@ -56,19 +248,30 @@ int task_queue_push(task_queue_t *queue, task_t *task) {
         return -1;
     }
     
-    // 添加任务到队尾
-    task->next = NULL;
-    if (queue->tail) {
-        queue->tail->next = task;
-        queue->tail = task;
-    } else {
-        queue->head = queue->tail = task;
+    mutex_append(queue, task);
+    
+    pthread_mutex_unlock(&queue->mutex);
+    
+    return 0;
+}
+
+int task_queue_try_push(task_queue_t *queue, task_t *task) {
+    if (!queue || !task) return -1;
+    
+    if (queue->kind == TASK_QUEUE_LOCKFREE) {
+        if (atomic_load(&queue->shutdown) || lockfree_try_push(queue, task) != 0) return -1;
+        lockfree_wake(queue, &queue->idle_consumers, &queue->not_empty);
+        return 0;
     }
     
-    queue->size++;
+    pthread_mutex_lock(&queue->mutex);
     
-    // 通知等待的消费者
-    pthread_cond_signal(&queue->not_empty);
+    if (queue->shutdown || queue->size >= queue->max_size) {
+        pthread_mutex_unlock(&queue->mutex);
+        return -1;
+    }
+    
+    mutex_append(queue, task);
     
     pthread_mutex_unlock(&queue->mutex);
     
@@ -78,6 +281,10 @@ int task_queue_push(task_queue_t *queue, task_t *task) {
 task_t* task_queue_pop(task_queue_t *queue) {
     if (!queue) return NULL;
     
+    if (queue->kind == TASK_QUEUE_LOCKFREE) {
+        return lockfree_pop(queue);
+    }
+    
     pthread_mutex_lock(&queue->mutex);
     
     // 等待队列非空
@@ -109,48 +316,98 @@ task_t* task_queue_pop(task_queue_t *queue) {
     return task;
 }
 
-task_t* task_create(task_type_t type, connection_t *conn, void *data, int data_len) {
-    task_t *task = (task_t*)malloc(sizeof(task_t));
+task_t* task_queue_try_pop(task_queue_t *queue) {
+    if (!queue) return NULL;
+    
+    if (queue->kind == TASK_QUEUE_LOCKFREE) {
+        task_t *task = lockfree_try_pop(queue);
+        if (task) {
+            lockfree_wake(queue, &queue->idle_producers, &queue->not_full);
+        }
+        return task;
+    }
+    
+    pthread_mutex_lock(&queue->mutex);
+    
+    task_t *task = queue->head;
+    if (task) {
+        queue->head = task->next;
+        if (!queue->head) {
+            queue->tail = NULL;
+        }
+        queue->size--;
+        task->next = NULL;
+        
+        pthread_cond_signal(&queue->not_full);
+    }
+    
+    pthread_mutex_unlock(&queue->mutex);
+    
+    return task;
+}
+
+task_t* task_create(task_type_t type, connection_t *conn, const buf_slice_t *data) {
+    object_pool_t *pool = object_pool_thread_local(&tls_task_pool, "task",
+                                                   sizeof(task_t), TASK_POOL_PREFILL);
+    task_t *task = (task_t*)object_pool_alloc(pool);
     if (!task) return NULL;
     
     task->type = type;
     task->conn = conn;
+    task->seq = 0;
+    task->start_ns = 0;
     task->next = NULL;
     
+    // 只增加缓冲区引用，不复制数据
+    if (data && data->buf && data->len > 0) {
+        task->data.buf = buf_ref(data->buf);
+        task->data.off = data->off;
+        task->data.len = data->len;
+    } else {
+        task->data.buf = NULL;
+        task->data.off = 0;
+        task->data.len = 0;
+    }
+    
     // 增加连接引用计数
     if (conn) {
         conn_acquire(conn);
     }
     
-    if (data && data_len > 0) {
-        task->data = malloc(data_len);
-        if (task->data) {
-            memcpy(task->data, data, data_len);
-            task->data_len = data_len;
-        } else {
-            free(task);
-            return NULL;
-        }
-    } else {
-        task->data = NULL;
-        task->data_len = 0;
-    }
-    
     return task;
 }
 
 void task_destroy(task_t *task) {
     if (!task) return;
     
+    // 执行器内嵌在连接中：只释放尚未执行的任务
+    // 这些任务各自持有连接引用，先全部取出再释放，避免连接在遍历中途被释放
+    if (task->type == TASK_TYPE_SERIAL) {
+        task_t *pending = NULL;
+        mpsc_node_t *node;
+        while ((node = mpsc_queue_pop(&task->conn->tasks))) {
+            task_t *t = mpsc_container_of(node, task_t, node);
+            t->next = pending;
+            pending = t;
+        }
+        // 执行器不会再运行：清零计数，之后的投递方能重新调度执行器。
+        // 必须在释放任务之前完成，释放最后一个任务可能连带释放连接
+        atomic_store_explicit(&task->conn->task_pending, 0, memory_order_release);
+        while (pending) {
+            task_t *next = pending->next;
+            task_destroy(pending);
+            pending = next;
+        }
+        return;
+    }
+    
     // 释放连接引用
     if (task->conn) {
         conn_release(task->conn);
     }
     
-    if (task->data) {
-        free(task->data);
-    }
-    free(task);
+    buf_unref(task->data.buf);
+    object_pool_free(task);
 }
 
 void task_queue_shutdown(task_queue_t *queue) {
@@ -161,4 +418,21 @@ void task_queue_shutdown(task_queue_t *queue) {
     pthread_cond_broadcast(&queue->not_empty);
     pthread_cond_broadcast(&queue->not_full);
     pthread_mutex_unlock(&queue->mutex);
+}
+
+int task_queue_kind_parse(const char *name, task_queue_kind_t *kind) {
+    if (!name || !kind) return -1;
+    
+    if (strcmp(name, "mutex") == 0) {
+        *kind = TASK_QUEUE_MUTEX;
+    } else if (strcmp(name, "lockfree") == 0) {
+        *kind = TASK_QUEUE_LOCKFREE;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* task_queue_kind_name(task_queue_kind_t kind) {
+    return kind == TASK_QUEUE_LOCKFREE ? "lockfree" : "mutex";
 }
\ No newline at end of file
@@ -2,33 +2,71 @@
 #ifndef TASK_QUEUE_H
 #define TASK_QUEUE_H
 
+#include <stdatomic.h>
 #include "common.h"
 
+// 队列实现
+typedef enum {
+    TASK_QUEUE_MUTEX,      // 链表 + 互斥锁 + 条件变量
+    TASK_QUEUE_LOCKFREE    // 有界无锁环形队列（Vyukov MPMC），先自旋后休眠
+} task_queue_kind_t;
+
+// 无锁环形队列的槽位
+typedef struct task_queue_cell {
+    atomic_size_t sequence;
+    task_t *task;
+} task_queue_cell_t;
+
 typedef struct task_queue {
+    task_queue_kind_t kind;
+    
+    // TASK_QUEUE_MUTEX
     task_t *head;
     task_t *tail;
     int size;
     int max_size;
+    
+    // 两种实现共用：互斥队列的锁，以及无锁队列的休眠/唤醒
     pthread_mutex_t mutex;
     pthread_cond_t not_empty;
     pthread_cond_t not_full;
-    int shutdown;
+    atomic_int shutdown;
+    
+    // TASK_QUEUE_LOCKFREE（生产者/消费者位置各占一条缓存行）
+    task_queue_cell_t *cells;
+    size_t mask;
+    atomic_int idle_consumers;
+    atomic_int idle_producers;
+    char pad0[CACHE_LINE_SIZE];
+    atomic_size_t enqueue_pos;
+    char pad1[CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+    atomic_size_t dequeue_pos;
+    char pad2[CACHE_LINE_SIZE - sizeof(atomic_size_t)];
 } task_queue_t;
 
 // 创建任务队列
 task_queue_t* task_queue_create(int max_size);
 
+// 创建指定实现的任务队列（无锁队列容量向上取整到 2 的幂）
+task_queue_t* task_queue_create_kind(int max_size, task_queue_kind_t kind);
+
 // 销毁任务队列
 void task_queue_destroy(task_queue_t *queue);
 
 // 添加任务（生产者）
 int task_queue_push(task_queue_t *queue, task_t *task);
 
+// 非阻塞添加任务，队列满或已关闭时返回 -1
+int task_queue_try_push(task_queue_t *queue, task_t *task);
+
 // 获取任务（消费者）
 task_t* task_queue_pop(task_queue_t *queue);
 
+// 非阻塞获取任务，队列为空时返回 NULL
+task_t* task_queue_try_pop(task_queue_t *queue);
+
 // 创建任务
-task_t* task_create(task_type_t type, connection_t *conn, void *data, int data_len);
+task_t* task_create(task_type_t type, connection_t *conn, const buf_slice_t *data);
 
 // 销毁任务
 void task_destroy(task_t *task);
@@ -36,4 +74,10 @@ void task_destroy(task_t *task);
 // 设置队列为关闭状态
 void task_queue_shutdown(task_queue_t *queue);
 
+// 解析队列实现名称（"mutex" / "lockfree"），失败返回 -1
+int task_queue_kind_parse(const char *name, task_queue_kind_t *kind);
+
+// 队列实现名称
+const char* task_queue_kind_name(task_queue_kind_t kind);
+
 #endif // TASK_QUEUE_H
@@ -1,195 +1,946 @@
+// test_client.c
+// HTTP 压测客户端：threads 个线程各用一个 epoll 驱动一组长连接（keep-alive），
+// 每个连接最多 pipeline 个请求在途。
+//
+// 两种模式：
+// - 闭环（默认，--rate 0）：每个响应回来立即补发一个请求，测最大吞吐；
+//   延迟从请求实际发出时算起。
+// - 开环（--rate N）：按所有连接合计每秒 N 个请求的固定时间表发送，不等服务器跟上。
+//   延迟从请求按时间表应该发出的时刻算起（修正 coordinated omission）：服务器卡顿时，
+//   本该在卡顿期间发出的请求都会把等待时间计入延迟，而不是像闭环那样只记一个慢请求。
+//   连接的在途请求已满时，到期的请求推迟到有空位时发出，推迟的时间同样计入延迟。
+//   另外给出从实际发出时算起的延迟作对比。
+//
+// 延迟记入 HDR 直方图（3 位有效数字，对数分段、段内线性分桶，内存固定），
+// 结果以 JSON 输出到 stdout，人类可读的摘要输出到 stderr。
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <getopt.h>
 #include <pthread.h>
+#include <netdb.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
-#include <arpa/inet.h>
-#include <time.h>
-#include <errno.h>
 
-#define SERVER_IP "127.0.0.1"
-#define SERVER_PORT 8080
-#define NUM_THREADS 10
-#define REQUESTS_PER_THREAD 100
-
-typedef struct {
-    int thread_id;
-    int successful_requests;
-    int failed_requests;
-    int connect_failures;
-    int send_failures;
-    int recv_failures;
-    double total_time;
-} thread_data_t;
-
-void* client_thread(void* arg) {
-    thread_data_t* data = (thread_data_t*)arg;
-    
-    for (int i = 0; i < REQUESTS_PER_THREAD; i++) {
-        struct timespec start, end;
-        clock_gettime(CLOCK_MONOTONIC, &start);
-        
-        // 创建套接字
-        int sock = socket(AF_INET, SOCK_STREAM, 0);
-        if (sock < 0) {
-            data->failed_requests++;
+#define DEFAULT_HOST     "127.0.0.1"
+#define DEFAULT_PORT     "8080"
+#define DEFAULT_THREADS  2
+#define DEFAULT_CONNS    16
+#define DEFAULT_SECONDS  10
+#define DEFAULT_PIPELINE 1
+#define DEFAULT_METHOD   "GET"
+#define DEFAULT_PATH     "/"
+
+#define PIPELINE_MAX 1024
+#define REQUEST_MAX  (64 * 1024)
+#define HEADER_MAX   8192
+#define READ_SIZE    (64 * 1024)
+#define MAX_EVENTS   256
+
+// 连接失败后隔多久重连（服务器关闭连接时立即重连）
+#define RECONNECT_NS 100000000LL
+
+// HDR 直方图：2048 个子桶（3 位有效数字），记录纳秒，超过上限的值按上限记
+#define HIST_SUB_BITS   11
+#define HIST_HALF_BITS  (HIST_SUB_BITS - 1)
+#define HIST_HALF_COUNT (1 << HIST_HALF_BITS)
+#define HIST_MAX_VALUE  3600000000000LL    // 1 小时
+
+typedef struct hist {
+    int64_t *counts;
+    int len;
+    int64_t total;
+    int64_t min;
+    int64_t max;
+    double sum;
+} hist_t;
+
+typedef enum { CONN_CLOSED, CONN_CONNECTING, CONN_OPEN } conn_state_t;
+
+typedef struct client_conn {
+    int fd;
+    conn_state_t state;
+    int index;              // 在本线程连接中的序号，开环时决定发送时刻
+    int64_t retry_at;       // CLOSED 状态下的重连时刻
+    
+    // 在途请求（环形队列，按发送顺序）：计划发送时刻和实际发送时刻
+    int64_t *intended;
+    int64_t *sent;
+    int head;
+    int inflight;
+    int64_t next_seq;       // 开环：本连接下一个要发送的请求序号
+    
+    // 尚未写出的请求字节
+    char *out;
+    int out_len;
+    int out_off;
+    int want_write;
+    
+    // 响应解析：先收集响应头，再按 Content-Length 跳过正文
+    char header[HEADER_MAX];
+    int header_len;
+    long body_left;         // -1 表示正在读响应头
+    int status;
+    int close_after;        // 服务器在这个响应之后关闭连接
+} client_conn_t;
+
+typedef struct client_thread {
+    pthread_t tid;
+    int index;
+    int epfd;
+    int timerfd;
+    int64_t armed;          // timerfd 当前设置的到期时刻
+    char *buf;
+    
+    client_conn_t *conns;
+    int conn_count;
+    int closed;             // 等待重连的连接数
+    int64_t retry_at;       // 其中最早的重连时刻
+    
+    // 开环：本线程的请求按 phase + k * interval 的时刻轮流分给各连接
+    double interval;
+    double phase;
+    int64_t next_tick;
+    
+    // 统计（预热结束后）
+    hist_t latency;
+    hist_t uncorrected;
+    long completed;
+    long status[6];
+    long long bytes;
+    long err_connect;
+    long err_read;
+    long err_write;
+    long err_parse;
+    long err_closed;        // 连接关闭时丢失的在途请求
+} client_thread_t;
+
+static struct sockaddr_storage server_addr;
+static socklen_t server_addr_len;
+static char *request;
+static int request_len;
+static int head_request;
+static int pipeline = DEFAULT_PIPELINE;
+static double rate;
+static int64_t start_ns;
+static int64_t record_ns;   // 预热结束时刻，之后完成的响应才计入统计
+static int64_t end_ns;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// ---- HDR 直方图 ----
+// 值 v 落在段 b = floor(log2(v | 2047)) - 10，段内按 v >> b 线性分桶：
+// 段 0 是 [0, 2048) 的精确值，之后每段覆盖 [1024 << b, 2048 << b)，相对误差不超过 1/1024
+
+static int hist_index(int64_t v) {
+    int bucket = 63 - __builtin_clzll((uint64_t)v | ((1 << HIST_SUB_BITS) - 1)) - HIST_HALF_BITS;
+    int sub = (int)(v >> bucket);
+    return ((bucket + 1) << HIST_HALF_BITS) + sub - HIST_HALF_COUNT;
+}
+
+// 下标对应区间内的最大值
+static int64_t hist_value_at(int index) {
+    int bucket = (index >> HIST_HALF_BITS) - 1;
+    int64_t sub = (index & (HIST_HALF_COUNT - 1)) + HIST_HALF_COUNT;
+    if (bucket < 0) {
+        return index;
+    }
+    return (sub << bucket) + (1LL << bucket) - 1;
+}
+
+static int hist_init(hist_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->len = hist_index(HIST_MAX_VALUE) + 1;
+    h->counts = calloc(h->len, sizeof(int64_t));
+    h->min = INT64_MAX;
+    return h->counts ? 0 : -1;
+}
+
+static void hist_record(hist_t *h, int64_t v) {
+    if (v < 0) v = 0;
+    if (v > HIST_MAX_VALUE) v = HIST_MAX_VALUE;
+    h->counts[hist_index(v)]++;
+    h->total++;
+    h->sum += (double)v;
+    if (v < h->min) h->min = v;
+    if (v > h->max) h->max = v;
+}
+
+static void hist_merge(hist_t *dst, const hist_t *src) {
+    for (int i = 0; i < dst->len; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+static int64_t hist_percentile(const hist_t *h, double p) {
+    if (h->total == 0) return 0;
+    int64_t target = (int64_t)(p / 100.0 * h->total + 0.5);
+    if (target < 1) target = 1;
+    
+    int64_t seen = 0;
+    for (int i = 0; i < h->len; i++) {
+        seen += h->counts[i];
+        if (seen >= target) {
+            int64_t v = hist_value_at(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+// ---- 连接 ----
+
+static void conn_schedule_retry(client_thread_t *t, client_conn_t *c, int64_t at) {
+    c->state = CONN_CLOSED;
+    c->retry_at = at;
+    if (t->closed == 0 || at < t->retry_at) {
+        t->retry_at = at;
+    }
+    t->closed++;
+}
+
+static void conn_close(client_thread_t *t, client_conn_t *c, int64_t now) {
+    close(c->fd);
+    c->fd = -1;
+    t->err_closed += c->inflight;
+    c->head = 0;
+    c->inflight = 0;
+    c->out_len = 0;
+    c->out_off = 0;
+    c->want_write = 0;
+    c->header_len = 0;
+    c->body_left = -1;
+    c->close_after = 0;
+    conn_schedule_retry(t, c, now);
+}
+
+static void conn_watch_write(client_thread_t *t, client_conn_t *c, int on) {
+    if (c->want_write == on) return;
+    c->want_write = on;
+    struct epoll_event ev = { .events = EPOLLIN | (on ? EPOLLOUT : 0), .data.ptr = c };
+    epoll_ctl(t->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+// 写出缓冲的请求，成功（含部分写出）返回 0
+static int conn_flush(client_thread_t *t, client_conn_t *c, int64_t now) {
+    while (c->out_off < c->out_len) {
+        ssize_t n = write(c->fd, c->out + c->out_off, c->out_len - c->out_off);
+        if (n > 0) {
+            c->out_off += (int)n;
+        } else if (n < 0 && errno == EINTR) {
             continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            conn_watch_write(t, c, 1);
+            return 0;
+        } else {
+            t->err_write++;
+            conn_close(t, c, now);
+            return -1;
+        }
+    }
+    c->out_len = 0;
+    c->out_off = 0;
+    conn_watch_write(t, c, 0);
+    return 0;
+}
+
+static int64_t tick_time(const client_thread_t *t, int64_t k) {
+    return start_ns + (int64_t)(t->phase + k * t->interval);
+}
+
+// 把到期的请求放进在途队列并写出：闭环时填满 pipeline，开环时发出所有计划时刻已到的请求
+static void conn_fill(client_thread_t *t, client_conn_t *c, int64_t now) {
+    if (c->state != CONN_OPEN || c->inflight >= pipeline) return;
+    
+    if (c->out_off > 0) {
+        memmove(c->out, c->out + c->out_off, c->out_len - c->out_off);
+        c->out_len -= c->out_off;
+        c->out_off = 0;
+    }
+    
+    int queued = 0;
+    while (c->inflight < pipeline) {
+        int64_t intended = now;
+        if (rate > 0) {
+            intended = tick_time(t, c->index + c->next_seq * t->conn_count);
+            if (intended > now || intended >= end_ns) break;
+            c->next_seq++;
         }
         
-        // 连接服务器
-        struct sockaddr_in server_addr;
-        memset(&server_addr, 0, sizeof(server_addr));
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_port = htons(SERVER_PORT);
-        inet_pton(AF_INET, SERVER_IP, &server_addr.sin_addr);
-        
-        if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-            data->failed_requests++;
-            data->connect_failures++;
-            close(sock);
-            usleep(1000); // 1ms延迟后重试避免连接风暴
-            continue;
+        int slot = (c->head + c->inflight) % pipeline;
+        c->intended[slot] = intended;
+        c->sent[slot] = now;
+        c->inflight++;
+        memcpy(c->out + c->out_len, request, request_len);
+        c->out_len += request_len;
+        queued++;
+    }
+    
+    if (queued > 0) {
+        conn_flush(t, c, now);
+    }
+}
+
+static void conn_open(client_thread_t *t, client_conn_t *c, int64_t now) {
+    c->fd = socket(server_addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c->fd < 0) {
+        t->err_connect++;
+        conn_schedule_retry(t, c, now + RECONNECT_NS);
+        return;
+    }
+    
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    
+    if (connect(c->fd, (struct sockaddr*)&server_addr, server_addr_len) == 0) {
+        c->state = CONN_OPEN;
+    } else if (errno == EINPROGRESS) {
+        c->state = CONN_CONNECTING;
+    } else {
+        t->err_connect++;
+        close(c->fd);
+        c->fd = -1;
+        conn_schedule_retry(t, c, now + RECONNECT_NS);
+        return;
+    }
+    
+    // 连接中等待可写事件得知结果
+    c->want_write = c->state == CONN_CONNECTING;
+    struct epoll_event ev = { .events = EPOLLIN | (c->want_write ? EPOLLOUT : 0), .data.ptr = c };
+    epoll_ctl(t->epfd, EPOLL_CTL_ADD, c->fd, &ev);
+    
+    conn_fill(t, c, now);
+}
+
+static void conn_connected(client_thread_t *t, client_conn_t *c, int64_t now) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+        t->err_connect++;
+        close(c->fd);
+        c->fd = -1;
+        conn_schedule_retry(t, c, now + RECONNECT_NS);
+        return;
+    }
+    
+    c->state = CONN_OPEN;
+    conn_watch_write(t, c, 0);
+    conn_fill(t, c, now);
+}
+
+// ---- 响应解析 ----
+
+// 查找响应头字段，返回值的起始位置（跳过前导空白）
+static const char* find_header(const char *header, const char *name) {
+    size_t len = strlen(name);
+    const char *line = strstr(header, "\r\n");
+    
+    while (line && line[2] != '\r') {
+        line += 2;
+        if (strncasecmp(line, name, len) == 0 && line[len] == ':') {
+            const char *value = line + len + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            return value;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return NULL;
+}
+
+// 解析完整的响应头，设置 status、body_left；1xx 临时响应返回 1，格式错误返回 -1
+static int parse_response_header(client_conn_t *c) {
+    if (c->header_len < 12 || strncmp(c->header, "HTTP/1.", 7) != 0) return -1;
+    
+    int status = atoi(c->header + 9);
+    if (status < 100 || status > 599) return -1;
+    if (status < 200) return 1;
+    
+    // 不支持 chunked 和读到关闭为止的响应
+    if (find_header(c->header, "Transfer-Encoding")) return -1;
+    const char *cl = find_header(c->header, "Content-Length");
+    if (head_request || status == 204 || status == 304) {
+        c->body_left = 0;
+    } else if (cl) {
+        c->body_left = atol(cl);
+    } else {
+        return -1;
+    }
+    
+    // HTTP/1.0 默认不保持连接
+    const char *connection = find_header(c->header, "Connection");
+    if (connection ? strncasecmp(connection, "close", 5) == 0 : c->header[7] == '0') {
+        c->close_after = 1;
+    }
+    c->status = status;
+    return 0;
+}
+
+static int response_done(client_thread_t *t, client_conn_t *c, int64_t now) {
+    if (c->inflight == 0) return -1;
+    
+    int slot = c->head;
+    c->head = (c->head + 1) % pipeline;
+    c->inflight--;
+    
+    if (now >= record_ns) {
+        hist_record(&t->latency, now - c->intended[slot]);
+        hist_record(&t->uncorrected, now - c->sent[slot]);
+        t->completed++;
+        t->status[c->status / 100]++;
+    }
+    return 0;
+}
+
+// 消费读到的数据，格式错误返回 -1
+static int conn_consume(client_thread_t *t, client_conn_t *c, const char *data, long len, int64_t now) {
+    while (len > 0) {
+        if (c->body_left < 0) {
+            int old = c->header_len;
+            long room = HEADER_MAX - 1 - old;
+            long take = len < room ? len : room;
+            memcpy(c->header + old, data, take);
+            c->header_len += (int)take;
+            c->header[c->header_len] = '\0';
+            
+            char *end = strstr(c->header + (old > 3 ? old - 3 : 0), "\r\n\r\n");
+            if (!end) {
+                if (c->header_len >= HEADER_MAX - 1) return -1;
+                return 0;
+            }
+            
+            // 响应头之后的字节留给正文或下一个响应
+            int used = (int)(end + 4 - c->header);
+            data += used - old;
+            len -= used - old;
+            c->header_len = used;
+            c->header[used] = '\0';
+            
+            int rc = parse_response_header(c);
+            c->header_len = 0;
+            if (rc < 0) return -1;
+            if (rc > 0) continue;
         }
         
-        // 发送 HTTP 请求
-        const char* request = "GET / HTTP/1.1\r\n"
-                             "Host: localhost\r\n"
-                             "Connection: keep-alive\r\n"
-                             "\r\n";
+        long take = len < c->body_left ? len : c->body_left;
+        data += take;
+        len -= take;
+        c->body_left -= take;
         
-        if (send(sock, request, strlen(request), 0) < 0) {
-            data->failed_requests++;
-            data->send_failures++;
-            close(sock);
-            usleep(500); // 0.5ms延迟
+        if (c->body_left == 0) {
+            c->body_left = -1;
+            if (response_done(t, c, now) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+static void conn_read(client_thread_t *t, client_conn_t *c, int64_t now) {
+    while (1) {
+        ssize_t r = read(c->fd, t->buf, READ_SIZE);
+        if (r > 0) {
+            if (now >= record_ns) t->bytes += r;
+            if (conn_consume(t, c, t->buf, r, now) != 0) {
+                t->err_parse++;
+                conn_close(t, c, now);
+                return;
+            }
+            // 水平触发，没读满说明暂时读完了，省掉一次返回 EAGAIN 的 read
+            if (r < READ_SIZE) break;
+        } else if (r == 0) {
+            conn_close(t, c, now);
+            return;
+        } else if (errno == EINTR) {
             continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            t->err_read++;
+            conn_close(t, c, now);
+            return;
         }
-        
-        // 设置接收超时
-        struct timeval timeout;
-        timeout.tv_sec = 1;  // 1秒超时
-        timeout.tv_usec = 0;
-        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-        
-        // 设置TCP_NODELAY以减少延迟
-        int flag = 1;
-        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
-        
-        // 设置发送超时
-        struct timeval send_timeout;
-        send_timeout.tv_sec = 1;
-        send_timeout.tv_usec = 0;
-        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
-        
-        // 接收响应（带快速重试）
-        char buffer[4096];
-        int n = recv(sock, buffer, sizeof(buffer) - 1, 0);
-        
-        // 如果首次接收失败，快速重试一次（不额外等待）
-        if (n <= 0) {
-            n = recv(sock, buffer, sizeof(buffer) - 1, 0);
+    }
+    
+    // 服务器要关闭连接：等这个响应读完再关，期间不再发新请求
+    if (c->close_after) {
+        if (c->body_left < 0) conn_close(t, c, now);
+        return;
+    }
+    conn_fill(t, c, now);
+}
+
+// ---- 线程主循环 ----
+
+static void reopen_connections(client_thread_t *t, int64_t now) {
+    t->closed = 0;
+    for (int i = 0; i < t->conn_count; i++) {
+        client_conn_t *c = &t->conns[i];
+        if (c->state != CONN_CLOSED) continue;
+        if (c->retry_at <= now) {
+            conn_open(t, c, now);
+        } else {
+            conn_schedule_retry(t, c, c->retry_at);
         }
+    }
+}
+
+// 设置下一次需要醒来的时刻，已经到期返回 0（不阻塞），否则返回 -1（阻塞到事件或定时器）
+static int arm_timer(client_thread_t *t, int64_t now) {
+    int64_t next = end_ns;
+    if (rate > 0) {
+        int64_t due = tick_time(t, t->next_tick);
+        if (due < next) next = due;
+    }
+    if (t->closed > 0 && t->retry_at < next) {
+        next = t->retry_at;
+    }
+    
+    if (next <= now) return 0;
+    if (next != t->armed) {
+        struct itimerspec its = { { 0, 0 }, { next / 1000000000LL, next % 1000000000LL } };
+        timerfd_settime(t->timerfd, TFD_TIMER_ABSTIME, &its, NULL);
+        t->armed = next;
+    }
+    return -1;
+}
+
+static void* client_run(void *arg) {
+    client_thread_t *t = arg;
+    struct epoll_event events[MAX_EVENTS];
+    
+    int64_t now = now_ns();
+    for (int i = 0; i < t->conn_count; i++) {
+        conn_open(t, &t->conns[i], now);
+    }
+    
+    while (1) {
+        now = now_ns();
+        if (now >= end_ns) break;
         
-        if (n > 0) {
-            buffer[n] = '\0';
-            data->successful_requests++;
-        } else {
-            data->failed_requests++;
-            data->recv_failures++;
+        if (t->closed > 0 && now >= t->retry_at) {
+            reopen_connections(t, now);
         }
         
-        close(sock);
+        // 开环：按时间表把到期的请求交给对应连接，在途已满或未连上的连接之后自己补发
+        if (rate > 0) {
+            while (tick_time(t, t->next_tick) <= now) {
+                conn_fill(t, &t->conns[t->next_tick % t->conn_count], now);
+                t->next_tick++;
+            }
+        }
         
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        double elapsed = (end.tv_sec - start.tv_sec) + 
-                        (end.tv_nsec - start.tv_nsec) / 1e9;
-        data->total_time += elapsed;
+        int n = epoll_wait(t->epfd, events, MAX_EVENTS, arm_timer(t, now));
+        now = now_ns();
         
-        // 短暂延迟以避免过载服务器，基于线程ID错开
-        if (i % 10 == 0) { // 每10个请求稍作休息
-            usleep(1000); // 1ms
-        } else {
-            usleep(50); // 0.05ms
+        for (int i = 0; i < n; i++) {
+            client_conn_t *c = events[i].data.ptr;
+            if (!c) {
+                uint64_t expirations;
+                read(t->timerfd, &expirations, sizeof(expirations));
+                continue;
+            }
+            
+            // 同一批里前面的事件可能已经关闭了这个连接
+            if (c->fd < 0) continue;
+            
+            if (c->state == CONN_CONNECTING) {
+                conn_connected(t, c, now);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                if (conn_flush(t, c, now) != 0) continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                conn_read(t, c, now);
+            }
         }
     }
     
+    for (int i = 0; i < t->conn_count; i++) {
+        if (t->conns[i].fd >= 0) close(t->conns[i].fd);
+    }
     return NULL;
 }
 
-int main() {
-    printf("Starting performance test...\n");
-    printf("Threads: %d, Requests per thread: %d\n", NUM_THREADS, REQUESTS_PER_THREAD);
-    
-    pthread_t threads[NUM_THREADS];
-    thread_data_t thread_data[NUM_THREADS];
-    
-    // 初始化线程数据
-    for (int i = 0; i < NUM_THREADS; i++) {
-        thread_data[i].thread_id = i;
-        thread_data[i].successful_requests = 0;
-        thread_data[i].failed_requests = 0;
-        thread_data[i].connect_failures = 0;
-        thread_data[i].send_failures = 0;
-        thread_data[i].recv_failures = 0;
-        thread_data[i].total_time = 0;
-    }
-    
-    // 记录开始时间
-    struct timespec test_start, test_end;
-    clock_gettime(CLOCK_MONOTONIC, &test_start);
-    
-    // 创建客户端线程
-    for (int i = 0; i < NUM_THREADS; i++) {
-        pthread_create(&threads[i], NULL, client_thread, &thread_data[i]);
-    }
-    
-    // 等待所有线程完成
-    for (int i = 0; i < NUM_THREADS; i++) {
-        pthread_join(threads[i], NULL);
-    }
-    
-    // 记录结束时间
-    clock_gettime(CLOCK_MONOTONIC, &test_end);
-    double total_test_time = (test_end.tv_sec - test_start.tv_sec) + 
-                            (test_end.tv_nsec - test_start.tv_nsec) / 1e9;
-    
-    // 统计结果
-    int total_successful = 0;
-    int total_failed = 0;
-    int total_connect_failures = 0;
-    int total_send_failures = 0;
-    int total_recv_failures = 0;
-    double total_request_time = 0;
-    
-    for (int i = 0; i < NUM_THREADS; i++) {
-        total_successful += thread_data[i].successful_requests;
-        total_failed += thread_data[i].failed_requests;
-        total_connect_failures += thread_data[i].connect_failures;
-        total_send_failures += thread_data[i].send_failures;
-        total_recv_failures += thread_data[i].recv_failures;
-        total_request_time += thread_data[i].total_time;
-    }
-    
-    // 打印结果
-    printf("\n========== Test Results ==========\n");
-    printf("Total requests: %d\n", total_successful + total_failed);
-    printf("Successful: %d\n", total_successful);
-    printf("Failed: %d\n", total_failed);
-    if (total_failed > 0) {
-        printf("  - Connect failures: %d\n", total_connect_failures);
-        printf("  - Send failures: %d\n", total_send_failures);
-        printf("  - Recv failures: %d\n", total_recv_failures);
-    }
-    printf("Success rate: %.2f%%\n", 
-           (total_successful * 100.0) / (total_successful + total_failed));
-    printf("Total test time: %.2f seconds\n", total_test_time);
-    printf("Requests per second: %.2f\n", total_successful / total_test_time);
-    printf("Average request time: %.4f seconds\n", 
-           total_request_time / total_successful);
-    printf("==================================\n");
+// ---- 请求模板 ----
+
+// 按 method/path/headers/body 拼出请求，没有 Host 头时补上
+static int build_request(const char *method, const char *path, const char *host, const char *port,
+                         char **headers, int header_count, const char *body) {
+    request = malloc(REQUEST_MAX);
+    if (!request) return -1;
+    
+    int has_host = 0;
+    int len = snprintf(request, REQUEST_MAX, "%s %s HTTP/1.1\r\n", method, path);
+    for (int i = 0; i < header_count && len < REQUEST_MAX; i++) {
+        if (strncasecmp(headers[i], "Host:", 5) == 0) has_host = 1;
+        len += snprintf(request + len, REQUEST_MAX - len, "%s\r\n", headers[i]);
+    }
+    if (!has_host && len < REQUEST_MAX) {
+        len += snprintf(request + len, REQUEST_MAX - len, "Host: %s:%s\r\n", host, port);
+    }
+    if (body && len < REQUEST_MAX) {
+        len += snprintf(request + len, REQUEST_MAX - len, "Content-Length: %zu\r\n\r\n%s",
+                        strlen(body), body);
+    } else if (len < REQUEST_MAX) {
+        len += snprintf(request + len, REQUEST_MAX - len, "\r\n");
+    }
+    if (len >= REQUEST_MAX) {
+        fprintf(stderr, "Request template too large\n");
+        return -1;
+    }
+    
+    request_len = len;
+    head_request = strcmp(method, "HEAD") == 0;
+    return 0;
+}
+
+// 从文件读取原样的请求，单独的 \n 换成 \r\n
+static int load_request(const char *file) {
+    FILE *fp = fopen(file, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s: %s\n", file, strerror(errno));
+        return -1;
+    }
+    
+    request = malloc(REQUEST_MAX);
+    if (!request) {
+        fclose(fp);
+        return -1;
+    }
+    
+    int ch, prev = 0;
+    request_len = 0;
+    while ((ch = fgetc(fp)) != EOF) {
+        if (request_len >= REQUEST_MAX - 2) {
+            fprintf(stderr, "Request template too large\n");
+            fclose(fp);
+            return -1;
+        }
+        if (ch == '\n' && prev != '\r') {
+            request[request_len++] = '\r';
+        }
+        request[request_len++] = (char)ch;
+        prev = ch;
+    }
+    fclose(fp);
+    
+    if (request_len == 0) {
+        fprintf(stderr, "Empty request template %s\n", file);
+        return -1;
+    }
+    head_request = request_len > 5 && strncmp(request, "HEAD ", 5) == 0;
+    return 0;
+}
+
+static int resolve(const char *host, const char *port) {
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
     
+    int rc = getaddrinfo(host, port, &hints, &res);
+    if (rc != 0) {
+        fprintf(stderr, "Cannot resolve %s:%s: %s\n", host, port, gai_strerror(rc));
+        return -1;
+    }
+    memcpy(&server_addr, res->ai_addr, res->ai_addrlen);
+    server_addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
     return 0;
-}
\ No newline at end of file
+}
+
+// ---- 输出 ----
+
+static void print_json_string(const char *s, int len) {
+    putchar('"');
+    for (int i = 0; i < len; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        if (ch == '"' || ch == '\\') {
+            printf("\\%c", ch);
+        } else if (ch < 0x20) {
+            printf("\\u%04x", ch);
+        } else {
+            putchar(ch);
+        }
+    }
+    putchar('"');
+}
+
+static void print_latency(const char *name, const hist_t *h) {
+    printf("  \"%s\": {\"min\": %.1f, \"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+           "\"p99_9\": %.1f, \"p99_99\": %.1f, \"max\": %.1f}",
+           name, h->total ? h->min / 1e3 : 0.0, h->total ? h->sum / h->total / 1e3 : 0.0,
+           hist_percentile(h, 50) / 1e3, hist_percentile(h, 90) / 1e3, hist_percentile(h, 99) / 1e3,
+           hist_percentile(h, 99.9) / 1e3, hist_percentile(h, 99.99) / 1e3, h->max / 1e3);
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("Options:\n");
+    printf("  --host HOST            Server address (default: %s)\n", DEFAULT_HOST);
+    printf("  -p, --port PORT        Server port (default: %s)\n", DEFAULT_PORT);
+    printf("  -t, --threads NUM      Client threads (default: %d)\n", DEFAULT_THREADS);
+    printf("  -c, --connections NUM  Keep-alive connections, spread over threads (default: %d)\n", DEFAULT_CONNS);
+    printf("  -d, --duration SEC     Test duration (default: %d)\n", DEFAULT_SECONDS);
+    printf("  -w, --warmup SEC       Leading part of the duration left out of the results (default: 0)\n");
+    printf("  -R, --rate RPS         Open loop: total requests/s on a fixed schedule, latency\n");
+    printf("                         corrected for coordinated omission (default: 0, closed loop)\n");
+    printf("  -P, --pipeline NUM     Requests in flight per connection (default: %d)\n", DEFAULT_PIPELINE);
+    printf("  -m, --method METHOD    Request method (default: %s)\n", DEFAULT_METHOD);
+    printf("  -u, --path PATH        Request path (default: %s)\n", DEFAULT_PATH);
+    printf("  -H, --header LINE      Extra request header, repeatable\n");
+    printf("  -b, --body DATA        Request body (adds Content-Length)\n");
+    printf("  -f, --request-file F   Raw request template, overrides method/path/headers/body\n");
+    printf("  -h, --help             Show this help message\n");
+    printf("\nResults are printed to stdout as JSON (latencies in microseconds),\n");
+    printf("a short summary goes to stderr.\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *host = DEFAULT_HOST;
+    const char *port = DEFAULT_PORT;
+    int thread_count = DEFAULT_THREADS;
+    int conn_count = DEFAULT_CONNS;
+    double duration = DEFAULT_SECONDS;
+    double warmup = 0;
+    const char *method = DEFAULT_METHOD;
+    const char *path = DEFAULT_PATH;
+    const char *body = NULL;
+    const char *request_file = NULL;
+    char **headers = calloc(argc, sizeof(char*));
+    int header_count = 0;
+    
+    static struct option long_options[] = {
+        {"host",         required_argument, 0, 256},
+        {"port",         required_argument, 0, 'p'},
+        {"threads",      required_argument, 0, 't'},
+        {"connections",  required_argument, 0, 'c'},
+        {"duration",     required_argument, 0, 'd'},
+        {"warmup",       required_argument, 0, 'w'},
+        {"rate",         required_argument, 0, 'R'},
+        {"pipeline",     required_argument, 0, 'P'},
+        {"method",       required_argument, 0, 'm'},
+        {"path",         required_argument, 0, 'u'},
+        {"header",       required_argument, 0, 'H'},
+        {"body",         required_argument, 0, 'b'},
+        {"request-file", required_argument, 0, 'f'},
+        {"help",         no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:t:c:d:w:R:P:m:u:H:b:f:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 256:
+                host = optarg;
+                break;
+            case 'p':
+                port = optarg;
+                break;
+            case 't':
+                thread_count = atoi(optarg);
+                break;
+            case 'c':
+                conn_count = atoi(optarg);
+                break;
+            case 'd':
+                duration = atof(optarg);
+                break;
+            case 'w':
+                warmup = atof(optarg);
+                break;
+            case 'R':
+                rate = atof(optarg);
+                break;
+            case 'P':
+                pipeline = atoi(optarg);
+                break;
+            case 'm':
+                method = optarg;
+                break;
+            case 'u':
+                path = optarg;
+                break;
+            case 'H':
+                headers[header_count++] = optarg;
+                break;
+            case 'b':
+                body = optarg;
+                break;
+            case 'f':
+                request_file = optarg;
+                break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    
+    if (thread_count <= 0 || conn_count <= 0 || duration <= 0 || warmup < 0 || warmup >= duration ||
+        rate < 0 || pipeline <= 0 || pipeline > PIPELINE_MAX) {
+        fprintf(stderr, "Invalid arguments\n");
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (thread_count > conn_count) {
+        thread_count = conn_count;
+    }
+    
+    if (resolve(host, port) != 0) return EXIT_FAILURE;
+    if (request_file ? load_request(request_file) != 0
+                     : build_request(method, path, host, port, headers, header_count, body) != 0) {
+        return EXIT_FAILURE;
+    }
+    
+    client_thread_t *threads = calloc(thread_count, sizeof(client_thread_t));
+    if (!threads) return EXIT_FAILURE;
+    
+    start_ns = now_ns();
+    record_ns = start_ns + (int64_t)(warmup * 1e9);
+    end_ns = start_ns + (int64_t)(duration * 1e9);
+    
+    for (int i = 0; i < thread_count; i++) {
+        client_thread_t *t = &threads[i];
+        t->index = i;
+        t->conn_count = conn_count / thread_count + (i < conn_count % thread_count);
+        t->conns = calloc(t->conn_count, sizeof(client_conn_t));
+        t->buf = malloc(READ_SIZE);
+        t->epfd = epoll_create1(EPOLL_CLOEXEC);
+        t->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (!t->conns || !t->buf || t->epfd < 0 || t->timerfd < 0 ||
+            hist_init(&t->latency) != 0 || hist_init(&t->uncorrected) != 0) {
+            fprintf(stderr, "Failed to set up client thread: %s\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+        
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+        epoll_ctl(t->epfd, EPOLL_CTL_ADD, t->timerfd, &ev);
+        
+        // 线程间错开不到一个间隔的相位，避免所有线程同时发请求
+        if (rate > 0) {
+            t->interval = 1e9 * conn_count / (rate * t->conn_count);
+            t->phase = t->interval * i / thread_count;
+        }
+        
+        for (int j = 0; j < t->conn_count; j++) {
+            client_conn_t *c = &t->conns[j];
+            c->fd = -1;
+            c->index = j;
+            c->body_left = -1;
+            c->intended = calloc(pipeline, sizeof(int64_t));
+            c->sent = calloc(pipeline, sizeof(int64_t));
+            c->out = malloc((size_t)pipeline * request_len);
+            if (!c->intended || !c->sent || !c->out) {
+                fprintf(stderr, "Out of memory\n");
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    
+    for (int i = 0; i < thread_count; i++) {
+        pthread_create(&threads[i].tid, NULL, client_run, &threads[i]);
+    }
+    
+    hist_t latency, uncorrected;
+    if (hist_init(&latency) != 0 || hist_init(&uncorrected) != 0) return EXIT_FAILURE;
+    long completed = 0, status[6] = { 0 };
+    long long bytes = 0;
+    long err_connect = 0, err_read = 0, err_write = 0, err_parse = 0, err_closed = 0;
+    
+    for (int i = 0; i < thread_count; i++) {
+        client_thread_t *t = &threads[i];
+        pthread_join(t->tid, NULL);
+        
+        hist_merge(&latency, &t->latency);
+        hist_merge(&uncorrected, &t->uncorrected);
+        completed += t->completed;
+        for (int s = 0; s < 6; s++) {
+            status[s] += t->status[s];
+        }
+        bytes += t->bytes;
+        err_connect += t->err_connect;
+        err_read += t->err_read;
+        err_write += t->err_write;
+        err_parse += t->err_parse;
+        err_closed += t->err_closed;
+    }
+    
+    double measured = (end_ns - record_ns) / 1e9;
+    double rps = completed / measured;
+    long errors = err_connect + err_read + err_write + err_parse + err_closed;
+    
+    // 请求行（模板的第一行）
+    int line_len = 0;
+    while (line_len < request_len && request[line_len] != '\r') line_len++;
+    
+    printf("{\n");
+    printf("  \"host\": ");
+    print_json_string(host, (int)strlen(host));
+    printf(",\n  \"port\": %s,\n  \"request\": ", port);
+    print_json_string(request, line_len);
+    printf(",\n  \"mode\": \"%s\",\n  \"rate\": %.0f,\n", rate > 0 ? "open" : "closed", rate);
+    printf("  \"threads\": %d,\n  \"connections\": %d,\n  \"pipeline\": %d,\n", thread_count, conn_count, pipeline);
+    printf("  \"duration_s\": %.3f,\n  \"warmup_s\": %.3f,\n", duration, warmup);
+    printf("  \"requests\": %ld,\n  \"rps\": %.1f,\n  \"bytes\": %lld,\n  \"mb_per_s\": %.2f,\n",
+           completed, rps, bytes, bytes / measured / (1024 * 1024));
+    printf("  \"status\": {\"1xx\": %ld, \"2xx\": %ld, \"3xx\": %ld, \"4xx\": %ld, \"5xx\": %ld},\n",
+           status[1], status[2], status[3], status[4], status[5]);
+    printf("  \"errors\": {\"total\": %ld, \"connect\": %ld, \"read\": %ld, \"write\": %ld, "
+           "\"parse\": %ld, \"closed\": %ld},\n",
+           errors, err_connect, err_read, err_write, err_parse, err_closed);
+    print_latency("latency_us", &latency);
+    printf(",\n");
+    print_latency("latency_uncorrected_us", &uncorrected);
+    printf("\n}\n");
+    fflush(stdout);
+    
+    fprintf(stderr, "%s loop, %d threads x %d connections x %d pipeline, %.1f s: "
+            "%ld requests, %.0f req/s, %.2f MB/s, %ld non-2xx, %ld errors\n",
+            rate > 0 ? "open" : "closed", thread_count, conn_count, pipeline, measured,
+            completed, rps, bytes / measured / (1024 * 1024), completed - status[2], errors);
+    fprintf(stderr, "latency%s (us): p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+            rate > 0 ? " from intended send time" : "",
+            hist_percentile(&latency, 50) / 1e3, hist_percentile(&latency, 99) / 1e3,
+            hist_percentile(&latency, 99.9) / 1e3, latency.max / 1e3);
+    
+    for (int i = 0; i < thread_count; i++) {
+        client_thread_t *t = &threads[i];
+        for (int j = 0; j < t->conn_count; j++) {
+            free(t->conns[j].intended);
+            free(t->conns[j].sent);
+            free(t->conns[j].out);
+        }
+        close(t->epfd);
+        close(t->timerfd);
+        free(t->conns);
+        free(t->buf);
+        free(t->latency.counts);
+        free(t->uncorrected.counts);
+    }
+    free(threads);
+    free(latency.counts);
+    free(uncorrected.counts);
+    free(headers);
+    free(request);
+    
+    return completed > 0 ? 0 : EXIT_FAILURE;
+}
@@ -2,6 +2,11 @@
 
 echo "=== IO线程数量性能测试 ==="
 
+# 从 test_client 的 JSON 输出中取第一个同名数值字段
+json_field() {
+    echo "$1" | sed -n "s/.*\"$2\": \([0-9.]*\).*/\1/p" | head -1
+}
+
 for io_threads in 2 4 6 8 12 16; do
     echo ""
     echo "🧪 测试 $io_threads 个IO线程..."
@@ -14,10 +19,10 @@ for io_threads in 2 4 6 8 12 16; do
     sleep 1
     
     # 运行测试
-    result=$(./test_client | grep "Success rate\|Requests per second")
+    result=$(./test_client -d 5 -c 64 -t 4 2>/dev/null)
     
     echo "IO线程数: $io_threads"
-    echo "$result"
+    echo "请求/秒: $(json_field "$result" rps)  p99: $(json_field "$result" p99) us  错误: $(json_field "$result" total)"
     
     # 关闭服务器
     kill $server_pid 2>/dev/null
@@ -2,6 +2,11 @@
 
 echo "=== IO线程 + Worker线程组合性能测试 ==="
 
+# 从 test_client 的 JSON 输出中取第一个同名数值字段
+json_field() {
+    echo "$1" | sed -n "s/.*\"$2\": \([0-9.]*\).*/\1/p" | head -1
+}
+
 # 测试不同的线程组合
 combinations=(
     "4 8"    # 4 IO, 8 Worker
@@ -28,10 +33,10 @@ for combo in "${combinations[@]}"; do
     sleep 1
     
     # 运行测试
-    result=$(./test_client | grep -E "Success rate|Requests per second|Total test time")
+    result=$(./test_client -d 5 -c 64 -t 4 2>/dev/null)
     
     echo "配置: IO=$io_threads, Worker=$worker_threads"
-    echo "$result"
+    echo "请求/秒: $(json_field "$result" rps)  p50: $(json_field "$result" p50) us  p99: $(json_field "$result" p99) us  p99.9: $(json_field "$result" p99_9) us  错误: $(json_field "$result" total)"
     echo "---"
     
     # 关闭服务器
@@ -1,126 +1,367 @@
 // thread_pool.c
 #include "thread_pool.h"
 #include "io_thread.h"
+#include "handler.h"
+#include "response_cache.h"
 
-// 业务处理函数（示例：简单的 HTTP echo 服务）
-static void process_request(connection_t *conn, void *data, int data_len) {
-    // 这里模拟业务处理，实际可以解析 HTTP 请求、查询数据库等
-    char response[BUFFER_SIZE];
-    int response_len;
-    
-    // 简单的 HTTP 响应
-    const char *http_response_template = 
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: text/plain\r\n"
-        "Content-Length: %d\r\n"
-        "Connection: keep-alive\r\n"
-        "\r\n"
-        "%s";
-    
-    // Echo 收到的数据
-    char body[1024];
-    int body_len = snprintf(body, sizeof(body), "Echo: %.*s", data_len, (char*)data);
-    
-    response_len = snprintf(response, sizeof(response), 
-                           http_response_template, 
-                           body_len, body);
-    
-    // 将响应数据写入连接的写缓冲区
-    if (response_len > 0 && response_len < BUFFER_SIZE) {
-        memcpy(conn->write_buf, response, response_len);
-        conn->write_size = response_len;
-        conn->write_pos = 0;
-        conn->state = CONN_STATE_WRITING;
-    }
-    
-    // 通过消息队列通知IO线程切换到写模式
+// 本地双端队列容量、每次从 inbox 转入的最大任务数、休眠前的自旋次数
+#define WORKER_DEQUE_SIZE   1024
+#define WORKER_REFILL_BATCH 32
+#define WORKER_SPIN_LIMIT   256
+
+// 连接执行器一次最多连续执行的任务数，超过后重新排队，避免单个连接独占 worker
+#define SERIAL_BATCH_LIMIT  16
+
+static int requeue_runner(worker_t *worker, task_t *runner);
+
+// 业务处理：按路径选择处理函数，响应交给 IO 线程按请求顺序发送
+// start 为开始执行的时间，与排队时间的终点共用一次时钟读取
+static void process_request(worker_t *worker, connection_t *conn, const task_t *task, uint64_t start) {
+    request_t req;
+    const handler_t *handler = handler_find(&task->data, &req);
+    
+    buf_chain_t chain;
+    buf_chain_init(&chain);
+    
+    int ret = handler_invoke(handler, &req, &chain);
+    metrics_record(METRIC_HANDLER, metrics_now_ns() - start);
+    
+    if (ret != 0) {
+        // 缺少这个响应后续响应都无法按序发送，只能关闭连接
+        log_error("Failed to build response for fd=%d", conn->fd);
+        buf_chain_clear(&chain);
+        io_thread_send_message((io_thread_t*)conn->io_thread, IO_MSG_CLOSE_CONN, conn);
+        return;
+    }
+    
+    response_cache_store(handler, &req, &chain);
+    if (log_access_enabled()) {
+        handler_log_access(conn, &req, &chain, task->start_ns, "worker");
+    }
+    
+    // 直接写出，或通过消息队列把响应交给IO线程
     if (conn->io_thread && conn_is_valid(conn)) {
-        io_thread_send_message((io_thread_t*)conn->io_thread, IO_MSG_RESPONSE_READY, conn);
+        long written = io_thread_send_response((io_thread_t*)conn->io_thread, conn, task->seq,
+                                               task->start_ns, &chain);
+        if (written > 0) {
+            stat_add(&worker->direct_writes, 1);
+            stat_add(&worker->direct_bytes, written);
+        }
+    } else {
+        buf_chain_clear(&chain);
+    }
+}
+
+// 执行单个任务
+static void execute_task(worker_t *worker, task_t *task) {
+    // 根据任务类型处理
+    switch (task->type) {
+        case TASK_TYPE_PROCESS: {
+            uint64_t now_ns = metrics_now_ns();
+            if (task->start_ns) {
+                metrics_record(METRIC_QUEUE_WAIT, now_ns - task->start_ns);
+            }
+            
+            // 检查连接是否仍然有效
+            if (conn_is_valid(task->conn)) {
+                process_request(worker, task->conn, task, now_ns);
+            }
+            break;
+        }
+        
+        case TASK_TYPE_CLOSE:
+            // 清理连接
+            if (task->conn) {
+                conn_mark_closing(task->conn);
+                conn_release(task->conn);
+            }
+            break;
+        
+        default:
+            log_error("Unknown task type: %d", task->type);
+            break;
+    }
+    
+    stat_add(&worker->tasks_executed, 1);
+}
+
+// 连接执行器：按投递顺序执行连接邮箱中的任务
+// task_pending 保证同一时刻只有一个执行器在运行。执行器本身不持有连接引用，
+// 连接由尚未释放的任务保活，所以在减计数之后不能再访问执行器和连接。
+static void run_serial(worker_t *worker, connection_t *conn) {
+    for (int n = 1; ; n++) {
+        // task_pending > 0 说明对应任务已经入队（投递方先入队后计数）
+        task_t *task;
+        mpsc_node_t *node;
+        while (!(node = mpsc_queue_pop(&conn->tasks))) {
+            cpu_relax();
+        }
+        task = mpsc_container_of(node, task_t, node);
+        
+        execute_task(worker, task);
+        
+        if (atomic_fetch_sub_explicit(&conn->task_pending, 1, memory_order_acq_rel) == 1) {
+            task_destroy(task);
+            return;
+        }
+        
+        // 还有任务但已执行一批：重新排队，让其它连接有机会执行；无处可排时继续在本线程执行
+        if (n >= SERIAL_BATCH_LIMIT && requeue_runner(worker, &conn->runner) == 0) {
+            task_destroy(task);
+            return;
+        }
+        task_destroy(task);
+    }
+}
+
+static void run_task(worker_t *worker, task_t *task) {
+    if (task->type == TASK_TYPE_SERIAL) {
+        run_serial(worker, task->conn);
+        return;
+    }
+    
+    execute_task(worker, task);
+    task_destroy(task);
+}
+
+// 从 inbox 批量转入本地双端队列，返回其中第一个任务
+// 逆序压入，使所有者从底部按提交顺序取出
+static task_t* worker_refill(worker_t *worker) {
+    task_t *batch[WORKER_REFILL_BATCH];
+    int n = 0;
+    
+    while (n < WORKER_REFILL_BATCH) {
+        task_t *task = task_queue_try_pop(worker->inbox);
+        if (!task) break;
+        batch[n++] = task;
+    }
+    
+    if (n == 0) return NULL;
+    
+    for (int i = n - 1; i > 0; i--) {
+        ws_deque_push(worker->deque, batch[i]);
+    }
+    return batch[0];
+}
+
+// 从其它 worker 窃取：先窃取双端队列顶部，再尝试其 inbox
+static task_t* worker_steal(worker_t *worker) {
+    thread_pool_t *pool = worker->pool;
+    int count = pool->thread_count;
+    int start = rand_r(&worker->rand_state) % count;
+    
+    for (int i = 0; i < count; i++) {
+        worker_t *victim = &pool->workers[(start + i) % count];
+        if (victim == worker) continue;
+        
+        task_t *task = ws_deque_steal(victim->deque);
+        if (!task) {
+            task = task_queue_try_pop(victim->inbox);
+        }
+        if (task) {
+            stat_add(&worker->tasks_stolen, 1);
+            return task;
+        }
+    }
+    
+    return NULL;
+}
+
+static task_t* worker_find_task(worker_t *worker) {
+    task_t *task = ws_deque_take(worker->deque);
+    if (!task) task = worker_refill(worker);
+    if (!task) task = worker_steal(worker);
+    return task;
+}
+
+// 没有待处理任务时休眠，直到有新任务提交或线程池关闭
+static void worker_park(worker_t *worker) {
+    thread_pool_t *pool = worker->pool;
+    
+    pthread_mutex_lock(&pool->idle_mutex);
+    atomic_store(&worker->parked, 1);
+    atomic_fetch_add(&pool->idle_workers, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (atomic_load(&pool->pending_tasks) <= 0 && !atomic_load(&pool->shutdown)) {
+        pthread_cond_wait(&worker->wakeup, &pool->idle_mutex);
+    }
+    atomic_fetch_sub(&pool->idle_workers, 1);
+    atomic_store(&worker->parked, 0);
+    pthread_mutex_unlock(&pool->idle_mutex);
+}
+
+// 唤醒一个休眠的 worker：优先唤醒任务的目标 worker 以保持缓存亲和性
+static void wake_worker(thread_pool_t *pool, worker_t *target) {
+    pthread_mutex_lock(&pool->idle_mutex);
+    if (atomic_load(&target->parked)) {
+        pthread_cond_signal(&target->wakeup);
+    } else {
+        for (int i = 0; i < pool->thread_count; i++) {
+            if (atomic_load(&pool->workers[i].parked)) {
+                pthread_cond_signal(&pool->workers[i].wakeup);
+                break;
+            }
+        }
     }
+    pthread_mutex_unlock(&pool->idle_mutex);
 }
 
 // 工作线程函数
 static void* worker_thread(void *arg) {
-    thread_pool_t *pool = (thread_pool_t*)arg;
+    worker_t *worker = (worker_t*)arg;
+    thread_pool_t *pool = worker->pool;
     
-    while (!pool->shutdown) {
-        task_t *task = task_queue_pop(pool->task_queue);
-        if (!task) {
-            if (pool->shutdown) break;
+    // 先绑定 CPU，之后本线程的任务、消息和缓冲区对象池都在本节点首次写入
+    if (thread_placement_apply(&worker->placement) != 0) {
+        log_error("Worker %d: failed to set CPU affinity", worker->index);
+    }
+    
+    while (!atomic_load(&pool->shutdown)) {
+        task_t *task = worker_find_task(worker);
+        if (task) {
+            atomic_fetch_sub(&pool->pending_tasks, 1);
+            run_task(worker, task);
             continue;
         }
         
-        // 根据任务类型处理
-        switch (task->type) {
-            case TASK_TYPE_PROCESS:
-                // 检查连接是否仍然有效
-                if (conn_is_valid(task->conn)) {
-                    process_request(task->conn, task->data, task->data_len);
-                }
-                break;
-                
-            case TASK_TYPE_CLOSE:
-                // 清理连接
-                if (task->conn) {
-                    conn_mark_closing(task->conn);
-                    conn_release(task->conn);
-                }
-                break;
-                
-            default:
-                log_error("Unknown task type: %d", task->type);
-                break;
+        // 其它 worker 仍有任务：继续窃取
+        if (atomic_load(&pool->pending_tasks) > 0) {
+            cpu_relax();
+            continue;
         }
         
-        // 更新统计信息
-        pthread_mutex_lock(&pool->stats_mutex);
-        pool->tasks_completed++;
-        pthread_mutex_unlock(&pool->stats_mutex);
-        
-        // 销毁任务
-        task_destroy(task);
+        // 短暂自旋等待新任务，随后休眠
+        int spins = 0;
+        while (atomic_load(&pool->pending_tasks) <= 0 && spins++ < WORKER_SPIN_LIMIT &&
+               !atomic_load(&pool->shutdown)) {
+            cpu_relax();
+        }
+        if (atomic_load(&pool->pending_tasks) <= 0) {
+            worker_park(worker);
+        }
     }
     
     return NULL;
 }
 
-thread_pool_t* thread_pool_create(int thread_count, int queue_size) {
-    thread_pool_t *pool = (thread_pool_t*)malloc(sizeof(thread_pool_t));
+// 停止已启动的 worker 并释放线程池
+static void thread_pool_free(thread_pool_t *pool, int started) {
+    thread_pool_shutdown(pool);
+    
+    // 等待所有工作线程退出
+    for (int i = 0; i < started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    
+    // 释放未执行的任务和各 worker 的队列
+    for (int i = 0; i < pool->thread_count; i++) {
+        worker_t *worker = &pool->workers[i];
+        pthread_cond_destroy(&worker->wakeup);
+        if (worker->deque) {
+            task_t *task;
+            while ((task = ws_deque_take(worker->deque))) {
+                task_destroy(task);
+            }
+            ws_deque_destroy(worker->deque);
+        }
+        task_queue_destroy(worker->inbox);
+    }
+    
+    free(pool->workers);
+    free(pool->group_offset);
+    free(pool->group_workers);
+    pthread_mutex_destroy(&pool->idle_mutex);
+    free(pool);
+}
+
+// 按 worker 的 CPU 分组建立下标表
+static int thread_pool_build_groups(thread_pool_t *pool) {
+    int group_count = 0;
+    for (int i = 0; i < pool->thread_count; i++) {
+        if (pool->workers[i].placement.group >= group_count) {
+            group_count = pool->workers[i].placement.group + 1;
+        }
+    }
+    if (group_count == 0) return 0;
+    
+    pool->group_offset = (int*)calloc(group_count + 1, sizeof(int));
+    pool->group_workers = (int*)malloc(sizeof(int) * pool->thread_count);
+    if (!pool->group_offset || !pool->group_workers) return -1;
+    
+    int n = 0;
+    for (int g = 0; g < group_count; g++) {
+        pool->group_offset[g] = n;
+        for (int i = 0; i < pool->thread_count; i++) {
+            if (pool->workers[i].placement.group == g) {
+                pool->group_workers[n++] = i;
+            }
+        }
+    }
+    pool->group_offset[group_count] = n;
+    pool->group_count = group_count;
+    return 0;
+}
+
+thread_pool_t* thread_pool_create(int thread_count, int queue_size, task_queue_kind_t queue_kind,
+                                  const thread_placement_t *placement) {
+    thread_pool_t *pool = (thread_pool_t*)cache_aligned_calloc(1, sizeof(thread_pool_t));
     if (!pool) return NULL;
     
     pool->thread_count = thread_count;
-    pool->shutdown = 0;
-    pool->tasks_completed = 0;
+    atomic_init(&pool->shutdown, 0);
+    atomic_init(&pool->pending_tasks, 0);
+    atomic_init(&pool->idle_workers, 0);
+    atomic_init(&pool->next_worker, 0);
+    
+    pthread_mutex_init(&pool->idle_mutex, NULL);
     
-    // 创建任务队列
-    pool->task_queue = task_queue_create(queue_size);
-    if (!pool->task_queue) {
+    // 每个 worker 独占缓存行
+    pool->workers = (worker_t*)cache_aligned_calloc(thread_count, sizeof(worker_t));
+    if (!pool->workers) {
+        pthread_mutex_destroy(&pool->idle_mutex);
         free(pool);
         return NULL;
     }
     
-    // 初始化统计互斥锁
-    pthread_mutex_init(&pool->stats_mutex, NULL);
+    // 创建每个 worker 的 inbox 和本地双端队列
+    for (int i = 0; i < thread_count; i++) {
+        worker_t *worker = &pool->workers[i];
+        worker->index = i;
+        worker->pool = pool;
+        worker->rand_state = (unsigned int)(i * 2654435761u + 1);
+        if (placement) {
+            worker->placement = placement[i];
+        } else {
+            worker->placement.node = -1;
+            worker->placement.group = -1;
+        }
+        atomic_init(&worker->parked, 0);
+        pthread_cond_init(&worker->wakeup, NULL);
+        worker->inbox = task_queue_create_kind(queue_size, queue_kind);
+        worker->deque = ws_deque_create(WORKER_DEQUE_SIZE);
+        if (!worker->inbox || !worker->deque) {
+            thread_pool_free(pool, 0);
+            return NULL;
+        }
+    }
     
-    // 创建工作线程
-    pool->threads = (pthread_t*)malloc(sizeof(pthread_t) * thread_count);
-    if (!pool->threads) {
-        task_queue_destroy(pool->task_queue);
-        free(pool);
+    if (placement && thread_pool_build_groups(pool) != 0) {
+        thread_pool_free(pool, 0);
         return NULL;
     }
     
+    // 创建工作线程
     for (int i = 0; i < thread_count; i++) {
-        if (pthread_create(&pool->threads[i], NULL, worker_thread, pool) != 0) {
+        if (pthread_create(&pool->workers[i].thread, NULL, worker_thread, &pool->workers[i]) != 0) {
             log_error("Failed to create worker thread %d", i);
             // 清理已创建的线程
-            pool->thread_count = i;
-            thread_pool_destroy(pool);
+            thread_pool_free(pool, i);
             return NULL;
         }
     }
     
-    log_info("Thread pool created with %d workers", thread_count);
+    log_info("Thread pool created with %d workers (work stealing, %s inboxes)", 
+            thread_count, task_queue_kind_name(queue_kind));
     
     return pool;
 }
@@ -128,35 +369,170 @@ thread_pool_t* thread_pool_create(int thread_count, int queue_size) {
 void thread_pool_destroy(thread_pool_t *pool) {
     if (!pool) return;
     
-    // 设置关闭标志
-    pool->shutdown = 1;
+    long tasks_completed = thread_pool_tasks_completed(pool);
     
-    // 关闭任务队列
-    task_queue_shutdown(pool->task_queue);
+    thread_pool_log_stats(pool);
+    thread_pool_free(pool, pool->thread_count);
     
-    // 等待所有工作线程退出
-    for (int i = 0; i < pool->thread_count; i++) {
-        pthread_join(pool->threads[i], NULL);
+    log_info("Thread pool destroyed. Total tasks completed: %ld", tasks_completed);
+}
+
+// 按连接亲和性选择 worker，同一连接的任务尽量落在同一个 worker 的缓存上
+// 绑定 CPU 时优先选与提交线程（IO 线程或重新排队的 worker）同组的 worker，任务数据留在同一个 LLC
+static worker_t* pick_worker(thread_pool_t *pool, task_t *task) {
+    unsigned int index;
+    
+    if (task->conn) {
+        uint64_t h = (uint64_t)(uintptr_t)task->conn * 0x9E3779B97F4A7C15ULL;
+        unsigned int hash = (unsigned int)(h >> 32);
+        
+        int group = cpu_current_group();
+        if (group >= 0 && group < pool->group_count) {
+            int first = pool->group_offset[group];
+            int size = pool->group_offset[group + 1] - first;
+            if (size > 0) {
+                return &pool->workers[pool->group_workers[first + hash % (unsigned int)size]];
+            }
+        }
+        index = hash % pool->thread_count;
+    } else {
+        index = atomic_fetch_add_explicit(&pool->next_worker, 1, memory_order_relaxed) 
+                % pool->thread_count;
+    }
+    
+    return &pool->workers[index];
+}
+
+// 有 worker 在休眠时才唤醒（与 worker_park 的登记/检查配对）
+static void notify_workers(thread_pool_t *pool, worker_t *target) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&pool->idle_workers, memory_order_relaxed) > 0) {
+        wake_worker(pool, target);
+    }
+}
+
+// 投递到 worker 的 inbox
+static int submit_to_worker(thread_pool_t *pool, task_t *task) {
+    worker_t *worker = pick_worker(pool, task);
+    
+    atomic_fetch_add(&pool->pending_tasks, 1);
+    if (task_queue_push(worker->inbox, task) != 0) {
+        atomic_fetch_sub(&pool->pending_tasks, 1);
+        return -1;
     }
     
-    // 释放资源
-    free(pool->threads);
-    task_queue_destroy(pool->task_queue);
-    pthread_mutex_destroy(&pool->stats_mutex);
+    notify_workers(pool, worker);
+    return 0;
+}
+
+// 连接执行器在 worker 上重新排队，不能阻塞：目标 inbox 通常就是本 worker 的，
+// 满时只有本线程能腾出空间。inbox 满时压入本线程的双端队列（其它 worker 可窃取），
+// 都满时返回 -1
+static int requeue_runner(worker_t *worker, task_t *runner) {
+    thread_pool_t *pool = worker->pool;
+    worker_t *target = pick_worker(pool, runner);
     
-    log_info("Thread pool destroyed. Total tasks completed: %ld", pool->tasks_completed);
+    atomic_fetch_add(&pool->pending_tasks, 1);
+    if (task_queue_try_push(target->inbox, runner) != 0 &&
+        ws_deque_push(worker->deque, runner) != 0) {
+        atomic_fetch_sub(&pool->pending_tasks, 1);
+        return -1;
+    }
     
-    free(pool);
+    notify_workers(pool, target);
+    return 0;
 }
 
+// 带连接的任务进入连接邮箱，由连接执行器串行执行；
+// 邮箱由空变为非空的投递方负责调度执行器，其余投递只做一次原子交换和计数
 int thread_pool_submit(thread_pool_t *pool, task_t *task) {
-    if (!pool || !task || pool->shutdown) return -1;
+    if (!pool || !task || atomic_load(&pool->shutdown)) return -1;
     
-    return task_queue_push(pool->task_queue, task);
+    connection_t *conn = task->conn;
+    if (!conn) {
+        return submit_to_worker(pool, task);
+    }
+    
+    mpsc_queue_push(&conn->tasks, &task->node);
+    if (atomic_fetch_add_explicit(&conn->task_pending, 1, memory_order_acq_rel) == 0) {
+        if (submit_to_worker(pool, &conn->runner) != 0) {
+            // 线程池已关闭：连同本任务一起释放邮箱中的任务，并清零 task_pending。
+            // 本任务已入队，视为已接管，不再返回 -1
+            task_destroy(&conn->runner);
+        }
+    }
+    
+    return 0;
 }
 
 void thread_pool_shutdown(thread_pool_t *pool) {
     if (!pool) return;
-    pool->shutdown = 1;
-    task_queue_shutdown(pool->task_queue);
-}
\ No newline at end of file
+    
+    atomic_store(&pool->shutdown, 1);
+    for (int i = 0; i < pool->thread_count; i++) {
+        task_queue_shutdown(pool->workers[i].inbox);
+    }
+    
+    pthread_mutex_lock(&pool->idle_mutex);
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_cond_broadcast(&pool->workers[i].wakeup);
+    }
+    pthread_mutex_unlock(&pool->idle_mutex);
+}
+
+long thread_pool_tasks_completed(thread_pool_t *pool) {
+    if (!pool) return 0;
+    
+    long total = 0;
+    for (int i = 0; i < pool->thread_count; i++) {
+        total += stat_read(&pool->workers[i].tasks_executed);
+    }
+    return total;
+}
+
+void thread_pool_log_stats(thread_pool_t *pool) {
+    if (!pool) return;
+    
+    for (int i = 0; i < pool->thread_count; i++) {
+        worker_t *worker = &pool->workers[i];
+        log_info("Worker %d: executed=%ld stolen=%ld", 
+                worker->index, stat_read(&worker->tasks_executed),
+                stat_read(&worker->tasks_stolen));
+    }
+}
+
+void thread_pool_collect_metrics(void *arg, metrics_out_t *out) {
+    thread_pool_t *pool = (thread_pool_t*)arg;
+    
+    metrics_printf(out, "# HELP reactor_worker_tasks_total Tasks executed by each worker\n"
+                   "# TYPE reactor_worker_tasks_total counter\n");
+    for (int i = 0; i < pool->thread_count; i++) {
+        metrics_printf(out, "reactor_worker_tasks_total{worker=\"%d\"} %ld\n",
+                       i, stat_read(&pool->workers[i].tasks_executed));
+    }
+    
+    metrics_printf(out, "# HELP reactor_worker_steals_total Tasks stolen from other workers\n"
+                   "# TYPE reactor_worker_steals_total counter\n");
+    for (int i = 0; i < pool->thread_count; i++) {
+        metrics_printf(out, "reactor_worker_steals_total{worker=\"%d\"} %ld\n",
+                       i, stat_read(&pool->workers[i].tasks_stolen));
+    }
+    
+    metrics_printf(out, "# HELP reactor_worker_direct_writes_total Responses written directly by each worker\n"
+                   "# TYPE reactor_worker_direct_writes_total counter\n");
+    for (int i = 0; i < pool->thread_count; i++) {
+        metrics_printf(out, "reactor_worker_direct_writes_total{worker=\"%d\"} %ld\n",
+                       i, stat_read(&pool->workers[i].direct_writes));
+    }
+    
+    metrics_printf(out, "# HELP reactor_worker_written_bytes_total Bytes written directly by each worker\n"
+                   "# TYPE reactor_worker_written_bytes_total counter\n");
+    for (int i = 0; i < pool->thread_count; i++) {
+        metrics_printf(out, "reactor_worker_written_bytes_total{worker=\"%d\"} %ld\n",
+                       i, stat_read(&pool->workers[i].direct_bytes));
+    }
+    
+    metrics_printf(out, "# HELP reactor_worker_pending_tasks Tasks submitted but not yet started\n"
+                   "# TYPE reactor_worker_pending_tasks gauge\n"
+                   "reactor_worker_pending_tasks %ld\n", atomic_load(&pool->pending_tasks));
+}
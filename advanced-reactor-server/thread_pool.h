@@ -2,30 +2,76 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
+#include <stdatomic.h>
 #include "common.h"
 #include "task_queue.h"
+#include "ws_deque.h"
+#include "metrics.h"
+#include "cpu_affinity.h"
+
+struct thread_pool;
+
+// 工作线程：IO 线程按亲和性投递到 inbox，worker 批量转入本地双端队列；
+// 空闲的 worker 从其它 worker 的双端队列顶部（及 inbox）窃取任务。
+// 带连接的任务先进入连接自己的邮箱，由连接执行器（TASK_TYPE_SERIAL）按顺序执行，
+// 同一连接的任务同一时刻只在一个 worker 上运行，不同连接之间完全并行
+typedef struct worker {
+    pthread_t thread;
+    int index;
+    struct thread_pool *pool;
+    task_queue_t *inbox;
+    ws_deque_t *deque;
+    unsigned int rand_state;
+    thread_placement_t placement;    // 线程启动时绑定的 CPU
+    atomic_int parked;           // 是否在 wakeup 上休眠
+    pthread_cond_t wakeup;
+    
+    // 统计信息（只由本 worker 写入，独占缓存行）
+    stat_counter_t tasks_executed CACHE_ALIGNED;
+    stat_counter_t tasks_stolen;
+    stat_counter_t direct_writes;    // 直接写出（不经 IO 线程）的响应数
+    stat_counter_t direct_bytes;
+} CACHE_ALIGNED worker_t;
 
 typedef struct thread_pool {
-    pthread_t *threads;
+    // 创建后只读
+    worker_t *workers;
     int thread_count;
-    task_queue_t *task_queue;
-    int shutdown;
+    atomic_int shutdown;
+    
+    // 按 CPU 分组排列的 worker 下标：带连接的任务优先交给与提交线程同组的 worker
+    int group_count;                 // 0 表示未绑定 CPU，不分组
+    int *group_offset;               // 第 g 组为 group_workers[group_offset[g], group_offset[g + 1])
+    int *group_workers;
     
-    // 统计信息
-    long tasks_completed;
-    pthread_mutex_t stats_mutex;
+    // 空闲 worker 休眠/唤醒：提交方和 worker 都会频繁修改，各占一个缓存行
+    atomic_long pending_tasks CACHE_ALIGNED;  // 已提交但尚未开始执行的任务数
+    atomic_int idle_workers CACHE_ALIGNED;
+    atomic_uint next_worker CACHE_ALIGNED;    // 无连接任务的轮询分配
+    pthread_mutex_t idle_mutex;  // 保护各 worker 的 wakeup
 } thread_pool_t;
 
-// 创建线程池
-thread_pool_t* thread_pool_create(int thread_count, int queue_size);
+// 创建线程池（queue_size 为每个 worker inbox 的容量；placement 为每个 worker 的放置，NULL 表示不绑定）
+thread_pool_t* thread_pool_create(int thread_count, int queue_size, task_queue_kind_t queue_kind,
+                                  const thread_placement_t *placement);
 
 // 销毁线程池
 void thread_pool_destroy(thread_pool_t *pool);
 
 // 提交任务到线程池
+// 返回 -1 表示线程池已关闭、任务未被接管，由调用方释放
 int thread_pool_submit(thread_pool_t *pool, task_t *task);
 
 // 关闭线程池
 void thread_pool_shutdown(thread_pool_t *pool);
 
-#endif // THREAD_POOL_H
\ No newline at end of file
+// 汇总所有 worker 已执行的任务数
+long thread_pool_tasks_completed(thread_pool_t *pool);
+
+// 输出每个 worker 的执行/窃取计数
+void thread_pool_log_stats(thread_pool_t *pool);
+
+// /metrics 收集函数（arg 为 thread_pool_t）：各 worker 的执行/窃取计数和排队任务数
+void thread_pool_collect_metrics(void *arg, metrics_out_t *out);
+
+#endif // THREAD_POOL_H
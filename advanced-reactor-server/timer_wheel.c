@@ -0,0 +1,148 @@
+// timer_wheel.c
+#include <string.h>
+#include "timer_wheel.h"
+
+// 最远可表示的 tick 距离，更远的定时器先挂在最高层最后一圈，降级时重新计算
+#define TW_MAX_DELTA ((1ULL << (TW_SLOT_BITS * TW_LEVELS)) - 1)
+
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t tick_ms, uint64_t now_ms) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->tick_ms = tick_ms > 0 ? tick_ms : 1;
+    wheel->current = now_ms / wheel->tick_ms;
+}
+
+void tw_timer_init(tw_timer_t *timer, tw_callback_fn fn, void *arg) {
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->deadline = 0;
+    timer->expire = 0;
+    timer->fn = fn;
+    timer->arg = arg;
+}
+
+static void slot_link(tw_timer_t **head, tw_timer_t *timer) {
+    timer->next = *head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void slot_unlink(tw_timer_t *timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+// 按到期 tick 与当前 tick 的距离选择层和槽位
+static void wheel_insert(timer_wheel_t *wheel, tw_timer_t *timer) {
+    uint64_t expire = timer->expire;
+    if (expire < wheel->current) {
+        expire = wheel->current;
+    }
+    
+    uint64_t delta = expire - wheel->current;
+    if (delta > TW_MAX_DELTA) {
+        delta = TW_MAX_DELTA;
+        expire = wheel->current + delta;
+    }
+    
+    int level = 0;
+    while (level < TW_LEVELS - 1 && delta >= (1ULL << (TW_SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    
+    int slot = (int)((expire >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK);
+    slot_link(&wheel->slots[level][slot], timer);
+}
+
+void timer_wheel_add(timer_wheel_t *wheel, tw_timer_t *timer, uint64_t deadline_ms) {
+    if (timer->pprev) {
+        slot_unlink(timer);
+    } else {
+        wheel->count++;
+    }
+    
+    timer->deadline = deadline_ms;
+    timer->expire = (deadline_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    wheel_insert(wheel, timer);
+}
+
+void timer_wheel_del(timer_wheel_t *wheel, tw_timer_t *timer) {
+    if (!timer->pprev) return;
+    
+    slot_unlink(timer);
+    wheel->count--;
+}
+
+// 把第 level 层当前轮到的槽位整体降级到更低的层
+// 返回该槽位下标，为 0 时说明更高一层也转过了一格
+static int wheel_cascade(timer_wheel_t *wheel, int level) {
+    int slot = (int)((wheel->current >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK);
+    tw_timer_t *timer = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+    
+    while (timer) {
+        tw_timer_t *next = timer->next;
+        timer->next = NULL;
+        timer->pprev = NULL;
+        wheel_insert(wheel, timer);
+        wheel->cascaded++;
+        timer = next;
+    }
+    
+    return slot;
+}
+
+int timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_ms) {
+    uint64_t target = now_ms / wheel->tick_ms;
+    int fired = 0;
+    
+    while (wheel->current <= target) {
+        int slot = (int)(wheel->current & TW_SLOT_MASK);
+        
+        // 第 0 层转完一圈时，从高层依次降级下一段定时器
+        if (slot == 0) {
+            for (int level = 1; level < TW_LEVELS; level++) {
+                if (wheel_cascade(wheel, level) != 0) break;
+            }
+        }
+        
+        // 到期链表先挂到局部表头，回调中摘下其中任意节点都是安全的
+        tw_timer_t *expired = wheel->slots[0][slot];
+        wheel->slots[0][slot] = NULL;
+        if (expired) {
+            expired->pprev = &expired;
+        }
+        wheel->current++;
+        
+        while (expired) {
+            tw_timer_t *timer = expired;
+            slot_unlink(timer);
+            wheel->count--;
+            wheel->expired++;
+            fired++;
+            timer->fn(timer, timer->arg);
+        }
+    }
+    
+    return fired;
+}
+
+long timer_wheel_next_timeout(const timer_wheel_t *wheel, uint64_t now_ms) {
+    if (wheel->count == 0) return -1;
+    
+    uint64_t tick = wheel->current;
+    for (int i = 0; i < TW_SLOTS; i++, tick++) {
+        // 到了降级点，后面的定时器可能还在高层
+        if (i > 0 && (tick & TW_SLOT_MASK) == 0) break;
+        if (wheel->slots[0][tick & TW_SLOT_MASK]) break;
+    }
+    
+    uint64_t at = tick * wheel->tick_ms;
+    return at > now_ms ? (long)(at - now_ms) : 0;
+}
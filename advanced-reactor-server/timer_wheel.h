@@ -0,0 +1,76 @@
+// timer_wheel.h
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <time.h>
+
+// 分层时间轮（每个 IO 线程一个，只由该线程访问，不加锁）
+//
+// 共 TW_LEVELS 层，每层 TW_SLOTS 个槽；第 0 层每槽一个 tick，第 n 层每槽 TW_SLOTS^n 个 tick。
+// 定时器按剩余时间挂入对应层的槽位，高层槽位在轮到时整体降级（cascade）到低层。
+// 添加、重新设置和取消都是 O(1)；推进时只访问到期或需要降级的定时器。
+
+#define TW_LEVELS    4
+#define TW_SLOT_BITS 6
+#define TW_SLOTS     (1 << TW_SLOT_BITS)
+#define TW_SLOT_MASK (TW_SLOTS - 1)
+
+struct tw_timer;
+typedef void (*tw_callback_fn)(struct tw_timer *timer, void *arg);
+
+typedef struct tw_timer {
+    struct tw_timer *next;
+    struct tw_timer **pprev;    // 指向前一个节点的 next（或槽位头），NULL 表示未挂入
+    uint64_t deadline;          // 到期时间（毫秒）
+    uint64_t expire;            // 到期 tick
+    tw_callback_fn fn;
+    void *arg;
+} tw_timer_t;
+
+typedef struct timer_wheel {
+    uint64_t tick_ms;
+    uint64_t current;           // 下一个待处理的 tick
+    long count;                 // 已挂入的定时器数
+    
+    // 统计信息
+    long expired;
+    long cascaded;
+    
+    tw_timer_t *slots[TW_LEVELS][TW_SLOTS];
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t tick_ms, uint64_t now_ms);
+
+void tw_timer_init(tw_timer_t *timer, tw_callback_fn fn, void *arg);
+
+// 设置定时器在 deadline_ms 到期（已挂入时先摘下，即重新设置）
+void timer_wheel_add(timer_wheel_t *wheel, tw_timer_t *timer, uint64_t deadline_ms);
+
+// 取消定时器（未挂入时什么也不做）
+void timer_wheel_del(timer_wheel_t *wheel, tw_timer_t *timer);
+
+// 推进到 now_ms，执行所有到期定时器的回调；返回执行的回调数
+// 回调中可以重新设置或取消任意定时器
+int timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_ms);
+
+// 距下一次需要推进的时间（毫秒），没有定时器时返回 -1
+// 只看第 0 层到下一次降级为止：降级点本身也算一次需要推进的时刻
+long timer_wheel_next_timeout(const timer_wheel_t *wheel, uint64_t now_ms);
+
+static inline int tw_timer_pending(const tw_timer_t *timer) {
+    return timer->pprev != NULL;
+}
+
+// 粗粒度单调时钟（毫秒）：Linux 上走 vDSO，不陷入内核
+static inline uint64_t clock_now_ms(void) {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,97 @@
+// ws_deque.c
+// 参考 "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al., PPoPP'13)
+#include "ws_deque.h"
+
+ws_deque_t* ws_deque_create(long capacity) {
+    ws_deque_t *deque = (ws_deque_t*)malloc(sizeof(ws_deque_t));
+    if (!deque) return NULL;
+    
+    long size = 2;
+    while (size < capacity) size <<= 1;
+    
+    deque->buffer = malloc(sizeof(*deque->buffer) * size);
+    if (!deque->buffer) {
+        free(deque);
+        return NULL;
+    }
+    for (long i = 0; i < size; i++) {
+        atomic_init(&deque->buffer[i], NULL);
+    }
+    
+    deque->mask = size - 1;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    
+    return deque;
+}
+
+void ws_deque_destroy(ws_deque_t *deque) {
+    if (!deque) return;
+    
+    free(deque->buffer);
+    free(deque);
+}
+
+int ws_deque_push(ws_deque_t *deque, task_t *task) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    
+    if (b - t > deque->mask) {
+        return -1;  // 满
+    }
+    
+    atomic_store_explicit(&deque->buffer[b & deque->mask], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}
+
+task_t* ws_deque_take(ws_deque_t *deque) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    
+    task_t *task = NULL;
+    if (t <= b) {
+        task = atomic_load_explicit(&deque->buffer[b & deque->mask], memory_order_relaxed);
+        if (t == b) {
+            // 只剩最后一个元素，与窃取者竞争
+            if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                         memory_order_seq_cst,
+                                                         memory_order_relaxed)) {
+                task = NULL;
+            }
+            atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    
+    return task;
+}
+
+task_t* ws_deque_steal(ws_deque_t *deque) {
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    
+    if (t >= b) {
+        return NULL;  // 空
+    }
+    
+    task_t *task = atomic_load_explicit(&deque->buffer[t & deque->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL;  // 被其它线程抢先
+    }
+    
+    return task;
+}
+
+long ws_deque_size(ws_deque_t *deque) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    return b > t ? b - t : 0;
+}
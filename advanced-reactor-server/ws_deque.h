@@ -0,0 +1,37 @@
+// ws_deque.h
+#ifndef WS_DEQUE_H
+#define WS_DEQUE_H
+
+#include <stdatomic.h>
+#include "common.h"
+
+// Chase-Lev 工作窃取双端队列（固定容量）
+// 所有者在底部 push/take，其它线程从顶部 steal
+typedef struct ws_deque {
+    atomic_long top;
+    char pad0[CACHE_LINE_SIZE - sizeof(atomic_long)];
+    atomic_long bottom;
+    char pad1[CACHE_LINE_SIZE - sizeof(atomic_long)];
+    _Atomic(task_t*) *buffer;
+    long mask;
+} ws_deque_t;
+
+// 创建双端队列（容量向上取整到 2 的幂）
+ws_deque_t* ws_deque_create(long capacity);
+
+// 销毁双端队列（不释放其中的任务）
+void ws_deque_destroy(ws_deque_t *deque);
+
+// 所有者：压入底部，满时返回 -1
+int ws_deque_push(ws_deque_t *deque, task_t *task);
+
+// 所有者：从底部取出，空时返回 NULL
+task_t* ws_deque_take(ws_deque_t *deque);
+
+// 窃取者：从顶部取出，空或竞争失败时返回 NULL
+task_t* ws_deque_steal(ws_deque_t *deque);
+
+// 当前元素个数（近似值）
+long ws_deque_size(ws_deque_t *deque);
+
+#endif // WS_DEQUE_H